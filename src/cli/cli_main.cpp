@@ -94,6 +94,14 @@ bool run_script_file(String const& filename) {
   return true;
 }
 
+#if USE_SCRIPT_PROFILING
+  void show_profile_counters() {
+    FOR_EACH_CONST(c, profile_counters()) {
+      cli << String::Format(_("%10d  %s"), (int)c->get(), c->name) << ENDL;
+    }
+  }
+#endif
+
 void CLISetInterface::run() {
   // show welcome logo
   if (!quiet) showWelcome();
@@ -136,6 +144,10 @@ void CLISetInterface::showUsage() {
   cli << _("   :pwd                Print the current working directory.\n");
   cli << _("   :cd                 Change the working directory.\n");
   cli << _("   :! <command>        Perform a shell command.\n");
+  cli << _("   :profile start      Start recording a trace of script functions and field updates.\n");
+  cli << _("   :profile stop       Stop recording the trace.\n");
+  cli << _("   :profile trace <file>\n");
+  cli << _("                       Write the recorded trace as Chrome trace JSON (for chrome://tracing or Perfetto).\n");
   cli << _("\n Commands can be abreviated to their first letter if there is no ambiguity.\n\n");
 }
 
@@ -202,16 +214,8 @@ void CLISetInterface::handleCommand(const String& command) {
             system(arg.c_str());
           #endif
         }
-      #if USE_SCRIPT_PROFILING
-        } else if (before == _(":profile")) {
-          if (arg == _("full")) {
-            showProfilingStats(profile_root);
-          } else {
-            long level = 1;
-            arg.ToLong(&level);
-            showProfilingStats(profile_aggregated(level));
-          }
-      #endif
+      } else if (before == _(":profile")) {
+        handleProfileCommand(arg);
       } else {
         cli.show_message(MESSAGE_ERROR,_("Unknown command, type :help for help."));
       }
@@ -239,6 +243,37 @@ void CLISetInterface::handleCommand(const String& command) {
   }
 }
 
+void CLISetInterface::handleProfileCommand(const String& arg) {
+  if (arg == _("start")) {
+    start_tracing();
+    cli << _("Recording trace") << ENDL;
+  } else if (arg == _("stop")) {
+    stop_tracing();
+    cli << _("Stopped recording trace") << ENDL;
+  } else if (starts_with(arg, _("trace"))) {
+    String filename = trim(arg.substr(5));
+    if (filename.empty()) {
+      cli.show_message(MESSAGE_ERROR,_("Give a filename to write the trace to."));
+    } else {
+      size_t count = write_trace(filename);
+      cli << String::Format(_("Wrote %d trace events to "), (int)count) << filename << ENDL;
+    }
+  #if USE_SCRIPT_PROFILING
+    } else if (arg == _("full")) {
+      showProfilingStats(profile_root);
+    } else if (arg == _("counters")) {
+      show_profile_counters();
+    } else {
+      long level = 1;
+      arg.ToLong(&level);
+      showProfilingStats(profile_aggregated(level));
+  #else
+    } else {
+      cli.show_message(MESSAGE_ERROR,_("Unknown profile command, use start, stop or trace <file>."));
+  #endif
+  }
+}
+
 #if USE_SCRIPT_PROFILING
   void CLISetInterface::showProfilingStats(const FunctionProfile& item, int level) {
     // show parent
@@ -31,6 +31,7 @@ private:
   void showWelcome();
   void showUsage();
   void handleCommand(const String& command);
+  void handleProfileCommand(const String& arg);
   #if USE_SCRIPT_PROFILING
     void showProfilingStats(const FunctionProfile& parent, int level = 0);
   #endif
@@ -47,3 +48,8 @@ private:
 
 bool run_script_file(String const& filename);
 
+#if USE_SCRIPT_PROFILING
+  /// Show the values of all ProfileCounters
+  void show_profile_counters();
+#endif
+
@@ -0,0 +1,245 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <util/error.hpp>
+#include <util/io/package_manager.hpp>
+#include <cli/server.hpp>
+#include <script/json.hpp>
+#include <script/to_value.hpp>
+#include <script/profiler.hpp>
+#include <script/functions/functions.hpp>
+#include <data/game.hpp>
+#include <data/format/formats.hpp>
+#include <wx/filename.h>
+
+ScriptValueP export_set(SetP const& set, vector<CardP> const& cards, ExportTemplateP const& exp, String const& outname);
+
+// ----------------------------------------------------------------------------- : Parameters
+
+/// Get a parameter, returns nullptr if it is not given
+ScriptValueP get_param(const ScriptCustomCollection& params, const String& name) {
+  map<String,ScriptValueP>::const_iterator it = params.key_value.find(name);
+  if (it == params.key_value.end() || it->second->type() == SCRIPT_NIL) return ScriptValueP();
+  return it->second;
+}
+
+String get_string_param(const ScriptCustomCollection& params, const String& name, bool required = true) {
+  ScriptValueP value = get_param(params, name);
+  if (!value) {
+    if (required) throw Error(_("Missing parameter: ") + name);
+    return String();
+  }
+  return value->toString();
+}
+
+/// Read a line of UTF-8 text from stdin, returns false at the end of the input
+bool read_utf8_stdin_line(String& line) {
+  std::string buffer;
+  char chunk[4096];
+  while (fgets(chunk, sizeof(chunk), stdin)) {
+    buffer += chunk;
+    if (!buffer.empty() && buffer.back() == '\n') break;
+  }
+  if (buffer.empty()) return false;
+  while (!buffer.empty() && (buffer.back() == '\n' || buffer.back() == '\r')) buffer.pop_back();
+  line = String::FromUTF8(buffer.data(), buffer.size());
+  return true;
+}
+
+// ----------------------------------------------------------------------------- : CLIServer
+
+CLIServer::CLIServer()
+  : running(false)
+  , load_time(0)
+{
+  ei.allow_writes_outside = true;
+  ei.directory_relative = ei.directory_absolute = wxGetCwd();
+  ei.export_template = make_intrusive<Package>();
+  ei.export_template->open(ei.directory_absolute, true);
+}
+
+void CLIServer::run() {
+  // messages are returned with the responses, instead of being written to the console
+  write_errors_to_cli = false;
+  running = true;
+  String line;
+  while (running && read_utf8_stdin_line(line)) {
+    if (trim(line).empty()) continue;
+    std::string response = handleRequest(line);
+    response += '\n';
+    fputs(response.c_str(), stdout);
+    fflush(stdout);
+  }
+}
+
+std::string CLIServer::handleRequest(const String& line) {
+  int64_t start = trace_clock();
+  load_time = 0;
+  ScriptValueP id = script_nil;
+  std::string result; // as JSON
+  bool ok = false;
+  String error;
+  try {
+    ScriptValueP request = parse_json(line);
+    ScriptCustomCollection* request_obj = dynamic_cast<ScriptCustomCollection*>(request.get());
+    if (!request_obj) throw Error(_("A request must be a JSON object"));
+    if (ScriptValueP request_id = get_param(*request_obj, _("id"))) id = request_id;
+    String method = get_string_param(*request_obj, _("method"));
+    ScriptValueP params = get_param(*request_obj, _("params"));
+    ScriptCustomCollection* params_obj = dynamic_cast<ScriptCustomCollection*>(params.get());
+    if (params && !params_obj) throw Error(_("The params of a request must be a JSON object"));
+    ScriptCustomCollectionP no_params;
+    if (!params_obj) {
+      no_params = make_intrusive<ScriptCustomCollection>();
+      params_obj = no_params.get();
+    }
+    TraceScope trace(_("server request"));
+    write_json(result, call(method, *params_obj));
+    ok = true;
+  } catch (const Error& e) {
+    error = e.what();
+  } catch (const std::exception& e) {
+    // not thrown by us, but it shouldn't stop the server
+    error = String(e.what(), IF_UNICODE(wxConvLocal, wxSTRING_MAXLEN));
+  } catch (...) {
+    error = _("An unexpected exception occurred!");
+  }
+  // response
+  std::string out = "{\"id\":";
+  write_json(out, id);
+  if (ok) {
+    out += ",\"result\":";
+    out += result;
+  } else {
+    out += ",\"error\":{\"message\":";
+    write_json_string(out, error);
+    out += "}";
+  }
+  // messages, they are queued in reverse order
+  vector<pair<MessageType,String>> messages;
+  MessageType type;
+  String message;
+  while (get_queued_message(type, message)) {
+    messages.push_back(make_pair(type, message));
+  }
+  out += ",\"messages\":[";
+  for (size_t i = messages.size() ; i > 0 ; --i) {
+    MessageType t = messages[i-1].first;
+    out += "{\"type\":";
+    write_json_string(out, t == MESSAGE_INFO ? _("info") : t == MESSAGE_WARNING ? _("warning") : _("error"));
+    out += ",\"message\":";
+    write_json_string(out, messages[i-1].second);
+    out += i > 1 ? "}," : "}";
+  }
+  out += "]";
+  // timing
+  out += ",\"time\":{\"total_ms\":";
+  write_json_number(out, (trace_clock() - start) / 1e6);
+  out += ",\"load_ms\":";
+  write_json_number(out, load_time / 1e6);
+  out += "}}";
+  return out;
+}
+
+SetP CLIServer::getSet(const ScriptCustomCollection& params, bool* was_loaded) {
+  wxFileName fn(get_string_param(params, _("set")));
+  fn.MakeAbsolute();
+  String filename = fn.GetFullPath();
+  time_t modified = wxFileModificationTime(filename);
+  // is the set already loaded, and up to date?
+  map<String,LoadedSet>::iterator it = sets.find(filename);
+  if (it != sets.end() && it->second.modified == modified) {
+    if (was_loaded) *was_loaded = false;
+    return it->second.set;
+  }
+  // load it
+  int64_t start = trace_clock();
+  SetP set = import_set(filename);
+  LoadedSet& loaded = sets[filename];
+  loaded.set = set;
+  loaded.modified = modified;
+  load_time += trace_clock() - start;
+  if (was_loaded) *was_loaded = true;
+  return set;
+}
+
+ScriptValueP CLIServer::call(const String& method, const ScriptCustomCollection& params) {
+  ScriptCustomCollectionP result = make_intrusive<JsonObject>();
+  if (method == _("load_set")) {
+    bool was_loaded;
+    SetP set = getSet(params, &was_loaded);
+    result->key_value[_("name")]     = to_script(set->identification());
+    result->key_value[_("game")]     = to_script(set->game->name());
+    result->key_value[_("cards")]    = to_script((int)set->cards.size());
+    result->key_value[_("reloaded")] = to_script(was_loaded);
+  } else if (method == _("unload_set")) {
+    wxFileName fn(get_string_param(params, _("set")));
+    fn.MakeAbsolute();
+    result->key_value[_("unloaded")] = to_script(sets.erase(fn.GetFullPath()) > 0);
+  } else if (method == _("eval")) {
+    String code = get_string_param(params, _("script"));
+    SetP set = get_param(params, _("set")) ? getSet(params) : SetP();
+    // parse
+    vector<ScriptParseError> errors;
+    ScriptP script = parse(code, nullptr, false, errors);
+    if (!errors.empty()) {
+      String message;
+      FOR_EACH(error, errors) {
+        if (!message.empty()) message += _("\n");
+        message += error.what();
+      }
+      throw ScriptError(message);
+    }
+    // evaluate, variables don't survive between requests
+    ExportInfo info = ei;
+    info.set = set;
+    WITH_DYNAMIC_ARG(export_info, &info);
+    unique_ptr<Context> own_context;
+    if (!set) {
+      own_context = make_unique<Context>();
+      init_script_functions(*own_context);
+    }
+    Context& ctx = set ? set->getContext() : *own_context;
+    LocalScope scope(ctx);
+    if (ScriptValueP variables = get_param(params, _("variables"))) {
+      ScriptCustomCollection* vars = dynamic_cast<ScriptCustomCollection*>(variables.get());
+      if (!vars) throw Error(_("The variables must be a JSON object"));
+      FOR_EACH_CONST(v, vars->key_value) {
+        ctx.setVariable(v.first, v.second);
+      }
+    }
+    return ctx.eval(*script, false);
+  } else if (method == _("export_images")) {
+    SetP set = getSet(params);
+    int jobs = 1;
+    if (ScriptValueP j = get_param(params, _("jobs"))) jobs = max(1, j->toInt());
+    int64_t start = trace_clock();
+    size_t count = export_images(set, get_string_param(params, _("file"), false), jobs);
+    result->key_value[_("images")] = to_script((int)count);
+    result->key_value[_("export_ms")] = to_script((trace_clock() - start) / 1e6);
+  } else if (method == _("export")) {
+    ExportTemplateP exp = ExportTemplate::byName(get_string_param(params, _("template")));
+    SetP set = getSet(params);
+    String out = get_string_param(params, _("out"), false);
+    ScriptValueP value = export_set(set, set->cards, exp, out);
+    if (out.empty()) {
+      result->key_value[_("output")] = to_script(value->toString());
+    }
+  } else if (method == _("reload_packages")) {
+    // the sets refer to the old games and stylesheets, so they have to be loaded again as well
+    result->key_value[_("unloaded_sets")] = to_script((int)sets.size());
+    sets.clear();
+    package_manager.reset();
+  } else if (method == _("shutdown")) {
+    running = false;
+  } else {
+    throw Error(_("Unknown method: ") + method);
+  }
+  return result;
+}
@@ -0,0 +1,67 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <data/set.hpp>
+#include <data/export_template.hpp>
+#include <script/value.hpp>
+
+class ScriptCustomCollection;
+
+// ----------------------------------------------------------------------------- : Batch server
+
+/// A server for other programs, that reads requests from stdin and writes responses to stdout
+/** Sets, games and stylesheets stay loaded between requests,
+ *  so a batch of sets can be exported without starting MSE for each one.
+ *
+ *  Every request and response is a JSON object on a single line, in the style of JSON-RPC:
+ *    {"id":1, "method":"export_images", "params":{"set":"my.mse-set", "file":"out/{card.name}.png"}}
+ *  gives
+ *    {"id":1, "result":{...}, "messages":[...], "time":{"total_ms":..., "load_ms":...}}
+ *  or, if the request failed
+ *    {"id":1, "error":{"message":"..."}, "messages":[...], "time":{...}}
+ *  Warnings that occur while handling a request are included in "messages".
+ *
+ *  Methods:
+ *    load_set        {set}                            Load a set, or check that it is still up to date
+ *    unload_set      {set}                            Forget a loaded set
+ *    eval            {script, [set], [variables]}     Evaluate a script, in the context of a set if given
+ *    export_images   {set, [file], [jobs]}            Export card images, like --export-images
+ *    export          {template, set, [out]}           Export with an export template, like --export
+ *    reload_packages {}                               Reload all packages and sets, after packages are changed on disk
+ *    shutdown        {}                               Stop the server
+ *
+ *  Sets are given by filename, they are reloaded when the file has changed since it was loaded.
+ */
+class CLIServer {
+public:
+  CLIServer();
+  /// Handle requests until stdin is closed or a shutdown request is received
+  void run();
+
+private:
+  /// A set that stays loaded
+  struct LoadedSet {
+    SetP   set;
+    time_t modified; ///< Modification time of the file when it was loaded
+  };
+  map<String,LoadedSet> sets; ///< Loaded sets, by absolute filename
+  bool running;
+  int64_t load_time;          ///< Time spent loading sets in the current request, in ns
+  ExportInfo ei;              ///< Export info for scripts, reads and writes are relative to the working directory
+
+  /// Handle a single request, returns the response
+  std::string handleRequest(const String& line);
+  /// Perform a method call
+  ScriptValueP call(const String& method, const ScriptCustomCollection& params);
+
+  /// Get the set given by the "set" parameter, loading it if needed
+  SetP getSet(const ScriptCustomCollection& params, bool* was_loaded = nullptr);
+};
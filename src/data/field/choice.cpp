@@ -295,7 +295,7 @@ bool ChoiceValue::update(Context& ctx) {
 }
 
 IMPLEMENT_REFLECTION_NAMELESS(ChoiceValue) {
-  if (fieldP->save_value || !handler.isWriting) REFLECT_NAMELESS(value);
+  if (fieldP->save_value || !handler.isWriting || writing_value_cache()) REFLECT_NAMELESS(value);
 }
 
 INSTANTIATE_REFLECTION_NAMELESS(ChoiceValue)
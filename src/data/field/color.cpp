@@ -103,5 +103,5 @@ bool ColorValue::update(Context& ctx) {
 }
 
 IMPLEMENT_REFLECTION_NAMELESS(ColorValue) {
-  if (fieldP->save_value || !handler.isWriting) REFLECT_NAMELESS(value);
+  if (fieldP->save_value || !handler.isWriting || writing_value_cache()) REFLECT_NAMELESS(value);
 }
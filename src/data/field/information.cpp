@@ -71,5 +71,6 @@ bool InfoValue::update(Context& ctx) {
 }
 
 IMPLEMENT_REFLECTION_NAMELESS(InfoValue) {
-  // never save
+  // never save, except in the value cache
+  if (handler.isReading || (handler.isWriting && writing_value_cache())) REFLECT_NAMELESS(value);
 }
@@ -183,7 +183,7 @@ bool TextValue::update(Context& ctx) {
 }
 
 IMPLEMENT_REFLECTION_NAMELESS(TextValue) {
-  if (fieldP->save_value || !handler.isWriting) REFLECT_NAMELESS(value);
+  if (fieldP->save_value || !handler.isWriting || writing_value_cache()) REFLECT_NAMELESS(value);
 }
 
 // ----------------------------------------------------------------------------- : FakeTextValue
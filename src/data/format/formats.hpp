@@ -92,8 +92,18 @@ FileFormatP mtg_editor_file_format();
 void export_images(Window* parent, const SetP& set);
 
 /// Export the image for each card in a list of cards
-void export_images(const SetP& set, const vector<CardP>& cards,
-                   const String& path, const String& filename_template, FilenameConflicts conflicts);
+/** If jobs > 1, then the images are encoded and written to disk by that many worker threads.
+ *  Returns the number of images written.
+ */
+size_t export_images(const SetP& set, const vector<CardP>& cards,
+                     const String& path, const String& filename_template, FilenameConflicts conflicts,
+                     int jobs = 1);
+
+/// Export the image for each card in a set, as on the command line
+/** filename is a filename template, optionally preceded by a directory.
+ *  If it is empty, the filename from the game settings is used.
+ */
+size_t export_images(const SetP& set, const String& filename, int jobs = 1);
 
 /// Export the image of a single card
 void export_image(const SetP& set, const CardP& card, const String& filename);
@@ -101,6 +111,12 @@ void export_image(const SetP& set, const CardP& card, const String& filename);
 /// Generate a bitmap image of a card
 Bitmap export_bitmap(const SetP& set, const CardP& card);
 
+/// Generate an image of a card, using our own rasterizer instead of a DC
+/** Not used for exports yet: text is still drawn by the platform font engine through a memory DC,
+ *  so the result can differ from export_bitmap.
+ */
+Image export_card_image(const SetP& set, const CardP& card);
+
 /// Export a set to Magic Workstation format
 void export_mws(Window* parent, const SetP& set);
 
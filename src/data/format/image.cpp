@@ -10,11 +10,15 @@
 #include <util/tagged_string.hpp>
 #include <data/format/formats.hpp>
 #include <data/set.hpp>
+#include <data/game.hpp>
 #include <data/card.hpp>
 #include <data/stylesheet.hpp>
 #include <data/settings.hpp>
 #include <render/card/viewer.hpp>
+#include <gfx/raster.hpp>
 #include <wx/filename.h>
+#include <wx/thread.h>
+#include <algorithm>
 
 // ----------------------------------------------------------------------------- : Single card export
 
@@ -63,19 +67,146 @@ Bitmap export_bitmap(const SetP& set, const CardP& card) {
   return bitmap;
 }
 
-// ----------------------------------------------------------------------------- : Multiple card export
+Image export_card_image(const SetP& set, const CardP& card) {
+  if (!set) throw Error(_("no set"));
+  // create viewer
+  UnzoomedDataViewer viewer(!settings.stylesheetSettingsFor(set->stylesheetFor(card)).card_normal_export());
+  viewer.setSet(set);
+  viewer.setCard(card);
+  // size of cards
+  RealSize size = viewer.getRotation().getExternalSize();
+  // draw
+  RasterCanvas canvas((int) size.width, (int) size.height);
+  viewer.draw(canvas);
+  Image img = canvas.getImage();
+  // don't write an alpha channel if it is not needed, the same as with export_bitmap
+  const Byte* alpha = img.GetAlpha();
+  size_t count = (size_t)img.GetWidth() * img.GetHeight();
+  if (all_of(alpha, alpha + count, [](Byte a) { return a == 255; })) {
+    img.ClearAlpha();
+  }
+  return img;
+}
+
+// ----------------------------------------------------------------------------- : ImageWriterPool
+
+/// Encodes and writes exported card images on a pool of worker threads
+/** Rendering a card uses wx drawing functions and the script context of the set,
+ *  so that has to stay on the main thread.
+ *  Encoding an Image as PNG/JPEG and writing it to disk does not touch either, so that is done by the workers.
+ *  The queue is bounded, so rendering can not run too far ahead of writing.
+ */
+class ImageWriterPool {
+public:
+  ImageWriterPool(int jobs);
+  /// Waits for all queued images to be written
+  ~ImageWriterPool();
+  
+  /// Queue an image to be written, blocks while the queue is full
+  void write(unique_ptr<Image>&& image, const String& filename);
+  
+private:
+  class Worker;
+  wxMutex     mutex;
+  wxCondition not_full;  ///< Signaled when an image is taken from the queue
+  wxCondition not_empty; ///< Signaled when an image is added to the queue, or when we are done
+  deque<pair<unique_ptr<Image>,String>> queue; ///< Images that still need to be written
+  size_t max_queue_size;
+  bool done = false;
+  vector<Worker*> workers;
+};
+
+class ImageWriterPool::Worker : public wxThread {
+public:
+  Worker(ImageWriterPool& pool)
+    : wxThread(wxTHREAD_JOINABLE), pool(pool)
+  {}
+  ExitCode Entry() override;
+private:
+  ImageWriterPool& pool;
+};
 
+wxThread::ExitCode ImageWriterPool::Worker::Entry() {
+  while (true) {
+    // get an image
+    unique_ptr<Image> image;
+    String filename;
+    {
+      wxMutexLocker lock(pool.mutex);
+      while (pool.queue.empty()) {
+        if (pool.done) return 0;
+        pool.not_empty.Wait();
+      }
+      image    = move(pool.queue.front().first);
+      filename = pool.queue.front().second;
+      pool.queue.pop_front();
+      pool.not_full.Signal();
+    }
+    // write it
+    image->SaveFile(filename); // image.saveFile determines the file type from the extension
+  }
+}
 
-void export_images(const SetP& set, const vector<CardP>& cards,
-                   const String& path, const String& filename_template, FilenameConflicts conflicts)
+ImageWriterPool::ImageWriterPool(int jobs)
+  : not_full(mutex), not_empty(mutex)
+  , max_queue_size(2 * jobs)
+{
+  for (int i = 0 ; i < jobs ; ++i) {
+    Worker* worker = new Worker(*this);
+    if (worker->Create() != wxTHREAD_NO_ERROR || worker->Run() != wxTHREAD_NO_ERROR) {
+      delete worker;
+      break;
+    }
+    workers.push_back(worker);
+  }
+}
+
+ImageWriterPool::~ImageWriterPool() {
+  {
+    wxMutexLocker lock(mutex);
+    done = true;
+    not_empty.Broadcast();
+  }
+  FOR_EACH(worker, workers) {
+    worker->Wait();
+    delete worker;
+  }
+  // if no workers could be started, write the remaining images ourselves
+  FOR_EACH(q, queue) {
+    q.first->SaveFile(q.second);
+  }
+}
+
+void ImageWriterPool::write(unique_ptr<Image>&& image, const String& filename) {
+  if (workers.empty()) {
+    image->SaveFile(filename);
+    return;
+  }
+  wxMutexLocker lock(mutex);
+  while (queue.size() >= max_queue_size) {
+    not_full.Wait();
+  }
+  queue.emplace_back(move(image), filename);
+  not_empty.Signal();
+}
+
+// ----------------------------------------------------------------------------- : Multiple card export
+
+size_t export_images(const SetP& set, const vector<CardP>& cards,
+                     const String& path, const String& filename_template, FilenameConflicts conflicts,
+                     int jobs)
 {
   wxBusyCursor busy;
   // Script
   ScriptP filename_script = parse(filename_template, nullptr, true);
   // Path
   wxFileName fn(path);
+  // Writer threads, these are only used when there is more than one job
+  unique_ptr<ImageWriterPool> writer;
+  if (jobs > 1) writer = make_unique<ImageWriterPool>(jobs);
   // Export
   std::set<String> used; // for CONFLICT_NUMBER_OVERWRITE
+  size_t count = 0;
   FOR_EACH_CONST(card, cards) {
     // filename for this card
     Context& ctx = set->getContext(card);
@@ -88,6 +219,32 @@ void export_images(const SetP& set, const vector<CardP>& cards,
     // write image
     filename = fn.GetFullPath();
     used.insert(filename);
-    export_image(set, card, filename);
+    if (writer) {
+      // Note: the image must not share its data with an object on this thread,
+      //       since wx reference counting is not thread safe
+      unique_ptr<Image> img = make_unique<Image>(export_bitmap(set, card).ConvertToImage());
+      writer->write(move(img), filename);
+    } else {
+      export_image(set, card, filename);
+    }
+    ++count;
+  }
+  return count;
+}
+
+size_t export_images(const SetP& set, const String& filename, int jobs) {
+  String out = filename;
+  if (out.empty()) {
+    out = settings.gameSettingsFor(*set->game).images_export_filename;
+  }
+  // split into directory and filename template
+  String path = _(".");
+  size_t pos = out.find_last_of(_("/\\"));
+  if (pos != String::npos) {
+    path = out.substr(0, pos);
+    if (!wxDirExists(path)) wxMkdir(path);
+    path += _("/x");
+    out = out.substr(pos + 1);
   }
+  return export_images(set, set->cards, path, out, CONFLICT_NUMBER_OVERWRITE, jobs);
 }
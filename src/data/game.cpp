@@ -74,6 +74,9 @@ void Game::validate(Version v) {
       }
     }
     statistics_dimensions.insert(statistics_dimensions.begin(), dims.begin(), dims.end()); // push front
+    for (size_t i = 0 ; i < statistics_dimensions.size() ; ++i) {
+      statistics_dimensions[i]->index = i;
+    }
   }
   // automatic statistics categories
   {
@@ -10,9 +10,7 @@
 #include <data/keyword.hpp>
 #include <util/tagged_string.hpp>
 #include <unordered_map>
-#include <unordered_set>
 
-class KeywordTrie;
 DECLARE_POINTER_TYPE(KeywordParamValue);
 class Value;
 DECLARE_DYNAMIC_ARG(Value*, value_being_updated);
@@ -208,103 +206,56 @@ void Keyword::prepare(const vector<KeywordParamP>& param_types, bool force) {
   valid = !match_re.matches(_(""));
 }
 
-// ----------------------------------------------------------------------------- : KeywordTrie
+// ----------------------------------------------------------------------------- : KeywordAutomaton
 
-namespace std {
-  template <> struct hash<wxUniChar> {
-    inline size_t operator () (wxUniChar x) const {
-      return std::hash<wxUniChar::value_type>()(x.GetValue());
-    }
-  };
-}
-
-/// A node in a trie to match keywords
-/* The trie is used to speed up matching, by quickly finding candidate keywords.
-*/
-class KeywordTrie {
+/// An Aho-Corasick automaton to quickly find candidate keywords
+/* Each keyword is a candidate when the first piece of literal text of its match string occurs in the input.
+ * The parameters of a keyword can match anything, so they are wildcards.
+ * The literal text after the first parameter does not need to be checked here, this is only an optimization to
+ * not have to match lots of regexes. As an added bonus, we get a better behaviour of matching earlier keywords first.
+ * Keywords without literal text are always candidates.
+ *
+ * The automaton is stored in flat arrays, so matching doesn't allocate memory.
+ */
+class KeywordAutomaton {
 public:
-  KeywordTrie();
-  ~KeywordTrie();
+  /// Add a keyword, compile() must be called before matching
+  void add(const Keyword& kw);
+  /// Build the automaton for all added keywords
+  void compile();
   
-  unordered_map<wxUniChar, unique_ptr<KeywordTrie>> children; ///< children after a given character
-  KeywordTrie* on_any_star; ///< children on /.*/ (owned or this)
-  vector<const Keyword*> finished; ///< keywords that end in this node
+  /// Find the keywords that can possibly match in a string, in the order they were added
+  void candidates(const String& untagged, vector<const Keyword*>& out) const;
   
-  /// Insert nodes representing the given character
-  /** return the node where the evaluation will be after matching the character */
-  KeywordTrie* insert(wxUniChar match);
-  /// Insert nodes representing the given string
-  /** return the node where the evaluation will be after matching the string */
-  KeywordTrie* insert(const String& match);
-
-  /// Insert nodes representing the regex /.*/
-  /** return the node where the evaluation will be after matching that regex */
-  KeywordTrie* insertAnyStar();
-};
-
-
-KeywordTrie::KeywordTrie()
-  : on_any_star(nullptr)
-{}
-KeywordTrie::~KeywordTrie() {
-  if (on_any_star != this) delete on_any_star;
-}
-
-KeywordTrie* KeywordTrie::insert(wxUniChar c) {
-  #if USE_CASE_INSENSITIVE_KEYWORDS
-    c = toLower(c); // case insensitive matching
-  #endif
-  unique_ptr<KeywordTrie>& child = children[c];
-  if (!child) child.reset(new KeywordTrie);
-  return child.get();
-}
-KeywordTrie* KeywordTrie::insert(const String& match) {
-  KeywordTrie* cur = this;
-  for (wxUniChar c : match) {
-    cur = cur->insert(c);
-  }
-  return cur;
-}
-
-KeywordTrie* KeywordTrie::insertAnyStar() {
-  if (!on_any_star) on_any_star = new KeywordTrie();
-  on_any_star->on_any_star = on_any_star; // circular reference to itself
-  return on_any_star;
-}
-
-
-// ----------------------------------------------------------------------------- : KeywordDatabase
-
-IMPLEMENT_DYNAMIC_ARG(KeywordUsageStatistics*, keyword_usage_statistics, nullptr);
-
-KeywordDatabase::KeywordDatabase()
-  : root(nullptr)
-{}
-// Note: has to be here because in the header KeywordTrie is not defined
-KeywordDatabase::~KeywordDatabase() {}
-
-void KeywordDatabase::clear() {
-  root.reset();
-}
-
-void KeywordDatabase::add(const vector<KeywordP>& kws) {
-  FOR_EACH_CONST(kw, kws) {
-    add(*kw);
+private:
+  vector<pair<String,const Keyword*>> patterns; ///< literal text (lowercase) for each keyword
+  
+  struct Edge {
+    wxUniChar c;
+    int       target;
+  };
+  struct Node {
+    int edges_begin, edges_end;     ///< outgoing edges, sorted by character
+    int fail;                       ///< node for the longest proper suffix that is also in the trie
+    int outputs_begin, outputs_end; ///< patterns that end here, including those of the fail node
+  };
+  vector<Node> nodes;  ///< nodes[0] is the root
+  vector<Edge> edges;
+  vector<int>  outputs; ///< indices in patterns
+  
+  /// Follow the edge for c from a node, or return -1
+  inline int child(int node, wxUniChar c) const {
+    const Edge* begin = edges.data() + nodes[node].edges_begin;
+    const Edge* end   = edges.data() + nodes[node].edges_end;
+    const Edge* it = lower_bound(begin, end, c, [](const Edge& e, wxUniChar c) { return e.c < c; });
+    return it != end && it->c == c ? it->target : -1;
   }
-}
+};
 
-void KeywordDatabase::add(const Keyword& kw) {
-  if (kw.match.empty() || !kw.valid) return; // can't handle empty keywords
-  // Create root
-  if (!root) {
-    root = make_unique<KeywordTrie>();
-    root->on_any_star = root.get();
-  }
-  KeywordTrie* cur = root->insertAnyStar();
-  // Add to trie
-  String text; // normal text
+void KeywordAutomaton::add(const Keyword& kw) {
+  // find the first piece of literal text
+  String text;
   size_t param = 0;
-  bool only_star = true;
   for (size_t i = 0 ; i < kw.match.size() ;) {
     Char c = kw.match.GetChar(i);
     if (is_substr(kw.match, i, _("<atom-param"))) {
@@ -315,106 +266,152 @@ void KeywordDatabase::add(const Keyword& kw) {
         kw.parameters[param]->eat_separator_after(kw.match, i);
       }
       ++param;
-      // match anything
-      cur = cur->insert(text);
-      text.clear();
-      cur = cur->insertAnyStar();
-      // enough?
-      if (!only_star) {
-        // If we have matched anything specific, this is a good time to stop
-        // it doesn't really matter how long we go on, since the trie is only used
-        // as an optimization to not have to match lots of regexes.
-        // As an added bonus, we get a better behaviour of matching earlier keywords first.
-        break;
-      }
+      // If we have matched anything specific, this is a good time to stop
+      if (!text.empty()) break;
     } else {
-      text += c;
+      #if USE_CASE_INSENSITIVE_KEYWORDS
+        text += toLower(c); // case insensitive matching
+      #else
+        text += c;
+      #endif
       i++;
-      only_star = false;
     }
   }
-  cur = cur->insert(text);
-  // now cur is the trie after matching the keyword anywhere in the input text
-  cur->finished.push_back(&kw);
+  patterns.emplace_back(text, &kw);
 }
 
-void KeywordDatabase::prepare_parameters(const vector<KeywordParamP>& ps, const vector<KeywordP>& kws) {
-  FOR_EACH_CONST(kw, kws) {
-    kw->prepare(ps);
+void KeywordAutomaton::compile() {
+  // build a trie
+  struct TrieNode {
+    map<wxUniChar,int> children;
+    vector<int> finished; ///< patterns that end in this node
+    int fail = 0;
+  };
+  vector<TrieNode> trie(1);
+  for (int p = 0 ; p < (int)patterns.size() ; ++p) {
+    int cur = 0;
+    for (wxUniChar c : patterns[p].first) {
+      auto it = trie[cur].children.find(c);
+      if (it == trie[cur].children.end()) {
+        trie[cur].children[c] = (int)trie.size();
+        cur = (int)trie.size();
+        trie.emplace_back();
+      } else {
+        cur = it->second;
+      }
+    }
+    trie[cur].finished.push_back(p);
+  }
+  // breadth first: fail links and outputs, parents come before children
+  vector<int> order(1, 0);
+  for (size_t i = 0 ; i < order.size() ; ++i) {
+    int n = order[i];
+    for (auto const& child : trie[n].children) {
+      int fail = 0;
+      if (n != 0) {
+        // longest suffix of n that can be extended with c
+        int f = trie[n].fail;
+        while (true) {
+          auto it = trie[f].children.find(child.first);
+          if (it != trie[f].children.end()) { fail = it->second; break; }
+          if (f == 0) break;
+          f = trie[f].fail;
+        }
+      }
+      trie[child.second].fail = fail;
+      order.push_back(child.second);
+    }
+  }
+  // flatten, node numbers stay the same
+  nodes.assign(trie.size(), Node());
+  edges.clear();
+  outputs.clear();
+  for (int n : order) {
+    Node& node = nodes[n];
+    node.fail = trie[n].fail;
+    node.edges_begin = (int)edges.size();
+    for (auto const& child : trie[n].children) {
+      edges.push_back(Edge{child.first, child.second}); // map is sorted by character
+    }
+    node.edges_end = (int)edges.size();
+    node.outputs_begin = (int)outputs.size();
+    outputs.insert(outputs.end(), trie[n].finished.begin(), trie[n].finished.end());
+    if (n != 0) {
+      const Node& fail = nodes[node.fail]; // already flattened, because it is less deep
+      for (int i = fail.outputs_begin ; i < fail.outputs_end ; ++i) {
+        outputs.push_back(outputs[i]);
+      }
+    }
+    node.outputs_end = (int)outputs.size();
   }
 }
 
-#ifdef _DEBUG
-void dump(int i, const KeywordTrie* t) {
-  FOR_EACH(c, t->children) {
-    wxLogDebug(String(i, _(' ')) + c.first + _("     ") + String::Format(_("%p"), c.second.get()));
-    dump(i + 2, c.second.get());
+void KeywordAutomaton::candidates(const String& untagged, vector<const Keyword*>& out) const {
+  if (nodes.empty()) return;
+  vector<bool> found(patterns.size(), false);
+  auto mark = [&](int node) {
+    for (int i = nodes[node].outputs_begin ; i < nodes[node].outputs_end ; ++i) {
+      found[outputs[i]] = true;
+    }
+  };
+  mark(0); // keywords without literal text
+  int state = 0;
+  for (wxUniChar c : untagged) {
+    c = toLower(c); // case insensitive matching
+    while (true) {
+      int next = child(state, c);
+      if (next >= 0) { state = next; break; }
+      if (state == 0) break;
+      state = nodes[state].fail;
+    }
+    mark(state);
   }
-  if (t->on_any_star) {
-    wxLogDebug(String(i, _(' ')) + _(".*") + _("     ") + String::Format(_("%p"), t->on_any_star));
-    if (t->on_any_star != t) dump(i + 2, t->on_any_star);
+  for (size_t i = 0 ; i < patterns.size() ; ++i) {
+    if (found[i]) out.push_back(patterns[i].second);
   }
 }
-#endif
 
-// ----------------------------------------------------------------------------- : KeywordDatabase : matching
+// ----------------------------------------------------------------------------- : KeywordDatabase
 
-// transitive closure of a state, follow all on_any_star links
-void closure(vector<const KeywordTrie*>& state) {
-  for (size_t j = 0 ; j < state.size() ; ++j) {
-    if (state[j]->on_any_star && state[j]->on_any_star != state[j]) {
-      state.push_back(state[j]->on_any_star);
-    }
-  }
+IMPLEMENT_DYNAMIC_ARG(KeywordUsageStatistics*, keyword_usage_statistics, nullptr);
+
+KeywordDatabase::KeywordDatabase() {}
+// Note: has to be here because in the header KeywordAutomaton is not defined
+KeywordDatabase::~KeywordDatabase() {}
+
+void KeywordDatabase::clear() {
+  automaton.reset();
+  clearMatchCache();
 }
 
-void step_state(vector<const KeywordTrie*>& state, wxUniChar c) {
-  vector<const KeywordTrie*> next;
-  for(auto kt : state) {
-    auto it = kt->children.find(c);
-    if (it != kt->children.end()) {
-      next.push_back(it->second.get());
-    }
-    // TODO: on any star first or last?
-    if (kt->on_any_star) {
-      next.push_back(kt->on_any_star);
-    }
+void KeywordDatabase::add(const vector<KeywordP>& kws) {
+  FOR_EACH_CONST(kw, kws) {
+    addWithoutCompiling(*kw);
   }
-  swap(state,next);
+  if (automaton) automaton->compile();
+  clearMatchCache();
 }
 
-// Collect possible matching keywords
-/* First step in matching is to run over the string, and use the trie to find keywords that *potentially* appear in it.
- */
-unordered_set<Keyword const*> possible_matches(String const& tagged_str, KeywordTrie const* trie_root) {
-  unordered_set<const Keyword*> possible_matches;
-  if (!trie_root) return possible_matches;
-
-  vector<const KeywordTrie*> state;
-  state.push_back(trie_root);
-
-  for (String::const_iterator it = tagged_str.begin(); it != tagged_str.end();) {
-    wxUniChar c = *it;
-    // tag?
-    if (c == '<') {
-      it = skip_tag(it, tagged_str.end());
-    } else {
-      ++it;
-      c = toLower(c); // case insensitive matching
-      // find 'next' trie node set matching c
-      step_state(state, c);
-      closure(state);
-      // matches
-      for (auto kt : state) {
-        for (auto kw : kt->finished) {
-          possible_matches.insert(kw);
-        }
-      }
-    }
+void KeywordDatabase::add(const Keyword& kw) {
+  addWithoutCompiling(kw);
+  if (automaton) automaton->compile();
+  clearMatchCache();
+}
+
+void KeywordDatabase::addWithoutCompiling(const Keyword& kw) {
+  if (kw.match.empty() || !kw.valid) return; // can't handle empty keywords
+  if (!automaton) automaton = make_unique<KeywordAutomaton>();
+  automaton->add(kw);
+}
+
+void KeywordDatabase::prepare_parameters(const vector<KeywordParamP>& ps, const vector<KeywordP>& kws) {
+  FOR_EACH_CONST(kw, kws) {
+    kw->prepare(ps);
   }
-  return possible_matches;
 }
 
+// ----------------------------------------------------------------------------- : KeywordDatabase : matching
+
 struct KeywordMatch {
   Keyword const* keyword;
   // match in (substring of) the untagged string
@@ -437,7 +434,7 @@ void keyword_matches(const String& untagged_str, const Keyword& keyword, vector<
     it = max(it+1, match[0].end());
   }
 }
-void keyword_matches(const String& untagged_str, unordered_set<Keyword const*> keywords, vector<KeywordMatch>& out) {
+void keyword_matches(const String& untagged_str, const vector<Keyword const*>& keywords, vector<KeywordMatch>& out) {
   for (auto keyword : keywords) {
     keyword_matches(untagged_str, *keyword, out);
   }
@@ -457,7 +454,7 @@ void sort_keyword_matches(vector<KeywordMatch>& matches) {
     return a.keyword->keyword < b.keyword->keyword;
   });
 }
-vector<KeywordMatch> keyword_matches(const String& untagged_str, unordered_set<Keyword const*> keywords) {
+vector<KeywordMatch> keyword_matches(const String& untagged_str, const vector<Keyword const*>& keywords) {
   vector<KeywordMatch> out;
   keyword_matches(untagged_str, keywords, out);
   sort_keyword_matches(out);
@@ -772,6 +769,40 @@ void remove_from_stats(KeywordUsageStatistics* stat, const Value* stat_key) {
   }
 }
 
+/// The keyword matches in an untagged string
+/* The matches refer to positions in untagged, so the string is stored together with them.
+ */
+struct KeywordDatabase::CachedMatches {
+  String               untagged;
+  vector<KeywordMatch> matches;
+};
+
+shared_ptr<const KeywordDatabase::CachedMatches> KeywordDatabase::findMatches(const String& untagged) const {
+  {
+    wxMutexLocker lock(match_cache_mutex);
+    auto it = match_cache.find(untagged);
+    if (it != match_cache.end()) return it->second;
+  }
+  // Find potential matches, then refine them
+  auto cached = make_shared<CachedMatches>();
+  cached->untagged = untagged;
+  vector<const Keyword*> candidates;
+  automaton->candidates(cached->untagged, candidates);
+  cached->matches = keyword_matches(cached->untagged, candidates);
+  // store
+  wxMutexLocker lock(match_cache_mutex);
+  if (match_cache.size() >= MAX_MATCH_CACHE_SIZE) {
+    match_cache.clear(); // cache is full, start over
+  }
+  match_cache.emplace(untagged, cached);
+  return cached;
+}
+
+void KeywordDatabase::clearMatchCache() {
+  wxMutexLocker lock(match_cache_mutex);
+  match_cache.clear();
+}
+
 String KeywordDatabase::expand(const String& text, KeywordExpandOptions const& options) const {
   assert(options.combine_script);
   assert_tagged(text, false);
@@ -783,17 +814,14 @@ String KeywordDatabase::expand(const String& text, KeywordExpandOptions const& o
   String tagged = remove_keyword_tags(text);
 
   // any keywords in database?
-  if (!root) return tagged;
-
-  // Find potential matches
-  auto possible_matches = ::possible_matches(tagged, root.get());
+  if (!automaton) return tagged;
 
-  // Refine
+  // Find matches, or use the matches from the last time we saw this text
   String untagged = untag_no_escape(tagged);
-  auto matches = keyword_matches(untagged, possible_matches);
+  shared_ptr<const CachedMatches> cached = findMatches(untagged);
   
   // Expand
-  String result = expand_keywords(tagged, matches, options);
+  String result = expand_keywords(tagged, cached->matches, options);
   assert_tagged(result, false);
   return result;
 }
@@ -13,12 +13,13 @@
 #include <util/dynamic_arg.hpp>
 #include <util/regex.hpp>
 #include <data/filter.hpp>
+#include <wx/thread.h>
 
 DECLARE_POINTER_TYPE(KeywordParam);
 DECLARE_POINTER_TYPE(KeywordMode);
 DECLARE_POINTER_TYPE(Keyword);
 DECLARE_POINTER_TYPE(ParamReferenceType);
-class KeywordTrie;
+class KeywordAutomaton;
 class Value;
 
 // ----------------------------------------------------------------------------- : Keyword parameters
@@ -163,7 +164,7 @@ public:
   /// Clear the database
   void clear();
   /// Is the database empty?
-  inline bool empty() const { return !root; }
+  inline bool empty() const { return !automaton; }
   
   /// Expand/update all keywords in the given string.
   /** @param options.expand_default script function indicating whether reminder text should be shown by default
@@ -175,7 +176,24 @@ public:
   String expand(const String& text, const KeywordExpandOptions&) const;
   
 private:
-  unique_ptr<KeywordTrie> root; ///< Data structure for finding keywords
+  unique_ptr<KeywordAutomaton> automaton; ///< Data structure for finding candidate keywords
+  
+  /// Matches of the keywords in an untagged string
+  struct CachedMatches;
+  /// Matches for recently expanded strings, by untagged string
+  /** Most strings are expanded many times with the same text, for example while typing in another field.
+   *  Cleared when keywords are added to the database.
+   */
+  mutable unordered_map<String, shared_ptr<const CachedMatches>> match_cache;
+  mutable wxMutex match_cache_mutex;
+  static const size_t MAX_MATCH_CACHE_SIZE = 4096;
+  
+  /// Add a keyword to the automaton, without compiling it
+  void addWithoutCompiling(const Keyword&);
+  /// Find the matches of all keywords in an untagged string, or look them up in the cache
+  shared_ptr<const CachedMatches> findMatches(const String& untagged) const;
+  void clearMatchCache();
+  
   
   /// (try to) expand a single keyword
   /** If the keyword matches:
@@ -0,0 +1,207 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <data/search_index.hpp>
+#include <data/card.hpp>
+#include <data/field.hpp>
+#include <data/action/set.hpp>
+#include <data/action/value.hpp>
+
+// ----------------------------------------------------------------------------- : CardSearchIndex
+
+CardSearchIndex::CardSearchIndex() {}
+CardSearchIndex::~CardSearchIndex() {}
+
+void CardSearchIndex::addTrigrams(const String& str, vector<Trigram>& out) {
+  // the characters are folded in the same way as in find_i
+  Trigram t = 0;
+  size_t n = 0;
+  for (String::const_iterator it = str.begin() ; it != str.end() ; ++it) {
+    t = ((t << 21) | ((Trigram)toLower(*it) & 0x1FFFFF)) & 0x7FFFFFFFFFFFFFFFull;
+    if (++n >= 3) out.push_back(t);
+  }
+}
+
+size_t CardSearchIndex::update(const CardP& card) {
+  size_t id;
+  unordered_map<const Card*,size_t>::const_iterator it = card_ids.find(card.get());
+  if (it != card_ids.end()) {
+    id = it->second;
+  } else {
+    // a card we haven't seen before
+    if (free_ids.empty()) {
+      id = entries.size();
+      entries.push_back(Entry());
+    } else {
+      id = free_ids.back();
+      free_ids.pop_back();
+    }
+    entries[id].card  = card;
+    entries[id].dirty = true;
+    card_ids[card.get()] = id;
+  }
+  Entry& e = entries[id];
+  if (e.dirty || e.notes != card->notes) {
+    unindex(id);
+    index(id);
+  }
+  return id;
+}
+
+void CardSearchIndex::index(size_t id) {
+  Entry& e = entries[id];
+  const Card& card = *e.card;
+  FOR_EACH_CONST(v, card.data) {
+    addTrigrams(v->toString(), e.trigrams);
+    e.values.push_back(v.get());
+    value_ids[v.get()] = id;
+  }
+  addTrigrams(card.notes, e.trigrams);
+  e.notes = card.notes;
+  e.dirty = false;
+  sort(e.trigrams.begin(), e.trigrams.end());
+  e.trigrams.erase(unique(e.trigrams.begin(), e.trigrams.end()), e.trigrams.end());
+  FOR_EACH_CONST(t, e.trigrams) {
+    vector<size_t>& ids = postings[t];
+    ids.insert(lower_bound(ids.begin(), ids.end(), id), id);
+  }
+}
+
+void CardSearchIndex::unindex(size_t id) {
+  Entry& e = entries[id];
+  FOR_EACH_CONST(t, e.trigrams) {
+    unordered_map<Trigram,vector<size_t>>::iterator it = postings.find(t);
+    if (it == postings.end()) continue;
+    vector<size_t>& ids = it->second;
+    vector<size_t>::iterator pos = lower_bound(ids.begin(), ids.end(), id);
+    if (pos != ids.end() && *pos == id) ids.erase(pos);
+    if (ids.empty()) postings.erase(it);
+  }
+  FOR_EACH_CONST(v, e.values) {
+    value_ids.erase(v);
+  }
+  e.trigrams.clear();
+  e.values.clear();
+}
+
+void CardSearchIndex::removeCard(const Card* card) {
+  unordered_map<const Card*,size_t>::iterator it = card_ids.find(card);
+  if (it == card_ids.end()) return;
+  size_t id = it->second;
+  card_ids.erase(it);
+  unindex(id);
+  entries[id] = Entry();
+  free_ids.push_back(id);
+}
+
+void CardSearchIndex::markDirty(const Value* value) {
+  unordered_map<const Value*,size_t>::const_iterator it = value_ids.find(value);
+  if (it != value_ids.end()) {
+    entries[it->second].dirty = true;
+  }
+}
+
+bool CardSearchIndex::candidates(const String& query, vector<size_t>& out) const {
+  vector<Trigram> trigrams;
+  addTrigrams(query, trigrams);
+  if (trigrams.empty()) return false;
+  // intersect the posting lists, starting with the shortest one
+  vector<const vector<size_t>*> lists;
+  FOR_EACH_CONST(t, trigrams) {
+    unordered_map<Trigram,vector<size_t>>::const_iterator it = postings.find(t);
+    if (it == postings.end()) {
+      out.clear();
+      return true;
+    }
+    lists.push_back(&it->second);
+  }
+  sort(lists.begin(), lists.end(), [](const vector<size_t>* a, const vector<size_t>* b) { return a->size() < b->size(); });
+  out = *lists.front();
+  vector<size_t> next;
+  for (size_t i = 1 ; i < lists.size() && !out.empty() ; ++i) {
+    if (lists[i] == lists[i-1]) continue; // repeated trigram
+    next.clear();
+    set_intersection(out.begin(), out.end(), lists[i]->begin(), lists[i]->end(), back_inserter(next));
+    swap(out, next);
+  }
+  return true;
+}
+
+void CardSearchIndex::getItems(const vector<QuickFilterPart>& query, const vector<CardP>& cards, vector<VoidP>& out) {
+  // make sure that all cards are indexed and up to date
+  vector<size_t> ids;
+  ids.reserve(cards.size());
+  FOR_EACH_CONST(card, cards) {
+    ids.push_back(update(card));
+  }
+  // For each part of the query, which cards could match?
+  // A card that does not contain all trigrams of a part certainly doesn't contain the part itself.
+  // For queries of three characters without a type, containing the trigram is the same as matching,
+  // since trigrams are taken from single values.
+  struct PartInfo {
+    bool         use_index;
+    bool         exact;
+    vector<bool> maybe; ///< by card id
+  };
+  vector<PartInfo> info(query.size());
+  vector<size_t> part_ids;
+  for (size_t i = 0 ; i < query.size() ; ++i) {
+    const QuickFilterPart& part = query[i];
+    PartInfo& pi = info[i];
+    pi.use_index = candidates(part.query, part_ids);
+    pi.exact = pi.use_index && part.type.empty() && part.query.size() == 3;
+    if (pi.use_index) {
+      pi.maybe.resize(entries.size(), false);
+      FOR_EACH_CONST(id, part_ids) pi.maybe[id] = true;
+    }
+  }
+  // check the candidates
+  for (size_t c = 0 ; c < cards.size() ; ++c) {
+    size_t id = ids[c];
+    bool keep = true;
+    for (size_t i = 0 ; i < query.size() && keep ; ++i) {
+      const QuickFilterPart& part = query[i];
+      const PartInfo& pi = info[i];
+      bool contains;
+      if (pi.use_index && !pi.maybe[id]) {
+        contains = false;
+      } else if (pi.exact) {
+        contains = true;
+      } else {
+        contains = cards[c]->contains(part);
+      }
+      keep = contains == part.need_match;
+    }
+    if (keep) out.push_back(cards[c]);
+  }
+}
+
+void CardSearchIndex::onAction(const Action& action, bool undone) {
+  TYPE_CASE(action, ValueAction) {
+    markDirty(action.valueP.get());
+  }
+  TYPE_CASE(action, ScriptValueEvent) {
+    markDirty(action.value);
+  }
+  TYPE_CASE(action, AddCardAction) {
+    if (action.action.adding == undone) {
+      FOR_EACH_CONST(step, action.action.steps) {
+        removeCard(step.item.get());
+      }
+    }
+    // added cards are indexed by the next query
+  }
+}
+
+// ----------------------------------------------------------------------------- : IndexedQuickFilter
+
+void IndexedQuickFilter::getItems(vector<CardP> const& in, vector<VoidP>& out) const {
+  index->getItems(query, in, out);
+}
+
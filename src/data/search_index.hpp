@@ -0,0 +1,82 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <data/filter.hpp>
+
+class Card;
+class Value;
+class Action;
+DECLARE_POINTER_TYPE(Card);
+DECLARE_POINTER_TYPE(CardSearchIndex);
+
+// ----------------------------------------------------------------------------- : CardSearchIndex
+
+/// An index of the text on cards, for answering quick search queries
+/** For each trigram (three consecutive characters) in the untagged, case folded values of the cards,
+ *  the index has a sorted list of the cards that contain that trigram.
+ *  A card can only contain a string if it contains all trigrams of that string,
+ *  so the candidates for a query are found by intersecting these posting lists.
+ *  The candidates are then checked with Card::contains, so the result is the same as with QuickFilter.
+ *
+ *  The index is updated lazily: actions only mark cards as changed, they are indexed again by the next query.
+ */
+class CardSearchIndex : public IntrusivePtrBase<CardSearchIndex> {
+public:
+  CardSearchIndex();
+  ~CardSearchIndex();
+
+  /// Select the cards that match a quick search query
+  void getItems(const vector<QuickFilterPart>& query, const vector<CardP>& cards, vector<VoidP>& out);
+
+  /// Mark the cards changed by an action as out of date
+  void onAction(const Action& action, bool undone);
+
+private:
+  typedef unsigned long long Trigram;
+  struct Entry {
+    CardP                card;     ///< null for unused ids
+    vector<Trigram>      trigrams; ///< The trigrams the card is indexed under, sorted
+    vector<const Value*> values;   ///< The values the card was indexed with
+    String               notes;    ///< The notes when the card was indexed, notes are edited without an action that knows the card
+    bool                 dirty = true;
+  };
+  vector<Entry>                          entries;   ///< by card id
+  vector<size_t>                         free_ids;  ///< ids of removed cards
+  unordered_map<const Card*,size_t>      card_ids;
+  unordered_map<const Value*,size_t>     value_ids; ///< Card ids of the values on the cards
+  unordered_map<Trigram,vector<size_t>>  postings;  ///< Sorted card ids for each trigram
+
+  /// Add the trigrams of the case folded string str to out
+  static void addTrigrams(const String& str, vector<Trigram>& out);
+  /// Get the id of a card, and make sure that it is indexed and up to date
+  size_t update(const CardP& card);
+  void index(size_t id);
+  void unindex(size_t id);
+  void removeCard(const Card* card);
+  void markDirty(const Value* value);
+  /// Find the ids of the cards that contain all trigrams of a query
+  /** Returns false if the query is too short to use the index */
+  bool candidates(const String& query, vector<size_t>& out) const;
+};
+
+// ----------------------------------------------------------------------------- : IndexedQuickFilter
+
+/// A quick search filter for cards that uses a CardSearchIndex
+class IndexedQuickFilter : public QuickFilter<Card> {
+public:
+  IndexedQuickFilter(String const& query, const CardSearchIndexP& index)
+    : QuickFilter<Card>(query), index(index)
+  {}
+  void getItems(vector<CardP> const& in, vector<VoidP>& out) const override;
+private:
+  CardSearchIndexP index;
+};
+
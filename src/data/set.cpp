@@ -20,6 +20,7 @@
 #include <util/order_cache.hpp>
 #include <util/delayed_index_maps.hpp>
 #include <script/script_manager.hpp>
+#include <script/value_cache.hpp>
 #include <script/profiler.hpp>
 #include <wx/sstream.h>
 
@@ -162,8 +163,16 @@ void Set::validate(Version file_app_version) {
 */  }
   // we want at least one card
   if (cards.empty()) cards.push_back(make_intrusive<Card>(*game));
-  // update scripts
-  script_manager->updateAll();
+  // update scripts, unless the results are still in the cache
+  ValueCacheKey cache_key;
+  if (read_value_cache(*this, cache_key)) {
+    // initialize the dependencies, so later changes are propagated
+    getContext();
+  } else {
+    int64_t start = trace_clock();
+    script_manager->updateAll();
+    write_value_cache(*this, cache_key, trace_clock() - start);
+  }
 }
 
 void reflect_version_check(Reader& handler, const Char* key, intrusive_ptr<Packaged> const& package) {
@@ -275,7 +284,7 @@ void reflect_set_info_get_member(GetMember& handler, const IndexMap<FieldP, Valu
 }
 
 int Set::positionOfCard(const CardP& card, const ScriptValueP& order_by, const ScriptValueP& filter) {
-  // TODO : Lock the map?
+  wxMutexLocker lock(order_cache_mutex);
   assert(order_by);
   OrderCacheP& order = order_cache[make_pair(order_by,filter)];
   if (!order) {
@@ -300,6 +309,7 @@ int Set::positionOfCard(const CardP& card, const ScriptValueP& order_by, const S
 }
 int Set::numberOfCards(const ScriptValueP& filter) {
   if (!filter) return (int)cards.size();
+  wxMutexLocker lock(order_cache_mutex);
   map<ScriptValueP,int>::const_iterator it = filter_cache.find(filter);
   if (it !=filter_cache.end()) {
     return it->second;
@@ -313,10 +323,22 @@ int Set::numberOfCards(const ScriptValueP& filter) {
   }
 }
 void Set::clearOrderCache() {
+  wxMutexLocker lock(order_cache_mutex);
   order_cache.clear();
   filter_cache.clear();
 }
 
+const KeywordDatabase& Set::keywordDatabase() {
+  wxMutexLocker lock(keyword_db_mutex);
+  if (keyword_db.empty()) {
+    keyword_db.prepare_parameters(game->keyword_parameter_types, keywords);
+    keyword_db.prepare_parameters(game->keyword_parameter_types, game->keywords);
+    keyword_db.add(keywords);
+    keyword_db.add(game->keywords);
+  }
+  return keyword_db;
+}
+
 // ----------------------------------------------------------------------------- : SetView
 
 SetView::SetView() {}
@@ -14,6 +14,7 @@
 #include <util/io/package.hpp>
 #include <data/field.hpp> // for Set::value
 #include <data/keyword.hpp>
+#include <wx/thread.h>
 
 DECLARE_POINTER_TYPE(Card);
 DECLARE_POINTER_TYPE(Set);
@@ -114,6 +115,10 @@ public:
   /// Clear the order_cache used by positionOfCard
   void clearOrderCache();
   
+  /// The keyword database for this set, it is filled with the keywords of the set and the game if it was empty
+  /** Thread safe, but the database must not be cleared while it is in use */
+  const KeywordDatabase& keywordDatabase();
+  
   String typeName() const override;
   Version fileVersion() const override;
   /// Validate that the set is correctly loaded
@@ -136,6 +141,10 @@ private:
   /// Cache of cards ordered by some criterion
   map<pair<ScriptValueP,ScriptValueP>,OrderCacheP> order_cache;
   map<ScriptValueP,int>                            filter_cache;
+  /// Lock for order_cache and filter_cache, recursive because the scripts that fill the caches can use them
+  wxMutex order_cache_mutex{wxMUTEX_RECURSIVE};
+  /// Lock for filling the keyword_db
+  wxMutex keyword_db_mutex;
 };
 
 inline String type_name(const Set&) {
@@ -10,6 +10,13 @@
 #include <data/statistics.hpp>
 #include <data/field.hpp>
 #include <data/field/choice.hpp>
+#include <data/set.hpp>
+#include <data/game.hpp>
+#include <data/card.hpp>
+#include <data/action/set.hpp>
+#include <data/action/value.hpp>
+#include <data/action/keyword.hpp>
+#include <util/tagged_string.hpp>
 
 extern ScriptValueP script_primary_choice;
 
@@ -17,6 +24,7 @@ extern ScriptValueP script_primary_choice;
 
 StatsDimension::StatsDimension()
   : automatic    (false)
+  , index        (0)
   , position_hint(0)
   , numeric      (false)
   , bin_size     (0)
@@ -26,6 +34,7 @@ StatsDimension::StatsDimension()
 
 StatsDimension::StatsDimension(const Field& field)
   : automatic    (true)
+  , index        (0)
   , name         (field.name)
   , description  (field.description)
   , position_hint(field.position_hint)
@@ -124,6 +133,173 @@ void StatsCategory::find_dimensions(const vector<StatsDimensionP>& available) {
   }
 }
 
+// ----------------------------------------------------------------------------- : Statistics values
+
+StatsValueCache::StatsValueCache(Set& set)
+  : set(set)
+{}
+
+StatsValueCache::~StatsValueCache() {}
+
+StatsValueCache::DimensionValues& StatsValueCache::valuesFor(const StatsDimension& dim) {
+  if (dimensions.size() <= dim.index) dimensions.resize(dim.index + 1);
+  DimensionValues& values = dimensions[dim.index];
+  if (!values.initialized) {
+    values.initialized = true;
+    FOR_EACH(card, set.cards) {
+      values.dirty[card.get()] = card;
+    }
+  }
+  return values;
+}
+
+const StatsValueCache::CardValue& StatsValueCache::get(const StatsDimension& dim, DimensionValues& values, const CardP& card) {
+  unordered_map<const Card*,CardValue>::iterator it = values.values.find(card.get());
+  if (it != values.values.end()) return it->second;
+  // evaluate
+  CardValue& v = values.values[card.get()];
+  v.card  = card;
+  v.error = false;
+  try {
+    Context& ctx = set.getContext(card);
+    v.value = untag(dim.script.invoke(ctx)->toString());
+  } catch (ScriptError const& e) {
+    handle_error(ScriptError(e.what() + _("\n  in script for statistics dimension '") + dim.name + _("'")));
+    v.error = true;
+  }
+  values.dirty.erase(card.get());
+  addToHistogram(dim, values, v, 1);
+  return v;
+}
+
+bool StatsValueCache::value(const StatsDimension& dim, const CardP& card, String& out) {
+  const CardValue& v = get(dim, valuesFor(dim), card);
+  out = v.value;
+  return !v.error;
+}
+
+const map<String,UInt,SmartLess>& StatsValueCache::histogram(const StatsDimension& dim) {
+  DimensionValues& values = valuesFor(dim);
+  while (!values.dirty.empty()) {
+    CardP card = values.dirty.begin()->second;
+    get(dim, values, card);
+  }
+  return values.histogram;
+}
+
+void StatsValueCache::countValue(DimensionValues& values, const String& value, int delta) {
+  UInt& count = values.histogram[value];
+  count += delta;
+  if (count == 0) values.histogram.erase(value);
+}
+
+void StatsValueCache::addToHistogram(const StatsDimension& dim, DimensionValues& values, const CardValue& v, int delta) {
+  if (v.error) return;
+  if (v.value.empty() && !dim.show_empty) return;
+  if (dim.split_list) {
+    // the same splitting as GraphDataPre::splitList
+    String rest = v.value;
+    size_t comma = rest.find_first_of(_(','));
+    while (comma != String::npos) {
+      countValue(values, rest.substr(0,comma), delta);
+      if (is_substr(rest, comma, _(", "))) ++comma; // skip space after it
+      rest = rest.substr(comma + 1);
+      comma = rest.find_first_of(_(','));
+    }
+    countValue(values, rest, delta);
+  } else {
+    countValue(values, v.value, delta);
+  }
+}
+
+void StatsValueCache::invalidate(size_t dim, const Card* card) {
+  if (dim >= dimensions.size() || !dimensions[dim].initialized) return;
+  DimensionValues& values = dimensions[dim];
+  if (card) {
+    unordered_map<const Card*,CardValue>::iterator it = values.values.find(card);
+    if (it == values.values.end()) return; // not evaluated yet
+    addToHistogram(*set.game->statistics_dimensions.at(dim), values, it->second, -1);
+    values.dirty[card] = it->second.card;
+    values.values.erase(it);
+  } else {
+    // everything has to be evaluated again
+    values = DimensionValues();
+  }
+}
+
+void StatsValueCache::invalidate(const vector<Dependency>& deps, const Card* card) {
+  FOR_EACH_CONST(d, deps) {
+    switch (d.type) {
+      case DEP_CARD_STATISTIC:
+        invalidate(d.index, card);
+        break;
+      case DEP_CARDS_STATISTIC:
+        invalidate(d.index, nullptr);
+        break;
+      case DEP_CARD_COPY_DEP:
+        // like SetScriptManager::alsoUpdate, propagate dependencies from another field
+        invalidate(set.game->card_fields.at(d.index)->dependent_scripts, card);
+        break;
+      case DEP_SET_COPY_DEP:
+        invalidate(set.game->set_fields.at(d.index)->dependent_scripts, card);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+void StatsValueCache::addCard(const CardP& card) {
+  FOR_EACH(values, dimensions) {
+    if (values.initialized) values.dirty[card.get()] = card;
+  }
+}
+
+void StatsValueCache::removeCard(const Card* card) {
+  for (size_t dim = 0 ; dim < dimensions.size() ; ++dim) {
+    invalidate(dim, card);
+    dimensions[dim].dirty.erase(card);
+  }
+}
+
+void StatsValueCache::onAction(const Action& action, bool undone) {
+  TYPE_CASE(action, ValueAction) {
+    if (!action.card && dynamic_cast<KeywordTextValue*>(action.valueP.get())) {
+      // a keyword was edited, like a KeywordListAction
+      invalidate(set.game->dependent_scripts_keywords, nullptr);
+      return;
+    }
+    invalidate(action.valueP->fieldP->dependent_scripts, action.card.get());
+  }
+  TYPE_CASE(action, ScriptValueEvent) {
+    invalidate(action.value->fieldP->dependent_scripts, action.card);
+  }
+  TYPE_CASE(action, AddCardAction) {
+    FOR_EACH_CONST(step, action.action.steps) {
+      if (action.action.adding != undone) {
+        addCard(step.item);
+      } else {
+        removeCard(step.item.get());
+      }
+    }
+  }
+  TYPE_CASE_(action, CardListAction) {
+    invalidate(set.game->dependent_scripts_cards, nullptr);
+  }
+  TYPE_CASE_(action, KeywordListAction) {
+    invalidate(set.game->dependent_scripts_keywords, nullptr);
+  }
+  TYPE_CASE_(action, ChangeKeywordModeAction) {
+    invalidate(set.game->dependent_scripts_keywords, nullptr);
+  }
+  TYPE_CASE(action, ChangeCardStyleAction) {
+    invalidate(set.game->dependent_scripts_stylesheet, action.card.get());
+  }
+  TYPE_CASE_(action, ChangeSetStyleAction) {
+    invalidate(set.game->dependent_scripts_stylesheet, nullptr);
+  }
+}
+
 // ----------------------------------------------------------------------------- : GraphType (from graph_type.hpp)
 
 IMPLEMENT_REFLECTION_ENUM(GraphType) {
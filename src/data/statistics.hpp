@@ -13,8 +13,13 @@
 #include <data/graph_type.hpp>
 #include <data/localized_string.hpp>
 #include <script/scriptable.hpp>
+#include <script/dependency.hpp>
 
 class Field;
+class Set;
+class Card;
+class Action;
+DECLARE_POINTER_TYPE(Card);
 DECLARE_POINTER_TYPE(StatsDimension);
 DECLARE_POINTER_TYPE(StatsCategory);
 
@@ -28,6 +33,7 @@ public:
   StatsDimension(const Field&);
   
   const bool        automatic;    ///< Based on a card field?
+  size_t            index;        ///< Position in Game::statistics_dimensions, used for dependencies
   String            name;        ///< Name of this dimension
   LocalizedString   description;    ///< Description, used in status bar
   int               position_hint;  ///< Hint for the ordering
@@ -69,3 +75,56 @@ public:
   DECLARE_REFLECTION();
 };
 
+// ----------------------------------------------------------------------------- : Statistics values
+
+/// Cache of the values of statistics dimensions for the cards in a set
+/** Values are evaluated when they are first needed. They are invalidated using the dependencies
+ *  of the dimension scripts (DEP_CARD_STATISTIC), so after a card changes only the values of that card
+ *  have to be evaluated again.
+ *  For each dimension a histogram of the values is kept, which is updated along with the values.
+ */
+class StatsValueCache {
+public:
+  StatsValueCache(Set& set);
+  ~StatsValueCache();
+  
+  /// Get the untagged value of a dimension for a card
+  /** Returns false if the script of the dimension gave an error */
+  bool value(const StatsDimension& dim, const CardP& card, String& out);
+  
+  /// The number of cards with each value of a dimension
+  /** Cards with an empty value are only counted if dim.show_empty,
+   *  the values of split_list dimensions are counted separately.
+   *  These are the group sizes of a graph of just this dimension.
+   */
+  const map<String,UInt,SmartLess>& histogram(const StatsDimension& dim);
+  
+  /// Invalidate the values that are changed by an action
+  void onAction(const Action& action, bool undone);
+  
+private:
+  struct CardValue {
+    CardP  card;
+    String value;
+    bool   error;
+  };
+  struct DimensionValues {
+    bool                                 initialized = false; ///< Have the cards of the set been added to dirty?
+    unordered_map<const Card*,CardValue> values;    ///< The values that are up to date
+    unordered_map<const Card*,CardP>     dirty;     ///< Cards in the set without an up to date value
+    map<String,UInt,SmartLess>           histogram; ///< Counts of the up to date values
+  };
+  Set& set;
+  vector<DimensionValues> dimensions; ///< by StatsDimension::index
+  
+  DimensionValues& valuesFor(const StatsDimension& dim);
+  const CardValue& get(const StatsDimension& dim, DimensionValues& values, const CardP& card);
+  void countValue(DimensionValues& values, const String& value, int delta);
+  void addToHistogram(const StatsDimension& dim, DimensionValues& values, const CardValue& value, int delta);
+  /// Invalidate the value of a dimension for a card, or for all cards if card == nullptr
+  void invalidate(size_t dim, const Card* card);
+  void invalidate(const vector<Dependency>& deps, const Card* card);
+  void addCard(const CardP& card);
+  void removeCard(const Card* card);
+};
+
@@ -95,6 +95,11 @@ private:
   wxSize           actual_size;  ///< Actual image size, only known after loading the image
   /// Cached bitmaps for different sizes
   map<double, Bitmap> bitmaps;
+  /// The image at full size, half size, quarter size, etc., smaller levels are added when needed
+  vector<Image> mip_levels;
+  
+  /// The smallest mip level that is at least width*height, to resample from
+  const Image& mipLevel(int width, int height);
   
   DECLARE_REFLECTION();
 };
@@ -118,15 +123,33 @@ Image SymbolInFont::getImage(Package& pkg, double size) {
   if (!image.isReady()) {
     throw Error(_("No image specified for symbol with code '") + code + _("' in symbol font."));
   }
-  Image img = image.generate(GeneratedImage::Options(0, 0, &pkg));
-  actual_size = wxSize(img.GetWidth(), img.GetHeight());
+  if (mip_levels.empty()) {
+    Image img = image.generate(GeneratedImage::Options(0, 0, &pkg));
+    actual_size = wxSize(img.GetWidth(), img.GetHeight());
+    mip_levels.push_back(img);
+  }
   // scale to match expected size
   Image resampled_image((int) (actual_size.GetWidth()  * size / img_size),
                         (int) (actual_size.GetHeight() * size / img_size), false);
   if (!resampled_image.Ok()) return Image(1,1);
-  resample(img, resampled_image);
+  resample(mipLevel(resampled_image.GetWidth(), resampled_image.GetHeight()), resampled_image);
   return resampled_image;
 }
+const Image& SymbolInFont::mipLevel(int width, int height) {
+  size_t level = 0;
+  while (true) {
+    const Image& img = mip_levels[level];
+    int w = img.GetWidth() / 2, h = img.GetHeight() / 2;
+    if (w < width || h < height) {
+      // the next level would be too small
+      return mip_levels[level];
+    }
+    if (level + 1 == mip_levels.size()) {
+      mip_levels.push_back(resample(img, w, h));
+    }
+    ++level;
+  }
+}
 Bitmap SymbolInFont::getBitmap(Package& pkg, double size) {
   // is this bitmap already loaded/generated?
   Bitmap& bmp = bitmaps[size];
@@ -156,6 +179,7 @@ void SymbolInFont::update(Context& ctx) {
   if (image.update(ctx)) {
     // image has changed, cache is no longer valid
     bitmaps.clear();
+    mip_levels.clear();
   }
   enabled.update(ctx);
   if (text_font)
@@ -92,6 +92,24 @@ void segment_subdivide(const ControlPoint& p0, const ControlPoint& p1, const Vec
   }
 }
 
+void segment_subdivide(const ControlPoint& p0, const ControlPoint& p1, const Vector2D& origin, const Matrix2D& m, vector<Vector2D>& out, double tolerance) {
+  assert(p0.segment_after == p1.segment_before);
+  Vector2D r0 = origin + p0.pos * m;
+  out.push_back(r0);
+  if (p0.segment_after == SEGMENT_CURVE) {
+    Vector2D r1 = origin + (p0.pos + p0.delta_after)  * m;
+    Vector2D r2 = origin + (p1.pos + p1.delta_before) * m;
+    Vector2D r3 = origin + p1.pos * m;
+    // With n lines the error is at most |B''|/(8*n^2), and |B''| <= 6 * the largest second difference of the handles
+    double dd = sqrt(max((r0 - r1 * 2. + r2).lengthSqr(), (r1 - r2 * 2. + r3).lengthSqr()));
+    int count = min(1000, (int)ceil(sqrt(0.75 * dd / tolerance)));
+    BezierCurve curve(r0, r1, r2, r3);
+    for (int i = 1 ; i < count ; ++i) {
+      out.push_back(curve.pointAt((double)i / count));
+    }
+  }
+}
+
 // ----------------------------------------------------------------------------- : Bounds
 
 Bounds segment_bounds(const Vector2D& origin, const Matrix2D& m, const ControlPoint& p1, const ControlPoint& p2) {
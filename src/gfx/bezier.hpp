@@ -70,6 +70,12 @@ void deCasteljau(const Vector2D& a1, Vector2D& a21, Vector2D& a34, const Vector2
  */
 void segment_subdivide(const ControlPoint& p0, const ControlPoint& p1, const Vector2D& origin, const Matrix2D& m, vector<wxPoint>& out);
 
+/// Devide a segment into straight lines for anti-aliased rendering
+/** Like the wxPoint version, but without rounding the points to pixels.
+ *  Curves are divided into enough lines that they are at most tolerance (in display coordinates) away from the curve.
+ */
+void segment_subdivide(const ControlPoint& p0, const ControlPoint& p1, const Vector2D& origin, const Matrix2D& m, vector<Vector2D>& out, double tolerance = 0.1);
+
 // ----------------------------------------------------------------------------- : Bounds
 
 /// Find a bounding box that fits a segment (either a line or a bezier curve) between p1 and p2.
@@ -8,6 +8,7 @@
 
 #include <util/prec.hpp>
 #include <gfx/gfx.hpp>
+#include <gfx/image_kernels.hpp>
 #include <util/error.hpp>
 
 // ----------------------------------------------------------------------------- : Linear Blend
@@ -66,12 +67,8 @@ void mask_blend(Image& img1, const Image& img2, const Image& mask) {
     throw Error(_("Images used for blending must have the same size"));
   }
   
-  UInt size = img1.GetWidth() * img1.GetHeight() * 3;
-  Byte *data1 = img1.GetData(), *data2 = img2.GetData(), *dataM = mask.GetData();
   // for each subpixel...
-  for (UInt i = 0 ; i < size ; ++i) {
-    data1[i] = (data1[i] * dataM[i] + data2[i] * (255 - dataM[i])) / 255;
-  }
+  mask_blend_bytes(img1.GetData(), img2.GetData(), mask.GetData(), img1.GetWidth() * img1.GetHeight() * 3);
 }
 
 // ----------------------------------------------------------------------------- : Alpha
@@ -96,11 +93,7 @@ void set_alpha(Image& img, Byte* al, const wxSize& alpha_size) {
     memcpy(img.GetAlpha(), al, img.GetWidth() * img.GetHeight());
   } else{
     // merge
-    Byte *im = img.GetAlpha();
-    size_t size = img.GetWidth() * img.GetHeight();
-    for (size_t i = 0 ; i < size ; ++i) {
-      im[i] = (im[i] * al[i]) / 255;
-    }
+    multiply_bytes(img.GetAlpha(), al, img.GetWidth() * img.GetHeight());
   }
 }
 
@@ -110,10 +103,6 @@ void set_alpha(Image& img, double alpha) {
     img.InitAlpha();
     memset(img.GetAlpha(), b_alpha, img.GetWidth() * img.GetHeight());
   } else {
-    Byte *im = img.GetAlpha();
-    size_t size = img.GetWidth() * img.GetHeight();
-    for (size_t i = 0 ; i < size ; ++i) {
-      im[i] = (im[i] * b_alpha) / 255;
-    }
+    multiply_bytes(img.GetAlpha(), b_alpha, img.GetWidth() * img.GetHeight());
   }
 }
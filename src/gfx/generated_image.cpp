@@ -8,12 +8,14 @@
 
 #include <util/prec.hpp>
 #include <gfx/generated_image.hpp>
+#include <gfx/image_pool.hpp>
 #include <util/io/package.hpp>
 #include <util/error.hpp>
 #include <data/symbol.hpp>
 #include <data/field/symbol.hpp>
 #include <render/symbol/filter.hpp>
 #include <gui/util.hpp> // load_resource_image
+#include <typeinfo>
 
 // ----------------------------------------------------------------------------- : GeneratedImage
 
@@ -24,7 +26,38 @@ GeneratedImageP GeneratedImage::toImage() const {
 }
 
 Image GeneratedImage::generateConform(const Options& options) const {
-  return conform_image(generate(options),options);
+  return conform_image(generateCached(options),options);
+}
+
+Image GeneratedImage::generateCached(const Options& options) const {
+  if (!worthCaching()) return generate(options);
+  Image img = generated_image_cache.find(*this, options);
+  if (!img.Ok()) {
+    img = generate(options);
+    generated_image_cache.add(*this, options, img);
+  }
+  return img;
+}
+
+size_t GeneratedImage::hash() const {
+  size_t h = hash_value;
+  if (h == 0) {
+    h = computeHash();
+    if (h == 0) h = 1; // 0 means 'not computed'
+    hash_value = h;
+  }
+  return h;
+}
+
+// combine a value into a hash, like boost::hash_combine
+template <typename T> inline void hash_combine(size_t& seed, const T& x) {
+  seed ^= std::hash<T>()(x) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+inline void hash_combine(size_t& seed, const GeneratedImageP& image) {
+  hash_combine(seed, image->hash());
+}
+inline void hash_combine(size_t& seed, const Color& color) {
+  hash_combine(seed, (color.Red() << 24) | (color.Green() << 16) | (color.Blue() << 8) | color.Alpha());
 }
 
 Image conform_image(const Image& img, const GeneratedImage::Options& options) {
@@ -78,6 +111,77 @@ Image conform_image(const Image& img, const GeneratedImage::Options& options) {
   return image;
 }
 
+// ----------------------------------------------------------------------------- : GeneratedImageCache
+
+GeneratedImageCache generated_image_cache(64 * 1024 * 1024);
+
+GeneratedImageCache::GeneratedImageCache(size_t max_size)
+  : max_size(max_size), total_size(0)
+{}
+
+inline bool same_options(const GeneratedImage::Options& a, const GeneratedImage::Options& b) {
+  // note: the local package is always compared, for composite images local() doesn't tell whether any part uses it
+  return a.width  == b.width  && a.height == b.height
+      && a.zoom   == b.zoom   && a.angle  == b.angle
+      && a.preserve_aspect == b.preserve_aspect && a.saturate == b.saturate
+      && a.package == b.package && a.local_package == b.local_package;
+}
+
+list<GeneratedImageCache::Entry>::iterator GeneratedImageCache::findEntry(size_t hash, const GeneratedImage& image, const GeneratedImage::Options& options) {
+  auto range = by_hash.equal_range(hash);
+  for (auto it = range.first ; it != range.second ; ++it) {
+    Entry& e = *it->second;
+    if (same_options(e.options, options) && (e.image.get() == &image || *e.image == image)) {
+      return it->second;
+    }
+  }
+  return entries.end();
+}
+
+Image GeneratedImageCache::find(const GeneratedImage& image, const GeneratedImage::Options& options) {
+  size_t hash = image.hash();
+  wxMutexLocker lock(mutex);
+  auto it = findEntry(hash, image, options);
+  if (it == entries.end()) return Image();
+  // move to front, it is now the most recently used image
+  entries.splice(entries.begin(), entries, it);
+  // the caller might modify the image data, so return a copy
+  return it->generated.Copy();
+}
+
+void GeneratedImageCache::add(const GeneratedImage& image, const GeneratedImage::Options& options, const Image& generated) {
+  if (!generated.Ok()) return;
+  size_t size = (size_t)generated.GetWidth() * generated.GetHeight() * (generated.HasAlpha() ? 4 : 3);
+  if (size > max_size / 4) return; // don't let a single image take over the cache
+  size_t hash = image.hash();
+  Image copy = generated.Copy();
+  wxMutexLocker lock(mutex);
+  if (findEntry(hash, image, options) != entries.end()) return; // generated by another thread in the meantime
+  entries.push_front(Entry{hash, image.toImage(), options, copy, size});
+  by_hash.emplace(hash, entries.begin());
+  total_size += size;
+  // remove least recently used images
+  while (total_size > max_size) {
+    Entry& last = entries.back();
+    auto range = by_hash.equal_range(last.hash);
+    for (auto it = range.first ; it != range.second ; ++it) {
+      if (&*it->second == &last) {
+        by_hash.erase(it);
+        break;
+      }
+    }
+    total_size -= last.size;
+    entries.pop_back();
+  }
+}
+
+void GeneratedImageCache::clear() {
+  wxMutexLocker lock(mutex);
+  by_hash.clear();
+  entries.clear();
+  total_size = 0;
+}
+
 // ----------------------------------------------------------------------------- : BlankImage
 
 Image BlankImage::generate(const Options& opt) const {
@@ -93,12 +197,16 @@ bool BlankImage::operator == (const GeneratedImage& that) const {
   const BlankImage* that2 = dynamic_cast<const BlankImage*>(&that);
   return that2;
 }
+size_t BlankImage::computeHash() const {
+  size_t h = typeid(BlankImage).hash_code();
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : LinearBlendImage
 
 Image LinearBlendImage::generate(const Options& opt) const {
-  Image img = image1->generate(opt);
-  linear_blend(img, image2->generate(opt), x1, y1, x2, y2);
+  Image img = image1->generateCached(opt);
+  linear_blend(img, image2->generateCached(opt), x1, y1, x2, y2);
   return img;
 }
 ImageCombine LinearBlendImage::combine() const {
@@ -111,12 +219,22 @@ bool LinearBlendImage::operator == (const GeneratedImage& that) const {
                && x1 == that2->x1 && y1 == that2->y1
                && x2 == that2->x2 && y2 == that2->y2;
 }
+size_t LinearBlendImage::computeHash() const {
+  size_t h = typeid(LinearBlendImage).hash_code();
+  hash_combine(h, image1);
+  hash_combine(h, image2);
+  hash_combine(h, x1);
+  hash_combine(h, y1);
+  hash_combine(h, x2);
+  hash_combine(h, y2);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : MaskedBlendImage
 
 Image MaskedBlendImage::generate(const Options& opt) const {
-  Image img = light->generate(opt);
-  mask_blend(img, dark->generate(opt), mask->generate(opt));
+  Image img = light->generateCached(opt);
+  mask_blend(img, dark->generateCached(opt), mask->generateCached(opt));
   return img;
 }
 ImageCombine MaskedBlendImage::combine() const {
@@ -128,12 +246,19 @@ bool MaskedBlendImage::operator == (const GeneratedImage& that) const {
                && *dark  == *that2->dark
                && *mask  == *that2->mask;
 }
+size_t MaskedBlendImage::computeHash() const {
+  size_t h = typeid(MaskedBlendImage).hash_code();
+  hash_combine(h, light);
+  hash_combine(h, dark);
+  hash_combine(h, mask);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : CombineBlendImage
 
 Image CombineBlendImage::generate(const Options& opt) const {
-  Image img = image1->generate(opt);
-  combine_image(img, image2->generate(opt), image_combine);
+  Image img = image1->generateCached(opt);
+  combine_image(img, image2->generateCached(opt), image_combine);
   return img;
 }
 ImageCombine CombineBlendImage::combine() const {
@@ -145,12 +270,19 @@ bool CombineBlendImage::operator == (const GeneratedImage& that) const {
                && *image2 == *that2->image2
                && image_combine == that2->image_combine;
 }
+size_t CombineBlendImage::computeHash() const {
+  size_t h = typeid(CombineBlendImage).hash_code();
+  hash_combine(h, image1);
+  hash_combine(h, image2);
+  hash_combine(h, image_combine);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : SetMaskImage
 
 Image SetMaskImage::generate(const Options& opt) const {
-  Image img = image->generate(opt);
-  set_alpha(img, mask->generate(opt));
+  Image img = image->generateCached(opt);
+  set_alpha(img, mask->generateCached(opt));
   return img;
 }
 bool SetMaskImage::operator == (const GeneratedImage& that) const {
@@ -158,9 +290,15 @@ bool SetMaskImage::operator == (const GeneratedImage& that) const {
   return that2 && *image == *that2->image
                && *mask  == *that2->mask;
 }
+size_t SetMaskImage::computeHash() const {
+  size_t h = typeid(SetMaskImage).hash_code();
+  hash_combine(h, image);
+  hash_combine(h, mask);
+  return h;
+}
 
 Image SetAlphaImage::generate(const Options& opt) const {
-  Image img = image->generate(opt);
+  Image img = image->generateCached(opt);
   set_alpha(img, alpha);
   return img;
 }
@@ -169,11 +307,17 @@ bool SetAlphaImage::operator == (const GeneratedImage& that) const {
   return that2 && *image == *that2->image
                && alpha  == that2->alpha;
 }
+size_t SetAlphaImage::computeHash() const {
+  size_t h = typeid(SetAlphaImage).hash_code();
+  hash_combine(h, image);
+  hash_combine(h, alpha);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : SetCombineImage
 
 Image SetCombineImage::generate(const Options& opt) const {
-  return image->generate(opt);
+  return image->generateCached(opt);
 }
 ImageCombine SetCombineImage::combine() const {
   return image_combine;
@@ -183,11 +327,17 @@ bool SetCombineImage::operator == (const GeneratedImage& that) const {
   return that2 && *image == *that2->image
                && image_combine == that2->image_combine;
 }
+size_t SetCombineImage::computeHash() const {
+  size_t h = typeid(SetCombineImage).hash_code();
+  hash_combine(h, image);
+  hash_combine(h, image_combine);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : SaturateImage
 
 Image SaturateImage::generate(const Options& opt) const {
-  Image img = image->generate(opt);
+  Image img = image->generateCached(opt);
   saturate(img, amount);
   return img;
 }
@@ -196,11 +346,17 @@ bool SaturateImage::operator == (const GeneratedImage& that) const {
   return that2 && *image == *that2->image
                && amount == that2->amount;
 }
+size_t SaturateImage::computeHash() const {
+  size_t h = typeid(SaturateImage).hash_code();
+  hash_combine(h, image);
+  hash_combine(h, amount);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : InvertImage
 
 Image InvertImage::generate(const Options& opt) const {
-  Image img = image->generate(opt);
+  Image img = image->generateCached(opt);
   invert(img);
   return img;
 }
@@ -208,11 +364,16 @@ bool InvertImage::operator == (const GeneratedImage& that) const {
   const InvertImage* that2 = dynamic_cast<const InvertImage*>(&that);
   return that2 && *image == *that2->image;
 }
+size_t InvertImage::computeHash() const {
+  size_t h = typeid(InvertImage).hash_code();
+  hash_combine(h, image);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : RecolorImage
 
 Image RecolorImage::generate(const Options& opt) const {
-  Image img = image->generate(opt);
+  Image img = image->generateCached(opt);
   recolor(img, color);
   return img;
 }
@@ -221,9 +382,15 @@ bool RecolorImage::operator == (const GeneratedImage& that) const {
   return that2 && *image == *that2->image
                && color == that2->color;
 }
+size_t RecolorImage::computeHash() const {
+  size_t h = typeid(RecolorImage).hash_code();
+  hash_combine(h, image);
+  hash_combine(h, color);
+  return h;
+}
 
 Image RecolorImage2::generate(const Options& opt) const {
-  Image img = image->generate(opt);
+  Image img = image->generateCached(opt);
   recolor(img, red,green,blue,white);
   return img;
 }
@@ -235,29 +402,48 @@ bool RecolorImage2::operator == (const GeneratedImage& that) const {
                && blue == that2->blue
                && white == that2->white;
 }
+size_t RecolorImage2::computeHash() const {
+  size_t h = typeid(RecolorImage2).hash_code();
+  hash_combine(h, image);
+  hash_combine(h, red);
+  hash_combine(h, green);
+  hash_combine(h, blue);
+  hash_combine(h, white);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : FlipImage
 
 Image FlipImageHorizontal::generate(const Options& opt) const {
-  Image img = image->generate(opt);
+  Image img = image->generateCached(opt);
   return flip_image_horizontal(img);
 }
 bool FlipImageHorizontal::operator == (const GeneratedImage& that) const {
   const FlipImageHorizontal* that2 = dynamic_cast<const FlipImageHorizontal*>(&that);
   return that2 && *image == *that2->image;
 }
+size_t FlipImageHorizontal::computeHash() const {
+  size_t h = typeid(FlipImageHorizontal).hash_code();
+  hash_combine(h, image);
+  return h;
+}
 
 Image FlipImageVertical::generate(const Options& opt) const {
-  Image img = image->generate(opt);
+  Image img = image->generateCached(opt);
   return flip_image_vertical(img);
 }
 bool FlipImageVertical::operator == (const GeneratedImage& that) const {
   const FlipImageVertical* that2 = dynamic_cast<const FlipImageVertical*>(&that);
   return that2 && *image == *that2->image;
 }
+size_t FlipImageVertical::computeHash() const {
+  size_t h = typeid(FlipImageVertical).hash_code();
+  hash_combine(h, image);
+  return h;
+}
 
 Image RotateImage::generate(const Options& opt) const {
-  Image img = image->generate(opt);
+  Image img = image->generateCached(opt);
   return rotate_image(img,angle);
 }
 bool RotateImage::operator == (const GeneratedImage& that) const {
@@ -265,6 +451,12 @@ bool RotateImage::operator == (const GeneratedImage& that) const {
   return that2 && *image == *that2->image
                && angle == that2->angle;
 }
+size_t RotateImage::computeHash() const {
+  size_t h = typeid(RotateImage).hash_code();
+  hash_combine(h, image);
+  hash_combine(h, angle);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : EnlargeImage
 
@@ -276,7 +468,7 @@ Image EnlargeImage::generate(const Options& opt) const {
     , opt.package
     , opt.local_package
     , opt.preserve_aspect);
-  Image img = image->generate(sub_opt);
+  Image img = image->generateCached(sub_opt);
   // size of generated image
   int w  = img.GetWidth(),  h = img.GetHeight();  // original image size
   int dw = int(w * border_size), dh = int(h * border_size); // delta
@@ -303,11 +495,17 @@ bool EnlargeImage::operator == (const GeneratedImage& that) const {
   return that2 && *image      == *that2->image
                && border_size == that2->border_size;
 }
+size_t EnlargeImage::computeHash() const {
+  size_t h = typeid(EnlargeImage).hash_code();
+  hash_combine(h, image);
+  hash_combine(h, border_size);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : CropImage
 
 Image CropImage::generate(const Options& opt) const {
-  return image->generate(opt).Size(wxSize((int)width, (int)height), wxPoint(-(int)offset_x, -(int)offset_y));
+  return image->generateCached(opt).Size(wxSize((int)width, (int)height), wxPoint(-(int)offset_x, -(int)offset_y));
 }
 bool CropImage::operator == (const GeneratedImage& that) const {
   const CropImage* that2 = dynamic_cast<const CropImage*>(&that);
@@ -315,6 +513,15 @@ bool CropImage::operator == (const GeneratedImage& that) const {
                && width    == that2->width    && height   == that2->height
                && offset_x == that2->offset_x && offset_y == that2->offset_y;
 }
+size_t CropImage::computeHash() const {
+  size_t h = typeid(CropImage).hash_code();
+  hash_combine(h, image);
+  hash_combine(h, width);
+  hash_combine(h, height);
+  hash_combine(h, offset_x);
+  hash_combine(h, offset_y);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : DropShadowImage
 
@@ -369,7 +576,7 @@ UInt gaussian_blur(Byte* in, UInt* out, int w, int h, double radius) {
 
 Image DropShadowImage::generate(const Options& opt) const {
   // sub image
-  Image img = image->generate(opt);
+  Image img = image->generateCached(opt);
   if (!img.HasAlpha()) {
     // no alpha, there is nothing we can do
     return img;
@@ -407,6 +614,16 @@ bool DropShadowImage::operator == (const GeneratedImage& that) const {
                && shadow_alpha == that2->shadow_alpha && shadow_blur_radius == that2->shadow_blur_radius
                && shadow_color == that2->shadow_color;
 }
+size_t DropShadowImage::computeHash() const {
+  size_t h = typeid(DropShadowImage).hash_code();
+  hash_combine(h, image);
+  hash_combine(h, offset_x);
+  hash_combine(h, offset_y);
+  hash_combine(h, shadow_alpha);
+  hash_combine(h, shadow_blur_radius);
+  hash_combine(h, shadow_color);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : PackagedImage
 
@@ -414,11 +631,9 @@ Image PackagedImage::generate(const Options& opt) const {
   // TODO : use opt.width and opt.height?
   // open file from package
   if (!opt.package) throw ScriptError(_("Can only load images in a context where an image is expected"));
-  auto file_stream = opt.package->openIn(filename);
-  Image img;
-  if (image_load_file(img, *file_stream)) {
-    if (img.HasMask()) img.InitAlpha(); // we can't handle masks
-    return img;
+  DecodedImageP img = decoded_image_pool.load(*opt.package, filename);
+  if (img) {
+    return img->Copy();
   } else {
     throw ScriptError(_("Unable to load image '") + filename + _("' from '" + opt.package->name() + _("'")));
   }
@@ -427,6 +642,11 @@ bool PackagedImage::operator == (const GeneratedImage& that) const {
   const PackagedImage* that2 = dynamic_cast<const PackagedImage*>(&that);
   return that2 && filename == that2->filename;
 }
+size_t PackagedImage::computeHash() const {
+  size_t h = typeid(PackagedImage).hash_code();
+  hash_combine(h, filename);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : BuiltInImage
 
@@ -442,6 +662,11 @@ bool BuiltInImage::operator == (const GeneratedImage& that) const {
   const BuiltInImage* that2 = dynamic_cast<const BuiltInImage*>(&that);
   return that2 && name == that2->name;
 }
+size_t BuiltInImage::computeHash() const {
+  size_t h = typeid(BuiltInImage).hash_code();
+  hash_combine(h, name);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : SymbolToImage
 
@@ -478,6 +703,14 @@ bool SymbolToImage::operator == (const GeneratedImage& that) const {
                    *variation == *that2->variation // custom variation
                   );
 }
+size_t SymbolToImage::computeHash() const {
+  size_t h = typeid(SymbolToImage).hash_code();
+  hash_combine(h, is_local);
+  hash_combine(h, filename.toStringForKey());
+  hash_combine(h, age.get());
+  hash_combine(h, variation->border_radius);
+  return h;
+}
 
 // ----------------------------------------------------------------------------- : ImageValueToImage
 
@@ -504,3 +737,9 @@ bool ImageValueToImage::operator == (const GeneratedImage& that) const {
   return that2 && filename == that2->filename
                && age      == that2->age;
 }
+size_t ImageValueToImage::computeHash() const {
+  size_t h = typeid(ImageValueToImage).hash_code();
+  hash_combine(h, filename.toStringForKey());
+  hash_combine(h, age.get());
+  return h;
+}
@@ -13,6 +13,7 @@
 #include <util/io/package.hpp>
 #include <gfx/gfx.hpp>
 #include <script/value.hpp>
+#include <list>
 
 DECLARE_POINTER_TYPE(GeneratedImage);
 DECLARE_POINTER_TYPE(SymbolVariation);
@@ -47,11 +48,22 @@ public:
   Image generateConform(const Options&) const;
   /// Generate the image
   virtual Image generate(const Options&) const = 0;
+  /// Generate the image, or get it from the generated_image_cache
+  /** Images that are equal and are generated with the same options are only generated once.
+   *  Composite images use this to generate their parts, so the parts are shared as well.
+   *  The result is always a copy, it can be modified by the caller.
+   */
+  Image generateCached(const Options&) const;
   /// How must the image be combined with the background?
   virtual ImageCombine combine() const { return COMBINE_DEFAULT; }
   /// Equality should mean that every pixel in the generated images is the same if the same options are used
   virtual bool operator == (const GeneratedImage& that) const = 0;
   inline  bool operator != (const GeneratedImage& that) const { return !(*this == that); }
+  /// Hash of the structure of this image, images that are equal must have the same hash
+  /** The hash is only computed once, generated images don't change after construction */
+  size_t hash() const;
+  /// Compute the hash, including the hashes of the images this image is made of
+  virtual size_t computeHash() const = 0;
   
   /// Can this image be generated safely from another thread?
   virtual bool threadSafe() const { return true; }
@@ -59,15 +71,60 @@ public:
   virtual bool local() const { return false; }
   /// Is this image blank?
   virtual bool isBlank() const { return false; }
+  /// Is it worth storing this image in the generated_image_cache?
+  /** Returns false for images that are cheaper to generate than to copy */
+  virtual bool worthCaching() const { return true; }
   
   ScriptType type() const override;
   String typeName() const override;
   GeneratedImageP toImage() const override;
+  
+private:
+  mutable atomic<size_t> hash_value = 0; ///< The hash, or 0 if it has not been computed yet
 };
 
 /// Resize an image to conform to the options
 Image conform_image(const Image&, const GeneratedImage::Options&);
 
+// ----------------------------------------------------------------------------- : GeneratedImageCache
+
+/// A cache of generated images, shared by the whole program
+/** Images are found by their structure (GeneratedImage::hash and operator ==)
+ *  together with the options they were generated with.
+ *  When the images take more than max_size bytes, the least recently used ones are removed.
+ *  All functions are thread safe.
+ */
+class GeneratedImageCache {
+public:
+  GeneratedImageCache(size_t max_size);
+  
+  /// Find an image in the cache, returns a copy of it, or an invalid image if it is not found
+  Image find(const GeneratedImage& image, const GeneratedImage::Options& options);
+  /// Store a generated image in the cache
+  void add(const GeneratedImage& image, const GeneratedImage::Options& options, const Image& generated);
+  /// Remove all images from the cache, for instance because packages were reloaded
+  void clear();
+  
+private:
+  struct Entry {
+    size_t                   hash;
+    GeneratedImageP          image;
+    GeneratedImage::Options  options;
+    Image                    generated;
+    size_t                   size; ///< Size of generated in bytes
+  };
+  wxMutex                 mutex;
+  list<Entry>             entries; ///< Most recently used first
+  unordered_multimap<size_t, list<Entry>::iterator> by_hash;
+  size_t                  max_size, total_size;
+  
+  /// Find an entry, must be called with the mutex locked
+  list<Entry>::iterator findEntry(size_t hash, const GeneratedImage& image, const GeneratedImage::Options& options);
+};
+
+/// The cache used by GeneratedImage::generateCached
+extern GeneratedImageCache generated_image_cache;
+
 // ----------------------------------------------------------------------------- : SimpleFilterImage
 
 /// Apply some filter to a single image
@@ -89,7 +146,9 @@ class BlankImage : public GeneratedImage {
 public:
   Image generate(const Options&) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
   bool isBlank() const override { return true; }
+  bool worthCaching() const override { return false; }
   
   // Why is this not thread safe? What is GTK smoking?
   #ifdef __WXGTK__
@@ -108,6 +167,7 @@ public:
   Image generate(const Options& opt) const override;
   ImageCombine combine() const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
   bool local() const override { return image1->local() && image2->local(); }
 private:
   GeneratedImageP image1, image2;
@@ -125,6 +185,7 @@ public:
   Image generate(const Options& opt) const override;
   ImageCombine combine() const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
   bool local() const override { return light->local() && dark->local() && mask->local(); }
 private:
   GeneratedImageP light, dark, mask;
@@ -141,6 +202,7 @@ public:
   Image generate(const Options& opt) const override;
   ImageCombine combine() const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
   bool local() const override { return image1->local() && image2->local(); }
 private:
   GeneratedImageP image1, image2;
@@ -157,6 +219,7 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
 private:
   GeneratedImageP mask;
 };
@@ -169,6 +232,7 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
 private:
   double alpha;
 };
@@ -184,6 +248,8 @@ public:
   Image generate(const Options& opt) const override;
   ImageCombine combine() const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
+  bool worthCaching() const override { return false; }
 private:
   ImageCombine image_combine;
 };
@@ -198,6 +264,7 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
 private:
   double amount;
 };
@@ -212,6 +279,7 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
 };
 
 // ----------------------------------------------------------------------------- : RecolorImage
@@ -224,6 +292,7 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
 private:
   Color color;
 };
@@ -235,6 +304,7 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
 private:
   Color red,green,blue,white;
 };
@@ -249,6 +319,7 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
 };
 
 /// Flip an image vertically
@@ -259,6 +330,7 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
 };
 
 /// Rotate an image
@@ -269,6 +341,7 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
 private:
   Radians angle;
 };
@@ -283,6 +356,7 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
 private:
   double border_size;
 };
@@ -297,6 +371,7 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
 private:
   double width, height;
   double offset_x, offset_y;
@@ -313,6 +388,7 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
 private:
   double offset_x, offset_y;
   double shadow_alpha;
@@ -330,6 +406,8 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
+  bool worthCaching() const override { return false; } // already in the decoded_image_pool
 private:
   String filename;
 };
@@ -344,6 +422,7 @@ public:
   {}
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
 private:
   String name;
 };
@@ -357,6 +436,7 @@ public:
   ~SymbolToImage();
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
   bool local() const override { return is_local; }
   
   #ifdef __WXGTK__
@@ -379,6 +459,7 @@ public:
   ~ImageValueToImage();
   Image generate(const Options& opt) const override;
   bool operator == (const GeneratedImage& that) const override;
+  size_t computeHash() const override;
   bool local() const override { return true; }
 private:
   ImageValueToImage(const ImageValueToImage&); // copy ctor
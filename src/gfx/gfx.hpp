@@ -54,6 +54,10 @@ void sharp_resample_and_clip(const Image& img_in, Image& img_out, wxRect rect, i
  */
 void draw_resampled_text(DC& dc, const RealPoint& pos, const RealRect& rect, double stretch, Radians angle, Color color, const String& text, int blur_radius = 0, int repeat = 1);
 
+/// Render text like draw_resampled_text, but return the image instead of drawing it
+/** The image should be drawn with its top left corner at img_pos */
+Image render_resampled_text(const wxFont& font, const RealPoint& pos, const RealRect& rect, double stretch, Radians angle, Color color, const String& text, int blur_radius, wxPoint& img_pos);
+
 // scaling factor to use when drawing resampled text
 extern const int text_scaling;
 
@@ -0,0 +1,213 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+/** @file gfx/image_kernels.hpp
+ *
+ *  The inner loops of the image functions, working on arrays of bytes.
+ *  When simd_enabled is set, the kernels use SSE2 for blocks of 16 bytes, and scalar code for the rest.
+ *  Both give exactly the same results, test/gfx/image_kernels.cpp checks this.
+ */
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <gfx/gfx.hpp>
+#include <gfx/simd.hpp>
+
+// ----------------------------------------------------------------------------- : Combining functions
+
+// Functor for combining functions for a given combining type
+template <ImageCombine combine> struct Combine {
+  static inline int f(int a, int b);
+};
+
+// Give a combining function for enum value 'combine'
+#define COMBINE_FUN(combine,fun) \
+  template <> inline int Combine<combine>::f(int a, int b) { return fun; }
+
+// Based on
+//  http://www.pegtop.net/delphi/articles/blendmodes/
+
+COMBINE_FUN(COMBINE_NORMAL,      b)
+COMBINE_FUN(COMBINE_ADD,         top(a + b))
+COMBINE_FUN(COMBINE_SUBTRACT,    bot(a - b))
+COMBINE_FUN(COMBINE_STAMP,       col(a - 2 * b + 256))
+COMBINE_FUN(COMBINE_DIFFERENCE,  abs(a - b))
+COMBINE_FUN(COMBINE_NEGATION,    255 - abs(255 - a - b))
+COMBINE_FUN(COMBINE_MULTIPLY,    (a * b) / 255)
+COMBINE_FUN(COMBINE_DARKEN,      min(a, b))
+COMBINE_FUN(COMBINE_LIGHTEN,     max(a, b))
+COMBINE_FUN(COMBINE_COLOR_DODGE, b == 255 ? 255 : top(a * 255 / (255 - b)))
+COMBINE_FUN(COMBINE_COLOR_BURN,  b == 0   ? 0   : bot(255 - (255-a) * 255 / b))
+COMBINE_FUN(COMBINE_SCREEN,      255 - (((255 - a) * (255 - b)) / 255))
+COMBINE_FUN(COMBINE_OVERLAY,  a < 128
+                  ? (a * b) >> 7
+                  : 255 - (((255 - a) * (255 - b)) >> 7))
+COMBINE_FUN(COMBINE_HARD_LIGHT,  b < 128
+                  ? (a * b) >> 7
+                  : 255 - (((255 - a) * (255 - b)) >> 7))
+COMBINE_FUN(COMBINE_SOFT_LIGHT,  b)
+COMBINE_FUN(COMBINE_REFLECT,     b == 255 ? 255 : top(a * a / (255 - b)))
+COMBINE_FUN(COMBINE_GLOW,        a == 255 ? 255 : top(b * b / (255 - a)))
+COMBINE_FUN(COMBINE_FREEZE,      b == 0 ? 0 : bot(255 - (255 - a) * (255 - a) / b))
+COMBINE_FUN(COMBINE_HEAT,        a == 0 ? 0 : bot(255 - (255 - b) * (255 - b) / a))
+COMBINE_FUN(COMBINE_AND,         a & b)
+COMBINE_FUN(COMBINE_OR,          a | b)
+COMBINE_FUN(COMBINE_XOR,         a ^ b)
+COMBINE_FUN(COMBINE_SHADOW,      (b * a * a) / (255 * 255))
+COMBINE_FUN(COMBINE_SYMMETRIC_OVERLAY, (Combine<COMBINE_OVERLAY>::f(a,b) + Combine<COMBINE_OVERLAY>::f(b,a)) / 2 )
+
+#undef COMBINE_FUN
+
+// ----------------------------------------------------------------------------- : Combining functions, SSE2
+
+// Versions of the combining functions that work on 16 bytes at once
+// Only for the modes that can be done exactly without division
+template <ImageCombine combine> struct CombineSIMD {
+  static const bool available = false;
+};
+
+#if USE_SSE2
+  #define COMBINE_FUN_SIMD(combine,fun) \
+    template <> struct CombineSIMD<combine> { \
+      static const bool available = true; \
+      static inline __m128i f(__m128i a, __m128i b) { return fun; } \
+    };
+  #define NOT(x) _mm_xor_si128(x, _mm_set1_epi8(-1))
+
+  COMBINE_FUN_SIMD(COMBINE_ADD,        _mm_adds_epu8(a, b))
+  COMBINE_FUN_SIMD(COMBINE_SUBTRACT,   _mm_subs_epu8(a, b))
+  COMBINE_FUN_SIMD(COMBINE_DIFFERENCE, _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a)))
+  COMBINE_FUN_SIMD(COMBINE_MULTIPLY,   mul_div255_epu8(a, b))
+  COMBINE_FUN_SIMD(COMBINE_DARKEN,     _mm_min_epu8(a, b))
+  COMBINE_FUN_SIMD(COMBINE_LIGHTEN,    _mm_max_epu8(a, b))
+  COMBINE_FUN_SIMD(COMBINE_SCREEN,     NOT(mul_div255_epu8(NOT(a), NOT(b))))
+  COMBINE_FUN_SIMD(COMBINE_AND,        _mm_and_si128(a, b))
+  COMBINE_FUN_SIMD(COMBINE_OR,         _mm_or_si128(a, b))
+  COMBINE_FUN_SIMD(COMBINE_XOR,        _mm_xor_si128(a, b))
+
+  #undef NOT
+  #undef COMBINE_FUN_SIMD
+#endif
+
+// ----------------------------------------------------------------------------- : Kernels : combining and blending
+
+/// a[i] = combine(a[i], b[i]) for n bytes
+template <ImageCombine combine>
+void combine_bytes(Byte* a, const Byte* b, size_t n) {
+  size_t i = 0;
+  #if USE_SSE2
+    if constexpr (CombineSIMD<combine>::available) {
+      if (simd_enabled) {
+        for ( ; i + 16 <= n ; i += 16) {
+          store16(a + i, CombineSIMD<combine>::f(load16(a + i), load16(b + i)));
+        }
+      }
+    }
+  #endif
+  for ( ; i < n ; ++i) {
+    a[i] = Combine<combine>::f(a[i], b[i]);
+  }
+}
+
+/// a[i] = (a[i] * m[i] + b[i] * (255 - m[i])) / 255 for n bytes
+inline void mask_blend_bytes(Byte* a, const Byte* b, const Byte* m, size_t n) {
+  size_t i = 0;
+  #if USE_SSE2
+    if (simd_enabled) {
+      for ( ; i + 16 <= n ; i += 16) {
+        store16(a + i, blend_div255_epu8(load16(a + i), load16(b + i), load16(m + i)));
+      }
+    }
+  #endif
+  for ( ; i < n ; ++i) {
+    a[i] = (a[i] * m[i] + b[i] * (255 - m[i])) / 255;
+  }
+}
+
+/// a[i] = (a[i] * b[i]) / 255 for n bytes
+inline void multiply_bytes(Byte* a, const Byte* b, size_t n) {
+  size_t i = 0;
+  #if USE_SSE2
+    if (simd_enabled) {
+      for ( ; i + 16 <= n ; i += 16) {
+        store16(a + i, mul_div255_epu8(load16(a + i), load16(b + i)));
+      }
+    }
+  #endif
+  for ( ; i < n ; ++i) {
+    a[i] = (a[i] * b[i]) / 255;
+  }
+}
+
+/// a[i] = (a[i] * b) / 255 for n bytes
+inline void multiply_bytes(Byte* a, Byte b, size_t n) {
+  size_t i = 0;
+  #if USE_SSE2
+    if (simd_enabled) {
+      __m128i b16 = _mm_set1_epi8((char)b);
+      for ( ; i + 16 <= n ; i += 16) {
+        store16(a + i, mul_div255_epu8(load16(a + i), b16));
+      }
+    }
+  #endif
+  for ( ; i < n ; ++i) {
+    a[i] = (a[i] * b) / 255;
+  }
+}
+
+// ----------------------------------------------------------------------------- : Kernels : resampling
+
+/// tot[i] += in[i] * amount for n bytes, amount must be less than 1<<16
+inline void accumulate_bytes(UInt* tot, const Byte* in, UInt amount, size_t n) {
+  assert(amount < (1 << 16));
+  size_t i = 0;
+  #if USE_SSE2
+    if (simd_enabled) {
+      __m128i zero = _mm_setzero_si128();
+      __m128i amt  = _mm_set1_epi16((short)amount);
+      for ( ; i + 16 <= n ; i += 16) {
+        __m128i x  = load16(in + i);
+        __m128i lo = _mm_unpacklo_epi8(x, zero);
+        __m128i hi = _mm_unpackhi_epi8(x, zero);
+        // the 32 bit products are put together from their low and high halves
+        __m128i lo_l = _mm_mullo_epi16(lo, amt), lo_h = _mm_mulhi_epu16(lo, amt);
+        __m128i hi_l = _mm_mullo_epi16(hi, amt), hi_h = _mm_mulhi_epu16(hi, amt);
+        __m128i* t = reinterpret_cast<__m128i*>(tot + i);
+        _mm_storeu_si128(t + 0, _mm_add_epi32(_mm_loadu_si128(t + 0), _mm_unpacklo_epi16(lo_l, lo_h)));
+        _mm_storeu_si128(t + 1, _mm_add_epi32(_mm_loadu_si128(t + 1), _mm_unpackhi_epi16(lo_l, lo_h)));
+        _mm_storeu_si128(t + 2, _mm_add_epi32(_mm_loadu_si128(t + 2), _mm_unpacklo_epi16(hi_l, hi_h)));
+        _mm_storeu_si128(t + 3, _mm_add_epi32(_mm_loadu_si128(t + 3), _mm_unpackhi_epi16(hi_l, hi_h)));
+      }
+    }
+  #endif
+  for ( ; i < n ; ++i) {
+    tot[i] += in[i] * amount;
+  }
+}
+
+/// out[i] = tot[i] >> shift for n bytes, all results must fit in a byte
+inline void shift_bytes(Byte* out, const UInt* tot, int shift, size_t n) {
+  size_t i = 0;
+  #if USE_SSE2
+    if (simd_enabled) {
+      __m128i count = _mm_cvtsi32_si128(shift);
+      for ( ; i + 16 <= n ; i += 16) {
+        const __m128i* t = reinterpret_cast<const __m128i*>(tot + i);
+        __m128i a = _mm_srl_epi32(_mm_loadu_si128(t + 0), count);
+        __m128i b = _mm_srl_epi32(_mm_loadu_si128(t + 1), count);
+        __m128i c = _mm_srl_epi32(_mm_loadu_si128(t + 2), count);
+        __m128i d = _mm_srl_epi32(_mm_loadu_si128(t + 3), count);
+        store16(out + i, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+      }
+    }
+  #endif
+  for ( ; i < n ; ++i) {
+    out[i] = (Byte)(tot[i] >> shift);
+  }
+}
@@ -0,0 +1,72 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <gfx/image_pool.hpp>
+#include <util/io/package.hpp>
+#include <gui/util.hpp> // image_load_file
+
+// ----------------------------------------------------------------------------- : DecodedImagePool
+
+DecodedImagePool decoded_image_pool(64 * 1024 * 1024);
+
+DecodedImagePool::DecodedImagePool(size_t max_size)
+  : max_size(max_size), total_size(0)
+{}
+
+bool DecodedImagePool::Key::operator < (const Key& that) const {
+  if (package  != that.package)  return package  < that.package;
+  if (modified != that.modified) return modified < that.modified;
+  return filename < that.filename;
+}
+
+DecodedImageP DecodedImagePool::load(Package& package, const String& filename) {
+  Key key = {&package, filename, package.modificationTime(filename).GetValue()};
+  // already decoded?
+  {
+    wxMutexLocker lock(mutex);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+      recently_used.splice(recently_used.begin(), recently_used, it->second.use);
+      return it->second.image;
+    }
+  }
+  // decode, without holding the lock
+  auto stream = package.openIn(filename);
+  auto img = make_shared<Image>();
+  if (!image_load_file(*img, *stream)) return nullptr;
+  if (img->HasMask()) img->InitAlpha(); // we can't handle masks
+  size_t size = (size_t)img->GetWidth() * img->GetHeight() * (img->HasAlpha() ? 4 : 3);
+  // add to the pool
+  wxMutexLocker lock(mutex);
+  auto inserted = entries.emplace(key, Entry{img, size, recently_used.end()});
+  Entry& entry = inserted.first->second;
+  if (!inserted.second) {
+    // another thread decoded the same image in the meantime
+    recently_used.splice(recently_used.begin(), recently_used, entry.use);
+    return entry.image;
+  }
+  recently_used.push_front(key);
+  entry.use = recently_used.begin();
+  total_size += size;
+  // remove least recently used images, but keep the one we just added
+  while (total_size > max_size && recently_used.size() > 1) {
+    auto last = entries.find(recently_used.back());
+    total_size -= last->second.size;
+    entries.erase(last);
+    recently_used.pop_back();
+  }
+  return img;
+}
+
+void DecodedImagePool::clear() {
+  wxMutexLocker lock(mutex);
+  entries.clear();
+  recently_used.clear();
+  total_size = 0;
+}
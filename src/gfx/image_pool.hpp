@@ -0,0 +1,58 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <list>
+
+class Package;
+
+// ----------------------------------------------------------------------------- : DecodedImagePool
+
+/// An image decoded from a file, shared by all users of that file
+/** The image must not be modified, use Copy() to get an image that can be modified */
+typedef shared_ptr<const Image> DecodedImageP;
+
+/// A pool of images decoded from files in packages
+/** Images are identified by the package, the filename and the modification time of the file,
+ *  so an image file that is changed is decoded again.
+ *  When the images in the pool take more than max_size bytes, the least recently used ones are removed
+ *  from the pool. Users that still hold on to such an image can keep using it.
+ *  All functions are thread safe.
+ */
+class DecodedImagePool {
+public:
+  DecodedImagePool(size_t max_size);
+  
+  /// Load an image from a package, or get it from the pool if it was loaded before
+  /** Returns nullptr if the file is not a valid image. Throws if the file can't be opened. */
+  DecodedImageP load(Package& package, const String& filename);
+  /// Remove all images from the pool, for instance because packages were reloaded
+  void clear();
+  
+private:
+  struct Key {
+    Package*   package;
+    String     filename;
+    wxLongLong modified;
+    bool operator < (const Key& that) const;
+  };
+  struct Entry {
+    DecodedImageP        image;
+    size_t               size; ///< Size of the image in bytes
+    list<Key>::iterator  use;  ///< Position in recently_used
+  };
+  wxMutex          mutex;
+  map<Key,Entry>   entries;
+  list<Key>        recently_used; ///< Most recently used first
+  size_t           max_size, total_size;
+};
+
+/// The pool used for all images loaded from packages
+extern DecodedImagePool decoded_image_pool;
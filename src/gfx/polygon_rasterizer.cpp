@@ -0,0 +1,174 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <gfx/raster.hpp>
+#include <algorithm>
+
+// ----------------------------------------------------------------------------- : PolygonRasterizer
+
+void PolygonRasterizer::addPolygon(const RealPoint* points, size_t count) {
+  for (size_t i = 0 ; i < count ; ++i) {
+    const RealPoint& a = points[i];
+    const RealPoint& b = points[i + 1 < count ? i + 1 : 0];
+    if (a.y == b.y) continue; // horizontal edges don't cross any scanline
+    if (!isfinite(a.x) || !isfinite(a.y) || !isfinite(b.x) || !isfinite(b.y)) continue;
+    Edge e;
+    if (a.y < b.y) {
+      e.x0 = a.x; e.y0 = a.y; e.x1 = b.x; e.y1 = b.y; e.dir = 1;
+    } else {
+      e.x0 = b.x; e.y0 = b.y; e.x1 = a.x; e.y1 = a.y; e.dir = -1;
+    }
+    e.dxdy = (e.x1 - e.x0) / (e.y1 - e.y0);
+    if (!edges.empty() && e.y0 < edges.back().y0) sorted = false;
+    edges.push_back(e);
+    min_x = min(min_x, min(e.x0, e.x1));
+    max_x = max(max_x, max(e.x0, e.x1));
+    min_y = min(min_y, e.y0);
+    max_y = max(max_y, e.y1);
+  }
+}
+
+void PolygonRasterizer::clear() {
+  edges.clear();
+  min_x = min_y =  1e100;
+  max_x = max_y = -1e100;
+  sorted = true;
+}
+
+wxRect PolygonRasterizer::getBounds() const {
+  if (edges.empty()) return wxRect();
+  // don't overflow on far away points, the result is clipped to an image anyway
+  const double limit = 1 << 24;
+  int x0 = (int)floor(max(-limit, min_x)), y0 = (int)floor(max(-limit, min_y));
+  int x1 = (int)ceil (min( limit, max_x)), y1 = (int)ceil (min( limit, max_y));
+  return wxRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+void PolygonRasterizer::render(FillRule rule, const wxRect& rect, vector<Byte>& coverage) {
+  int width = rect.width, height = rect.height;
+  coverage.assign((size_t)max(0, width) * max(0, height), 0);
+  if (width <= 0 || height <= 0 || edges.empty()) return;
+  if (!sorted) {
+    stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.y0 < b.y0; });
+    sorted = true;
+  }
+  partial.assign(width + 1, 0.);
+  runs.assign(width + 1, 0.);
+  active.clear();
+  size_t next_edge = 0;
+  int first_row = max(rect.y, (int)floor(max(-1e9, min_y)));
+  int end_row   = min(rect.y + height, (int)ceil(min(1e9, max_y)));
+  for (int py = first_row ; py < end_row ; ++py) {
+    for (int s = 0 ; s < SUBSAMPLES ; ++s) {
+      double sy = py + (s + 0.5) / SUBSAMPLES;
+      // update the active edges
+      while (next_edge < edges.size() && edges[next_edge].y0 <= sy) {
+        active.push_back(&edges[next_edge++]);
+      }
+      crossings.clear();
+      for (size_t i = 0 ; i < active.size() ; ) {
+        const Edge& e = *active[i];
+        if (e.y1 <= sy) {
+          active[i] = active.back();
+          active.pop_back();
+        } else {
+          crossings.emplace_back(e.x0 + (sy - e.y0) * e.dxdy, e.dir);
+          ++i;
+        }
+      }
+      if (crossings.empty()) continue;
+      sort(crossings.begin(), crossings.end());
+      // accumulate the spans that are inside
+      int winding = 0;
+      double span_start = 0;
+      FOR_EACH(c, crossings) {
+        bool was_inside = rule == FILL_NONZERO ? winding != 0 : (winding & 1) != 0;
+        winding += c.second;
+        bool is_inside  = rule == FILL_NONZERO ? winding != 0 : (winding & 1) != 0;
+        if (!was_inside && is_inside) {
+          span_start = c.first;
+        } else if (was_inside && !is_inside) {
+          double xa = max(0.,           span_start - rect.x);
+          double xb = min((double)width, c.first   - rect.x);
+          if (xb <= xa) continue;
+          int ia = (int)xa, ib = (int)xb;
+          if (ia == ib) {
+            partial[ia] += xb - xa;
+          } else {
+            partial[ia] += ia + 1 - xa;
+            runs[ia + 1] += 1;
+            runs[ib]     -= 1;
+            partial[ib]  += xb - ib;
+          }
+        }
+      }
+    }
+    // store the coverage of this row
+    Byte* out = &coverage[(size_t)(py - rect.y) * width];
+    double run = 0;
+    for (int x = 0 ; x < width ; ++x) {
+      run += runs[x];
+      double c = (partial[x] + run) * (255. / SUBSAMPLES);
+      out[x] = (Byte)min(255, (int)(c + 0.5));
+      partial[x] = runs[x] = 0;
+    }
+    partial[width] = runs[width] = 0;
+  }
+}
+
+void add_arc_points(vector<RealPoint>& out, const RealPoint& center, const RealSize& radius, Radians start, Radians end, double tolerance) {
+  double r = max(fabs(radius.width), fabs(radius.height));
+  // the error of a chord with angle step is r * (1 - cos(step/2))
+  double step = r > tolerance ? 2 * acos(1 - tolerance / r) : M_PI;
+  int count = max(1, (int)ceil(fabs(end - start) / step));
+  for (int i = 0 ; i <= count ; ++i) {
+    double t = start + (end - start) * i / count;
+    out.push_back(RealPoint(center.x + radius.width * cos(t), center.y - radius.height * sin(t)));
+  }
+}
+
+/// Signed area of a polygon, used to give all parts of a stroke the same orientation
+double polygon_area(const vector<RealPoint>& points) {
+  double area = 0;
+  for (size_t i = 0 ; i < points.size() ; ++i) {
+    area += cross(points[i], points[(i + 1) % points.size()]);
+  }
+  return area;
+}
+
+void PolygonRasterizer::addStroke(const vector<RealPoint>& points, bool closed, double width) {
+  if (points.empty()) return;
+  // The stroke is the union of a rectangle for each line segment and a disc at each point (round joins and caps).
+  // With the nonzero rule the union of polygons with the same orientation is exactly what we want.
+  double half = width / 2;
+  vector<RealPoint> part;
+  size_t segments = closed ? points.size() : points.size() - 1;
+  for (size_t i = 0 ; i < segments ; ++i) {
+    const RealPoint& a = points[i];
+    const RealPoint& b = points[(i + 1) % points.size()];
+    RealPoint d = b - a;
+    double length = d.length();
+    if (length <= 0) continue;
+    RealPoint n(-d.y * half / length, d.x * half / length);
+    part.clear();
+    part.push_back(a + n);
+    part.push_back(b + n);
+    part.push_back(b - n);
+    part.push_back(a - n);
+    if (polygon_area(part) < 0) reverse(part.begin(), part.end());
+    addPolygon(part);
+  }
+  FOR_EACH_CONST(p, points) {
+    part.clear();
+    add_arc_points(part, p, RealSize(half, half), 0, 2 * M_PI);
+    part.pop_back(); // same as the first point
+    if (polygon_area(part) < 0) reverse(part.begin(), part.end());
+    addPolygon(part);
+  }
+}
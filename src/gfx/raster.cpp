@@ -0,0 +1,180 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <gfx/raster.hpp>
+#include <algorithm>
+
+// ----------------------------------------------------------------------------- : RasterCanvas : Properties
+
+RasterCanvas::RasterCanvas(int width, int height)
+  : image(width, height, true)
+  , pen_color(0, 0, 0), brush_color(255, 255, 255)
+  , pen_width(1)
+  , clip_rect(0, 0, width, height)
+  , text_bitmap(1, 1)
+{
+  image.InitAlpha();
+  memset(image.GetAlpha(), 0, (size_t)width * height);
+  text_dc.SelectObject(text_bitmap);
+}
+
+void RasterCanvas::setPen(const wxPen& pen) {
+  if (pen.IsOk() && pen.GetStyle() != wxPENSTYLE_TRANSPARENT) {
+    pen_color = pen.GetColour();
+    pen_width = max(1, pen.GetWidth());
+  } else {
+    pen_color = Color(0, 0, 0, 0);
+  }
+}
+
+void RasterCanvas::setBrush(const wxBrush& brush) {
+  if (brush.IsOk() && brush.GetStyle() != wxBRUSHSTYLE_TRANSPARENT) {
+    brush_color = brush.GetColour();
+  } else {
+    brush_color = Color(0, 0, 0, 0);
+  }
+}
+
+void RasterCanvas::setClip(PolygonRasterizer& shape, FillRule rule) {
+  clip_rect = shape.getBounds().Intersect(wxRect(0, 0, getWidth(), getHeight()));
+  if (clip_rect.IsEmpty()) {
+    clip_rect = wxRect(); // nothing will be drawn
+    clip.clear();
+  } else {
+    shape.render(rule, clip_rect, clip);
+  }
+}
+
+void RasterCanvas::resetClip() {
+  clip_rect = wxRect(0, 0, getWidth(), getHeight());
+  clip.clear();
+}
+
+// ----------------------------------------------------------------------------- : RasterCanvas : Blending
+
+/// Draw a pixel with the given opacity over a pixel in the image
+inline void blend_pixel(Byte* dst, Byte& dst_alpha, Byte r, Byte g, Byte b, int a) {
+  if (a == 255 || dst_alpha == 0) {
+    dst[0] = r; dst[1] = g; dst[2] = b;
+    dst_alpha = (Byte)a;
+  } else if (dst_alpha == 255) {
+    dst[0] = (Byte)((r * a + dst[0] * (255 - a)) / 255);
+    dst[1] = (Byte)((g * a + dst[1] * (255 - a)) / 255);
+    dst[2] = (Byte)((b * a + dst[2] * (255 - a)) / 255);
+  } else {
+    // both are partially transparent
+    int da    = dst_alpha * (255 - a) / 255;
+    int out_a = a + da;
+    dst[0] = (Byte)((r * a + dst[0] * da) / out_a);
+    dst[1] = (Byte)((g * a + dst[1] * da) / out_a);
+    dst[2] = (Byte)((b * a + dst[2] * da) / out_a);
+    dst_alpha = (Byte)out_a;
+  }
+}
+
+void RasterCanvas::blendRow(int x, int y, int count, const Byte* coverage, Color color) {
+  size_t offset = (size_t)y * getWidth() + x;
+  Byte* dst       = image.GetData() + 3 * offset;
+  Byte* dst_alpha = image.GetAlpha() + offset;
+  const Byte* clip_row = clip.empty() ? nullptr : &clip[(size_t)(y - clip_rect.y) * clip_rect.width + (x - clip_rect.x)];
+  for (int i = 0 ; i < count ; ++i) {
+    int a = coverage[i] * color.Alpha();
+    if (clip_row) a = a * clip_row[i] / 255;
+    a = (a + 127) / 255;
+    if (a) blend_pixel(dst + 3 * i, dst_alpha[i], color.Red(), color.Green(), color.Blue(), a);
+  }
+}
+
+void RasterCanvas::blendRow(int x, int y, int count, const Byte* rgb, const Byte* alpha) {
+  size_t offset = (size_t)y * getWidth() + x;
+  Byte* dst       = image.GetData() + 3 * offset;
+  Byte* dst_alpha = image.GetAlpha() + offset;
+  const Byte* clip_row = clip.empty() ? nullptr : &clip[(size_t)(y - clip_rect.y) * clip_rect.width + (x - clip_rect.x)];
+  for (int i = 0 ; i < count ; ++i) {
+    int a = alpha ? alpha[i] : 255;
+    if (clip_row) a = (a * clip_row[i] + 127) / 255;
+    if (a) blend_pixel(dst + 3 * i, dst_alpha[i], rgb[3 * i], rgb[3 * i + 1], rgb[3 * i + 2], a);
+  }
+}
+
+// ----------------------------------------------------------------------------- : RasterCanvas : Drawing
+
+void RasterCanvas::clear() {
+  Byte* data = image.GetData();
+  size_t size = (size_t)getWidth() * getHeight();
+  for (size_t i = 0 ; i < size ; ++i) {
+    data[3 * i]     = brush_color.Red();
+    data[3 * i + 1] = brush_color.Green();
+    data[3 * i + 2] = brush_color.Blue();
+  }
+  memset(image.GetAlpha(), brush_color.Alpha(), size);
+}
+
+void RasterCanvas::fill(PolygonRasterizer& shape, FillRule rule, Color color) {
+  if (color.Alpha() == 0) return;
+  wxRect r = shape.getBounds().Intersect(clip_rect);
+  if (r.IsEmpty()) return;
+  shape.render(rule, r, coverage);
+  for (int y = 0 ; y < r.height ; ++y) {
+    blendRow(r.x, r.y + y, r.width, &coverage[(size_t)y * r.width], color);
+  }
+}
+
+void RasterCanvas::drawPolygon(const vector<RealPoint>& points) {
+  fillPolygon(points);
+  strokePolyline(points, true);
+}
+
+void RasterCanvas::fillPolygon(const vector<RealPoint>& points) {
+  if (brush_color.Alpha() == 0 || points.size() < 3) return;
+  shape.clear();
+  shape.addPolygon(points);
+  fill(shape, FILL_EVEN_ODD, brush_color); // the same rule as wxDC::DrawPolygon
+}
+
+void RasterCanvas::strokePolyline(const vector<RealPoint>& points, bool closed) {
+  if (pen_color.Alpha() == 0 || points.empty()) return;
+  shape.clear();
+  shape.addStroke(points, closed, pen_width);
+  fill(shape, FILL_NONZERO, pen_color);
+}
+
+void RasterCanvas::drawImage(const Image& img_in, int x, int y, ImageCombine combine) {
+  wxRect r = wxRect(x, y, img_in.GetWidth(), img_in.GetHeight()).Intersect(clip_rect);
+  if (r.IsEmpty()) return;
+  // bitmaps converted to images can have a mask instead of an alpha channel
+  Image with_alpha;
+  const Image* img = &img_in;
+  if (img_in.HasMask() && !img_in.HasAlpha()) {
+    with_alpha = img_in.Copy();
+    with_alpha.InitAlpha();
+    img = &with_alpha;
+  }
+  if (combine <= COMBINE_NORMAL) {
+    int w = img->GetWidth();
+    for (int j = 0 ; j < r.height ; ++j) {
+      size_t offset = (size_t)(r.y - y + j) * w + (r.x - x);
+      blendRow(r.x, r.y + j, r.width, img->GetData() + 3 * offset, img->HasAlpha() ? img->GetAlpha() + offset : nullptr);
+    }
+  } else {
+    // combine with what is currently on the canvas, then draw the result using the alpha of the image
+    Image src = img->GetSubImage(wxRect(r.x - x, r.y - y, r.width, r.height));
+    Image target = image.GetSubImage(r);
+    target.ClearAlpha();
+    combine_image(target, src, combine);
+    for (int j = 0 ; j < r.height ; ++j) {
+      size_t offset = (size_t)j * r.width;
+      blendRow(r.x, r.y + j, r.width, target.GetData() + 3 * offset, target.HasAlpha() ? target.GetAlpha() + offset : nullptr);
+    }
+  }
+}
+
+Image RasterCanvas::getSubImage(const wxRect& rect) const {
+  return image.GetSubImage(rect.Intersect(wxRect(0, 0, getWidth(), getHeight())));
+}
@@ -0,0 +1,146 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+/** @file gfx/raster.hpp
+ *
+ *  Software rasterization: drawing anti-aliased shapes and images into an RGBA image.
+ *  The shapes are scan converted by us instead of by a DC, so this works without a display.
+ */
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <util/real_point.hpp>
+#include <gfx/gfx.hpp>
+
+// ----------------------------------------------------------------------------- : PolygonRasterizer
+
+/// Which parts of overlapping or self intersecting polygons are inside
+enum FillRule
+{  FILL_NONZERO    ///< inside if the winding number is not zero
+,  FILL_EVEN_ODD   ///< inside if the winding number is odd
+};
+
+/// Computes how much of each pixel is covered by a set of polygons
+/** Pixel (x,y) is the square [x,x+1) * [y,y+1).
+ *  Each row of pixels is sampled with SUBSAMPLES scanlines, on each scanline the exact
+ *  horizontal coverage of the spans that are inside is accumulated.
+ */
+class PolygonRasterizer {
+public:
+  /// Add a closed polygon, the last point is connected to the first one
+  void addPolygon(const RealPoint* points, size_t count);
+  inline void addPolygon(const vector<RealPoint>& points) {
+    if (!points.empty()) addPolygon(points.data(), points.size());
+  }
+  /// Add the outline of a polyline with the given line width, with round joins and caps
+  void addStroke(const vector<RealPoint>& points, bool closed, double width);
+  /// Remove all polygons
+  void clear();
+  inline bool empty() const { return edges.empty(); }
+
+  /// The pixels that are (partially) covered
+  wxRect getBounds() const;
+
+  /// Compute the coverage of the pixels in rect, 0 is not covered, 255 is completely covered
+  /** The coverage is stored row by row in coverage, which is resized to rect.width * rect.height */
+  void render(FillRule rule, const wxRect& rect, vector<Byte>& coverage);
+
+  /// Number of scanlines per row of pixels
+  static const int SUBSAMPLES = 16;
+
+private:
+  /// A polygon edge, with y0 < y1, horizontal edges are not stored
+  struct Edge {
+    double x0, y0, x1, y1;
+    double dxdy;
+    int dir; ///< +1 if the edge goes down, -1 if it goes up
+  };
+  vector<Edge> edges;
+  double min_x =  1e100, min_y =  1e100;
+  double max_x = -1e100, max_y = -1e100;
+  bool sorted = true; ///< Are the edges sorted by y0?
+  // buffers, kept to prevent reallocation
+  vector<const Edge*>       active;
+  vector<pair<double,int>>  crossings;
+  vector<double>            partial; ///< coverage of pixels partially covered by a span
+  vector<double>            runs;    ///< difference array for pixels completely covered by a span
+};
+
+/// Add the points of an elliptic arc to a polygon
+/** The arc goes counter clockwise from angle start to end (in radians), with y pointing down.
+ *  Enough points are added that the error is at most tolerance.
+ */
+void add_arc_points(vector<RealPoint>& out, const RealPoint& center, const RealSize& radius, Radians start, Radians end, double tolerance = 0.1);
+
+// ----------------------------------------------------------------------------- : RasterCanvas
+
+/// An RGBA image that can be drawn on with anti-aliased shapes and images
+/** Coordinates are in pixels, with pixel (x,y) being the square [x,x+1) * [y,y+1).
+ *  Like a DC there is a current pen (for outlines) and brush (for filling shapes).
+ *  Only solid pens and brushes are supported, other styles are drawn as solid ones.
+ *
+ *  Text is not drawn by the canvas itself, getTextDC() gives a DC for selecting fonts and measuring text.
+ */
+class RasterCanvas {
+public:
+  /// Create a canvas, initially completely transparent
+  RasterCanvas(int width, int height);
+
+  inline int getWidth()  const { return image.GetWidth();  }
+  inline int getHeight() const { return image.GetHeight(); }
+  /// The contents of the canvas, always has an alpha channel
+  inline const Image& getImage() const { return image; }
+
+  // --------------------------------------------------- : Properties
+
+  void setPen(const wxPen& pen);
+  void setBrush(const wxBrush& brush);
+  inline double getPenWidth() const { return pen_width; }
+
+  /// Only draw inside the given shape (in addition to the canvas bounds)
+  void setClip(PolygonRasterizer& shape, FillRule rule = FILL_NONZERO);
+  void resetClip();
+
+  /// A DC for text measurement, drawing on it does not affect the canvas
+  inline wxDC& getTextDC() { return text_dc; }
+
+  // --------------------------------------------------- : Drawing
+
+  /// Fill the entire canvas with the color of the brush, ignores clipping
+  void clear();
+  /// Fill a polygon with the brush, and draw its outline with the pen
+  void drawPolygon(const vector<RealPoint>& points);
+  /// Fill a polygon with the brush
+  void fillPolygon(const vector<RealPoint>& points);
+  /// Draw lines between the points with the pen
+  void strokePolyline(const vector<RealPoint>& points, bool closed);
+  /// Fill a shape with a color
+  void fill(PolygonRasterizer& shape, FillRule rule, Color color);
+  /// Draw an image with its top left corner at (x,y) using a combining mode
+  void drawImage(const Image& img, int x, int y, ImageCombine combine = COMBINE_NORMAL);
+
+  /// Get the contents of part of the canvas
+  Image getSubImage(const wxRect& rect) const;
+
+private:
+  Image image;
+  Color pen_color, brush_color;
+  double pen_width;
+  wxRect clip_rect;      ///< Bounds of the clipping shape, intersected with the canvas
+  vector<Byte> clip;     ///< Coverage of the clipping shape inside clip_rect, empty if there is no clipping shape
+  PolygonRasterizer shape;
+  vector<Byte> coverage;
+  wxMemoryDC text_dc;
+  Bitmap text_bitmap;
+
+  /// Blend a color onto a row of pixels, using the coverage of each pixel
+  void blendRow(int x, int y, int count, const Byte* coverage, Color color);
+  /// Blend a row of pixels onto a row of the canvas, using the alpha of each pixel
+  void blendRow(int x, int y, int count, const Byte* rgb, const Byte* alpha);
+};
@@ -8,6 +8,7 @@
 
 #include <util/prec.hpp>
 #include <gfx/gfx.hpp>
+#include <gfx/image_kernels.hpp>
 #include <util/error.hpp>
 
 // ----------------------------------------------------------------------------- : Resample passes
@@ -17,6 +18,49 @@
 //  we will get errors if 2^shift * imagesize becomes too large
 const int shift = 32-10-8; // => max size = 1024, max alpha = 255
 
+/// The input pixels that make up each output pixel of a resample pass
+/** The amounts only depend on the lengths, not on the line, so they are computed once per pass.
+ *  Each input pixel becomes a fixed amount of output, out_fact (in 1<<shift fixed point math);
+ *  to ensure the sum of all the amounts is exacly length_out<<shift, an extra rest amount is
+ *  taken from the first pixel.
+ */
+struct ResampleAmounts {
+  vector<int>  first;  ///< first[x] is the index in 'pixel' and 'amount' of the first input for output pixel x
+  vector<int>  pixel;  ///< index of the input pixel
+  vector<UInt> amount; ///< how much of the input pixel to use
+  
+  ResampleAmounts(int length_in, int length_out) {
+    int out_fact = (length_out << shift) / length_in; // how much to output for 256 input = 1 pixel
+    int out_rest = (length_out << shift) % length_in;
+    UInt in_rem = out_fact + out_rest; // remaining to input from the current input pixel
+    int in = 0;
+    first.reserve(length_out + 1);
+    for (int x = 0 ; x < length_out ; ++x) {
+      first.push_back((int)pixel.size());
+      UInt out_rem = 1 << shift;
+      while (out_rem >= in_rem) {
+        // eat a whole input pixel
+        add(in, in_rem);
+        out_rem -= in_rem;
+        in_rem = out_fact;
+        ++in;
+      }
+      if (out_rem > 0) {
+        // eat a partial input pixel
+        add(in, out_rem);
+        in_rem -= out_rem;
+      }
+    }
+    first.push_back((int)pixel.size());
+  }
+  
+private:
+  inline void add(int in, UInt amt) {
+    pixel.push_back(in);
+    amount.push_back(amt);
+  }
+};
+
 // Resample an image only in a single direction, either horizontally or vertically
 /* Terms are based on x resampling (keeping the same number of lines):
  *  offset     = number of elements to skip at the start
@@ -25,6 +69,10 @@ const int shift = 32-10-8; // => max size = 1024, max alpha = 255
  *  lines      = number of lines
  *  line_delta = number of elements between the the first pixel of two lines
  *  1 element = 3 bytes in data, 1 byte in alpha
+ *
+ * When the lines are next to each other in memory (line_delta = 1, i.e. resampling vertically),
+ * all lines are processed at the same time, so the image is read row by row instead of column by column.
+ * Without alpha, a whole row is then handled by the kernels accumulate_bytes and shift_bytes.
  */
 void resample_pass(const Image& img_in, Image& img_out, int offset_in, int offset_out,
                    int length_in, int delta_in, int length_out, int delta_out,
@@ -32,38 +80,76 @@ void resample_pass(const Image& img_in, Image& img_out, int offset_in, int offse
 {
   bool alpha = img_in.HasAlpha();
   if (alpha && !img_out.HasAlpha()) img_out.InitAlpha();
-  int out_fact = (length_out << shift) / length_in; // how much to output for 256 input = 1 pixel
-  int out_rest = (length_out << shift) % length_in;
+  ResampleAmounts amounts(length_in, length_out);
+  const Byte* data_in   = img_in .GetData();
+  Byte*       data_out  = img_out.GetData();
+  const Byte* alpha_in  = alpha ? img_in .GetAlpha() : nullptr;
+  Byte*       alpha_out = alpha ? img_out.GetAlpha() : nullptr;
+  
+  if (line_delta_in == 1 && line_delta_out == 1 && lines > 1) {
+    // all lines at once
+    vector<UInt> tot((alpha ? 4 : 3) * lines);
+    for (int x = 0 ; x < length_out ; ++x) {
+      fill(tot.begin(), tot.end(), 0);
+      for (int i = amounts.first[x] ; i < amounts.first[x+1] ; ++i) {
+        UInt amt = amounts.amount[i];
+        int  pos = offset_in + amounts.pixel[i] * delta_in;
+        const Byte* in = data_in + 3 * pos;
+        UInt* t = &tot[0];
+        if (alpha) {
+          const Byte* in_a = alpha_in + pos;
+          for (int l = 0 ; l < lines ; ++l, in += 3, t += 4) {
+            UInt amt_a = amt * in_a[l]; // multiply by alpha
+            t[0] += in[0] * amt_a;
+            t[1] += in[1] * amt_a;
+            t[2] += in[2] * amt_a;
+            t[3] += amt_a;
+          }
+        } else {
+          accumulate_bytes(t, in, amt, 3 * lines);
+        }
+      }
+      // store
+      int pos = offset_out + x * delta_out;
+      Byte* out = data_out + 3 * pos;
+      const UInt* t = &tot[0];
+      if (alpha) {
+        Byte* out_a = alpha_out + pos;
+        for (int l = 0 ; l < lines ; ++l, out += 3, t += 4) {
+          if (t[3]) {
+            out[0] = t[0] / t[3];
+            out[1] = t[1] / t[3];
+            out[2] = t[2] / t[3];
+            out_a[l] = t[3] >> shift;
+          } else {
+            out[0] = out[1] = out[2] = out_a[l] = 0; // div by 0 is bad
+          }
+        }
+      } else {
+        shift_bytes(out, t, shift, 3 * lines);
+      }
+    }
+    return;
+  }
+  
   // for each line
   for (int l = 0 ; l < lines ; ++l) {
-    Byte* in  = img_in .GetData() + 3 * (offset_in  + l * line_delta_in);
-    Byte* out = img_out.GetData() + 3 * (offset_out + l * line_delta_out);
-    UInt in_rem = out_fact + out_rest; // remaining to input from the current input pixel
+    const Byte* in  = data_in  + 3 * (offset_in  + l * line_delta_in);
+    Byte*       out = data_out + 3 * (offset_out + l * line_delta_out);
     
     if (alpha) {
-      Byte* in_a  = img_in .GetAlpha() + (offset_in  + l * line_delta_in);
-      Byte* out_a = img_out.GetAlpha() + (offset_out + l * line_delta_out);
+      const Byte* in_a  = alpha_in  + (offset_in  + l * line_delta_in);
+      Byte*       out_a = alpha_out + (offset_out + l * line_delta_out);
       
       for (int x = 0 ; x < length_out ; ++x) {
-        UInt out_rem = 1 << shift;
         UInt totR = 0, totG = 0, totB = 0, totA = 0;
-        while (out_rem >= in_rem) {
-          // eat a whole input pixel
-          totR += in[0]   * in_rem * in_a[0]; // multiply by alpha
-          totG += in[1]   * in_rem * in_a[0];
-          totB += in[2]   * in_rem * in_a[0];
-          totA += in_a[0] * in_rem;
-          out_rem -= in_rem;
-          in_rem = out_fact;
-          in += 3*delta_in; in_a += delta_in;
-        }
-        if (out_rem > 0) {
-          // eat a partial input pixel
-          totR += in[0]   * out_rem * in_a[0];
-          totG += in[1]   * out_rem * in_a[0];
-          totB += in[2]   * out_rem * in_a[0];
-          totA += in_a[0] * out_rem;
-          in_rem -= out_rem;
+        for (int i = amounts.first[x] ; i < amounts.first[x+1] ; ++i) {
+          int  p   = amounts.pixel[i] * delta_in;
+          UInt amt = amounts.amount[i] * in_a[p]; // multiply by alpha
+          totR += in[3*p+0] * amt;
+          totG += in[3*p+1] * amt;
+          totB += in[3*p+2] * amt;
+          totA += amt;
         }
         // store
         if (totA) {
@@ -80,23 +166,13 @@ void resample_pass(const Image& img_in, Image& img_out, int offset_in, int offse
     } else {
       // no alpha
       for (int x = 0 ; x < length_out ; ++x) {
-        UInt out_rem = 1 << shift;
         UInt totR = 0, totG = 0, totB = 0;
-        while (out_rem >= in_rem) {
-          // eat a whole input pixel
-          totR += in[0] * in_rem;
-          totG += in[1] * in_rem;
-          totB += in[2] * in_rem;
-          out_rem -= in_rem;
-          in_rem = out_fact;
-          in += 3*delta_in;
-        }
-        if (out_rem > 0) {
-          // eat a partial input pixel
-          totR += in[0] * out_rem;
-          totG += in[1] * out_rem;
-          totB += in[2] * out_rem;
-          in_rem -= out_rem;
+        for (int i = amounts.first[x] ; i < amounts.first[x+1] ; ++i) {
+          int  p   = amounts.pixel[i] * delta_in;
+          UInt amt = amounts.amount[i];
+          totR += in[3*p+0] * amt;
+          totG += in[3*p+1] * amt;
+          totB += in[3*p+2] * amt;
         }
         // store
         out[0] = totR >> shift;
@@ -163,11 +163,9 @@ void blur_image_alpha(Image& img) {
   }
 }
 
-// Draw text by first drawing it using a larger font and then downsampling it
+// Render text by first drawing it using a larger font and then downsampling it
 // optionally rotated by an angle
-void draw_resampled_text(DC& dc, const RealPoint& pos, const RealRect& rect, double stretch, Radians angle, Color color, const String& text, int blur_radius, int repeat) {
-  // transparent text can be ignored
-  if (color.Alpha() == 0) return;
+Image render_resampled_text(const wxFont& font, const RealPoint& pos, const RealRect& rect, double stretch, Radians angle, Color color, const String& text, int blur_radius, wxPoint& img_pos) {
   // enlarge slightly; some fonts are larger then the GetTextExtent tells us (especially italic fonts)
   int w = static_cast<int>(rect.width) + 3 + 2 * blur_radius, h = static_cast<int>(rect.height) + 1 + 2 * blur_radius;
   // determine sub-pixel position
@@ -181,7 +179,7 @@ void draw_resampled_text(DC& dc, const RealPoint& pos, const RealRect& rect, dou
   mdc.SelectObject(buffer);
   clearDC_black(mdc);
   // now draw the text
-  mdc.SetFont(dc.GetFont());
+  mdc.SetFont(font);
   mdc.SetTextForeground(*wxWHITE);
   mdc.DrawRotatedText(text, xsub, ysub, rad_to_deg(angle));
   // get image
@@ -201,9 +199,18 @@ void draw_resampled_text(DC& dc, const RealPoint& pos, const RealRect& rect, dou
   for (int i = 0 ; i < blur_radius ; ++i) {
     blur_image_alpha(img_small);
   }
+  img_pos = wxPoint(xi, yi);
+  return img_small;
+}
+
+void draw_resampled_text(DC& dc, const RealPoint& pos, const RealRect& rect, double stretch, Radians angle, Color color, const String& text, int blur_radius, int repeat) {
+  // transparent text can be ignored
+  if (color.Alpha() == 0) return;
+  wxPoint img_pos;
+  Image img = render_resampled_text(dc.GetFont(), pos, rect, stretch, angle, color, text, blur_radius, img_pos);
   // step 3. draw to dc
   for (int i = 0 ; i < repeat ; ++i) {
-    dc.DrawBitmap(img_small, xi, yi);
+    dc.DrawBitmap(img, img_pos.x, img_pos.y);
   }
 }
 
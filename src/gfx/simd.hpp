@@ -0,0 +1,72 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+/** @file gfx/simd.hpp
+ *
+ *  Helpers for processing 16 bytes of image data at once with SSE2.
+ *  SSE2 is always available on x86-64, on other platforms USE_SSE2 is 0 and the scalar code is used.
+ *  All functions give exactly the same results as the scalar code.
+ *  The kernels that use these helpers are in gfx/image_kernels.hpp.
+ */
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <atomic>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define USE_SSE2 1
+  #include <emmintrin.h>
+#else
+  #define USE_SSE2 0
+#endif
+
+/// Should the image kernels use SSE2?
+/** Can be turned off at runtime, to compare with the scalar code.
+ *  Atomic, because the kernels are used by the thumbnail and export worker threads. */
+inline atomic<bool> simd_enabled{USE_SSE2};
+
+// ----------------------------------------------------------------------------- : SSE2 helpers
+
+#if USE_SSE2
+
+inline __m128i load16(const Byte* data) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+inline void store16(Byte* data, __m128i x) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(data), x);
+}
+
+/// x / 255 for each 16 bit x <= 255*255, rounded down
+/** Uses x/255 == (x + 1 + x/256) / 256, which holds for x < 65535 */
+inline __m128i div255_epu16(__m128i x) {
+  return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)), 8);
+}
+
+/// (a * b) / 255 for each of the 16 bytes, rounded down
+inline __m128i mul_div255_epu8(__m128i a, __m128i b) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i lo = div255_epu16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)));
+  __m128i hi = div255_epu16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)));
+  return _mm_packus_epi16(lo, hi);
+}
+
+/// (a * m + b * (255 - m)) / 255 for each of the 16 bytes, rounded down
+inline __m128i blend_div255_epu8(__m128i a, __m128i b, __m128i m) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i inv_m = _mm_sub_epi8(_mm_set1_epi8(-1), m);
+  __m128i lo = div255_epu16(_mm_add_epi16(
+                 _mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(m,     zero)),
+                 _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(inv_m, zero))));
+  __m128i hi = div255_epu16(_mm_add_epi16(
+                 _mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(m,     zero)),
+                 _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(inv_m, zero))));
+  return _mm_packus_epi16(lo, hi);
+}
+
+#endif
@@ -69,6 +69,7 @@ struct Freezer{
 void CardListBase::onAction(const Action& action, bool undone) {
   TYPE_CASE(action, AddCardAction) {
     Freezer freeze(this);
+    FOR_EACH_CONST(s, action.action.steps) sort_keys.erase(s.item.get());
     if (action.action.adding != undone) {
       // select the new cards
       focusNone();
@@ -103,12 +104,16 @@ void CardListBase::onAction(const Action& action, bool undone) {
     RefreshItem((long)action.card_id1);
     RefreshItem((long)action.card_id2);
   }
-  TYPE_CASE_(action, ScriptValueEvent) {
+  TYPE_CASE(action, ScriptValueEvent) {
     // No refresh needed, a ScriptValueEvent is only generated in response to a ValueAction
+    sort_keys.erase(action.card);
     return;
   }
   TYPE_CASE(action, ValueAction) {
-    if (action.card) refreshList(true);
+    if (action.card) {
+      sort_keys.erase(action.card.get());
+      refreshList(true);
+    }
   }
 }
 
@@ -183,28 +188,72 @@ bool CardListBase::doDelete() {
 
 // ----------------------------------------------------------------------------- : CardListBase : Building the list
 
-// Comparison object for comparing cards
-bool CardListBase::compareItems(void* a, void* b) const {
+const CardListBase::SortKeys& CardListBase::getSortKeys(Card& card) const {
   FieldP sort_field = column_fields[sort_by_column];
-  ValueP va = reinterpret_cast<Card*>(a)->data[sort_field];
-  ValueP vb = reinterpret_cast<Card*>(b)->data[sort_field];
-  assert(va && vb);
+  if (sort_field != sort_keys_field) {
+    // sorting by another column
+    sort_keys.clear();
+    sort_keys_field = sort_field;
+  }
+  ValueP value = card.data[sort_field];
+  ValueP alternate = alternate_sort_field ? card.data[alternate_sort_field] : ValueP();
+  assert(value);
+  // are the keys still up to date? scripts can change values without an action
+  auto it = sort_keys.find(&card);
+  if (it != sort_keys.end() && it->second.age == value->last_script_update &&
+      (!alternate || it->second.alternate_age == alternate->last_script_update)) {
+    return it->second;
+  }
+  SortKeys& keys = sort_keys[&card];
+  keys.key = value->getSortKey();
+  keys.age = value->last_script_update;
+  if (alternate) {
+    keys.alternate_key = alternate->getSortKey();
+    keys.alternate_age = alternate->last_script_update;
+  }
+  return keys;
+}
+
+bool CardListBase::lessSortKeys(const SortKeys& a, const SortKeys& b) const {
   // compare sort keys
-  int cmp = smart_compare( va->getSortKey(), vb->getSortKey() );
+  int cmp = smart_compare(a.key, b.key);
   if (cmp != 0) return cmp < 0;
   // equal values, compare alternate sort key
   if (alternate_sort_field) {
-    ValueP va = reinterpret_cast<Card*>(a)->data[alternate_sort_field];
-    ValueP vb = reinterpret_cast<Card*>(b)->data[alternate_sort_field];
-    int cmp = smart_compare( va->getSortKey(), vb->getSortKey() );
+    int cmp = smart_compare(a.alternate_key, b.alternate_key);
     if (cmp != 0) return cmp < 0;
   }
   return false;
 }
 
+// Comparison object for comparing cards
+bool CardListBase::compareItems(void* a, void* b) const {
+  return lessSortKeys(getSortKeys(*reinterpret_cast<Card*>(a)), getSortKeys(*reinterpret_cast<Card*>(b)));
+}
+
+void CardListBase::sortItems(vector<VoidP>& items) {
+  // get the keys once, and then sort positions in the list
+  vector<const SortKeys*> keys;
+  keys.reserve(items.size());
+  FOR_EACH(item, items) {
+    keys.push_back(&getSortKeys(*static_cast<Card*>(item.get()))); // references into sort_keys stay valid
+  }
+  vector<size_t> order(items.size());
+  for (size_t i = 0 ; i < order.size() ; ++i) order[i] = i;
+  stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return sort_ascending ? lessSortKeys(*keys[a], *keys[b]) : lessSortKeys(*keys[b], *keys[a]);
+  });
+  vector<VoidP> sorted;
+  sorted.reserve(items.size());
+  FOR_EACH(i, order) sorted.push_back(std::move(items[i]));
+  swap(items, sorted);
+}
+
 void CardListBase::rebuild() {
   ClearAll();
   column_fields.clear();
+  sort_keys.clear();
+  sort_keys_field = FieldP();
   selected_item_pos = -1;
   onRebuild();
   if (!set) return;
@@ -12,6 +12,7 @@
 #include <gui/control/item_list.hpp>
 #include <data/card.hpp>
 #include <data/set.hpp>
+#include <util/age.hpp>
 
 DECLARE_POINTER_TYPE(ChoiceField);
 DECLARE_POINTER_TYPE(Field);
@@ -108,6 +109,8 @@ protected:
   void sendEvent(int type = EVENT_CARD_SELECT);
   /// Compare cards
   bool compareItems(void* a, void* b) const override;
+  /// Sort cards, looking up the sort keys only once per card
+  void sortItems(vector<VoidP>& items) override;
   
   // --------------------------------------------------- : Item 'events'
   
@@ -126,6 +129,19 @@ private:
   vector<FieldP> column_fields; ///< The field to use for each column (by column index)
   FieldP alternate_sort_field;  ///< Second field to sort by, if the column doesn't suffice
   
+  /// The sort keys of a card
+  struct SortKeys {
+    String key, alternate_key;
+    Age    age, alternate_age; ///< last_script_update of the values the keys came from
+  };
+  /// Sort keys of cards for sort_keys_field, removed in onAction when a card changes
+  mutable unordered_map<const Card*, SortKeys> sort_keys;
+  mutable FieldP sort_keys_field;
+  /// Get the sort keys of a card, they are only recomputed if the card has changed
+  const SortKeys& getSortKeys(Card& card) const;
+  /// Compare sort keys for <
+  bool lessSortKeys(const SortKeys& a, const SortKeys& b) const;
+  
   mutable wxListItemAttr item_attr; // for OnGetItemAttr
   
 public:
@@ -60,10 +60,6 @@ void GraphDataPre::splitList(size_t axis) {
 }
 
 
-struct SmartLess{
-  inline bool operator () (const String& a, const String& b) const { return smart_less(a,b); }
-};
-
 String to_bin(double value, double bin_size) {
   if (bin_size <= 0 || value == 0) {
     return String() << (int)value;
@@ -86,11 +82,14 @@ GraphData::GraphData(const GraphDataPre& d)
   // find groups on each axis
   size_t i = 0;
   for (auto const& a : axes) {
-    map<String,UInt,SmartLess> counts; // note: default constructor for UInt() does initialize to 0
-    FOR_EACH_CONST(e, d.elements) {
-      assert(e->values.size() == axes.size());
-      counts[e->values[i]] += 1;
+    map<String,UInt,SmartLess> own_counts; // note: default constructor for UInt() does initialize to 0
+    if (i >= d.counts.size() || !d.counts[i]) {
+      FOR_EACH_CONST(e, d.elements) {
+        assert(e->values.size() == axes.size());
+        own_counts[e->values[i]] += 1;
+      }
     }
+    const map<String,UInt,SmartLess>& counts = i < d.counts.size() && d.counts[i] ? *d.counts[i] : own_counts;
     if (a->numeric) {
       // Add all values, calculate mean of the numeric ones
       UInt numeric_count = 0;
@@ -124,7 +123,8 @@ GraphData::GraphData(const GraphDataPre& d)
     } else if (a->order) {
       // specific group order
       FOR_EACH_CONST(gn, *a->order) {
-        a->addGroup(gn, counts[gn]);
+        map<String,UInt,SmartLess>::const_iterator it = counts.find(gn);
+        a->addGroup(gn, it == counts.end() ? 0 : it->second);
       }
     } else {
       FOR_EACH(c, counts) {
@@ -160,6 +160,14 @@ GraphData::GraphData(const GraphDataPre& d)
     }
     ++i;
   }
+  // index of the first group with each name
+  vector<map<String,int>> group_nrs(axes.size());
+  for (size_t i = 0 ; i < axes.size() ; ++i) {
+    int j = 0;
+    FOR_EACH_CONST(g, axes[i]->groups) {
+      group_nrs[i].insert(make_pair(g.name, j++));
+    }
+  }
   // count elements in each position
   values.reserve(d.elements.size());
   size_t de_size = sizeof(GraphDataElement) + sizeof(int) * (axes.size() - 1);
@@ -178,14 +186,8 @@ GraphData::GraphData(const GraphDataPre& d)
         de->group_nrs[i] = bin_to_group(d, a->bin_size);
       } else {
         // find group that contains v
-        int j = 0;
-        FOR_EACH(g, a->groups) {
-          if (v == g.name) {
-            de->group_nrs[i] = j;
-            break;
-          }
-          ++j;
-        }
+        map<String,int>::const_iterator it = group_nrs[i].find(v);
+        if (it != group_nrs[i].end()) de->group_nrs[i] = it->second;
       }
       ++i;
     }
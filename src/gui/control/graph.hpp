@@ -96,6 +96,9 @@ class GraphDataPre {
 public:
   vector<GraphAxisP>    axes;
   vector<GraphElementP> elements;
+  /// The number of elements with each value, for each axis (optional)
+  /** If given, counts[i] must be the same as counting the values of all elements on axis i */
+  vector<const map<String,UInt,SmartLess>*> counts;
   /// Split compound elements, "a,b,c" -> "a" and "b" and "c"
   void splitList(size_t axis);
 };
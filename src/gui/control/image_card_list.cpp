@@ -54,7 +54,8 @@ public:
     : ThumbnailRequest(
       parent,
       _("card") + parent->set->absoluteFilename() + _("-") + filename.toStringForKey(),
-      wxDateTime::Now())  // TODO: Find mofication time of card image
+      wxDateTime::Now(),  // TODO: Find mofication time of card image
+      THUMBNAIL_PRIORITY_VISIBLE) // only requested for items that are shown
     , filename(filename)
   {}
   Image generate() override {
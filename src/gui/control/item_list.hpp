@@ -67,6 +67,9 @@ protected:
   virtual bool mustSort() const { return false; }
   /// Compare two items for < based on sort_by_column (not on sort_ascending)
   virtual bool compareItems(void* a, void* b) const = 0;
+  /// Sort a list of items based on sort_by_column and sort_ascending
+  /** By default does a stable sort using compareItems */
+  virtual void sortItems(vector<VoidP>& items);
   
   // --------------------------------------------------- : Protected interface
   /// Return the card at the given position in the sorted list
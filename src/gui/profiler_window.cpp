@@ -141,6 +141,15 @@ void ProfilerPanel::draw_profiler(wxDC& dc, int x0, int y0) {
       draw_right(dc,wxString::Format(_("%.2f"), prof->total_time()), pos[3], y);
       draw_right(dc,wxString::Format(_("%.2f"), prof->max_time()),   pos[4], y);
     }
+    // Draw counters
+    dc.SetTextForeground(fg);
+    int y = y0 + (i + 1) * line_height + 12;
+    dc.DrawLine(x0, y - 3, x1, y - 3);
+    FOR_EACH_CONST(c, profile_counters()) {
+      dc.DrawText(c->name,                                       pos[0], y);
+      draw_right(dc,wxString::Format(_("%d"), (int)c->get()),    pos[1], y);
+      y += line_height;
+    }
     // are any fancy effects active?
     if (fancy_effects && any_active && !timer.IsRunning()) {
       timer.Start(40,wxTIMER_ONE_SHOT);
@@ -19,6 +19,7 @@
 #include <data/game.hpp>
 #include <data/card.hpp>
 #include <data/add_cards_script.hpp>
+#include <data/search_index.hpp>
 #include <data/action/set.hpp>
 #include <data/settings.hpp>
 #include <util/find_replace.hpp>
@@ -142,6 +143,7 @@ CardsPanel::~CardsPanel() {
 }
 
 void CardsPanel::onChangeSet() {
+  search_index = make_intrusive<CardSearchIndex>();
   editor->setSet(set);
   notes->setSet(set);
   card_list->setSet(set);
@@ -158,6 +160,10 @@ void CardsPanel::onChangeSet() {
   }
 }
 
+void CardsPanel::onAction(const Action& action, bool undone) {
+  if (search_index) search_index->onAction(action, undone);
+}
+
 wxMenu* CardsPanel::makeAddCardsSubmenu(bool add_single_card_option) {
   wxMenu* cards_scripts_menu = nullptr;
   // default item?
@@ -344,7 +350,12 @@ void CardsPanel::onCommand(int id) {
     }
     case ID_CARD_FILTER: {
       // card filter has changed, update the card list
-      card_list->setFilter(filter->getFilter<Card>());
+      // the index is used to find the matching cards, instead of searching through all of them
+      CardListFilterP card_filter;
+      if (filter->hasFilter()) {
+        card_filter = make_intrusive<IndexedQuickFilter>(filter->getFilterString(), search_index);
+      }
+      card_list->setFilter(card_filter);
       break;
     }
     default: {
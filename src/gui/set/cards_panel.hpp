@@ -18,6 +18,7 @@ class TextCtrl;
 class HoverButton;
 class FindInfo;
 class FilterCtrl;
+DECLARE_POINTER_TYPE(CardSearchIndex);
 
 // ----------------------------------------------------------------------------- : CardsPanel
 
@@ -28,6 +29,7 @@ public:
   ~CardsPanel();
   
   void onChangeSet() override;
+  void onAction(const Action&, bool undone) override;
   
   // --------------------------------------------------- : UI
   
@@ -88,6 +90,7 @@ private:
   HoverButton*      collapse_notes;
   FilterCtrl*       filter;
   String            filter_value; // value of filter, need separate variable because the control is destroyed
+  CardSearchIndexP  search_index; // index used by the filter
   bool              notes_below_editor;
   
   /// Move the notes panel below the editor or below the card list
@@ -328,6 +328,7 @@ StatsPanel::~StatsPanel() {
 
 void StatsPanel::onChangeSet() {
   if (!isInitialized()) return;
+  values = make_unique<StatsValueCache>(*set);
   card_list->setSet(set);
   #if USE_SEPARATE_DIMENSION_LISTS
     for (int i = 0 ; i < 3 ; ++i) dimensions[i]->show(set->game);
@@ -342,8 +343,9 @@ void StatsPanel::onChangeSet() {
 
 void StatsPanel::onAction(const Action& action, bool undone) {
   if (!isInitialized()) return;
+  values->onAction(action, undone);
   TYPE_CASE_(action, ScriptValueEvent) {
-    // ignore style only stuff
+    // only invalidates values, the action that caused it will update the graph
   } else {
     onChange();
   }
@@ -474,22 +476,19 @@ void StatsPanel::showCategory(const GraphType* prefer_layout) {
       )
     );
   }
-  // find values for each card
+  // find values for each card, only values that have changed are evaluated again
   for (size_t i = 0 ; i < set->cards.size() ; ++i) {
-    Context& ctx = set->getContext(set->cards[i]);
     GraphElementP e = make_intrusive<GraphElement>(i);
     bool show = true;
     FOR_EACH(dim, dims) {
-      try {
-        String value = untag(dim->script.invoke(ctx)->toString());
-        e->values.push_back(value);
-        if (value.empty() && !dim->show_empty) {
-          // don't show this element
-          show = false;
-          break;
-        }
-      } catch (ScriptError const& e) {
-        handle_error(ScriptError(e.what() + _("\n  in script for statistics dimension '") + dim->name + _("'")));
+      String value;
+      if (!values->value(*dim, set->cards[i], value)) {
+        show = false;
+        break;
+      }
+      e->values.push_back(value);
+      if (value.empty() && !dim->show_empty) {
+        // don't show this element
         show = false;
         break;
       }
@@ -505,6 +504,10 @@ void StatsPanel::showCategory(const GraphType* prefer_layout) {
     if (dim->split_list) d.splitList(dim_id);
     ++dim_id;
   }
+  // with a single dimension the groups are the same as the histogram, so they don't have to be counted
+  if (dims.size() == 1) {
+    d.counts.push_back(&values->histogram(*dims[0]));
+  }
   // update graph and card list
   graph->setLayout(layout, true);
   graph->setData(d);
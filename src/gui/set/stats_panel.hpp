@@ -16,6 +16,7 @@ class StatCategoryList;
 class StatDimensionList;
 class GraphControl;
 class FilteredCardList;
+class StatsValueCache;
 
 // Pick the style here:
 #define USE_DIMENSION_LISTS 1
@@ -59,6 +60,7 @@ private:
   FilteredCardList* card_list;
   wxMenu*           menuGraph;
   
+  unique_ptr<StatsValueCache> values; ///< Values of the dimensions for the cards in the set
   CardP card;      ///< Selected card
   bool up_to_date; ///< Are the graph and card list up to date?
   bool active;     ///< Is this panel selected?
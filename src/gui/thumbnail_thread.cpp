@@ -36,38 +36,90 @@ String safe_filename(const String& str) {
   return ret;
 }
 
+/// Filename under which a thumbnail is stored in the image cache
+String image_cache_filename(const String& cache_name) {
+  return image_cache_dir() + safe_filename(cache_name) + _(".png");
+}
+
+/// Write a thumbnail to the image cache, with the modification time of the object it is a thumbnail of
+void save_in_image_cache(const String& filename, const wxDateTime& modified, Image& image) {
+  // write to a temporary file first, so a half written file is never read by ThumbnailThread::request
+  String temp_name = filename + wxString::Format(_(".%lu.tmp"), (unsigned long)wxThread::GetCurrentId());
+  if (!image.SaveFile(temp_name, wxBITMAP_TYPE_PNG)) return;
+  wxFileName(temp_name).SetTimes(0, &modified, 0);
+  if (!wxRenameFile(temp_name, filename, true)) {
+    wxRemoveFile(temp_name);
+  }
+}
+
 // ----------------------------------------------------------------------------- : ThumbnailThreadWorker
 
+/// Maximum number of worker threads, one core is left for the user interface
+int max_thumbnail_workers() {
+  return max(1, min(wxThread::GetCPUCount() - 1, 4));
+}
+
+/// Time (in ms) that a worker waits for new work before it stops
+const int WORKER_IDLE_TIME = 2000;
+
 class ThumbnailThreadWorker : public wxThread {
 public:
   ThumbnailThreadWorker(ThumbnailThread* parent);
   
   ExitCode Entry() override;
   
-  ThumbnailRequestP current; ///< Request we are working on
+  ThumbnailRequestP current; ///< Request we are working on, guarded by parent->mutex
   ThumbnailThread*  parent;
-  bool              stop; ///< Suspend computation
+  
+private:
+  /// Take the highest priority request, the newest one if there are several, must be called with the mutex locked
+  ThumbnailRequestP takeRequest();
 };
 
 ThumbnailThreadWorker::ThumbnailThreadWorker(ThumbnailThread* parent)
   : parent(parent)
-  , stop(false)
 {}
 
+ThumbnailRequestP ThumbnailThreadWorker::takeRequest() {
+  vector<ThumbnailRequestP>& open = parent->open_requests;
+  size_t best = 0;
+  for (size_t i = 1 ; i < open.size() ; ++i) {
+    if (open[i]->priority >= open[best]->priority) best = i;
+  }
+  ThumbnailRequestP request = open[best];
+  open.erase(open.begin() + best);
+  return request;
+}
+
 wxThread::ExitCode ThumbnailThreadWorker::Entry() {
   while (true) {
-    do {
-      Sleep(1);
-    } while (stop);
-    // get a request
+    ThumbnailThread::CacheWrite write;
+    // get some work
     {
       wxMutexLocker lock(parent->mutex);
-      if (parent->open_requests.empty()) {
-        parent->worker = nullptr;
-        return 0; // No more requests
+      while (!parent->stopping && parent->open_requests.empty() && parent->cache_writes.empty()) {
+        // wait for more work
+        parent->idle_workers++;
+        wxCondError result = parent->work.WaitTimeout(WORKER_IDLE_TIME);
+        parent->idle_workers--;
+        if (result == wxCOND_TIMEOUT) break;
+      }
+      if (parent->stopping || (parent->open_requests.empty() && parent->cache_writes.empty())) {
+        // No more work
+        parent->workers.erase(find(parent->workers.begin(), parent->workers.end(), this));
+        return 0;
+      }
+      if (!parent->open_requests.empty()) {
+        current = takeRequest();
+      } else {
+        // only write to the cache when there are no requests waiting
+        write = parent->cache_writes.back();
+        parent->cache_writes.pop_back();
       }
-      current = parent->open_requests.front();
-      parent->open_requests.pop_front();
+    }
+    if (!current) {
+      save_in_image_cache(write.filename, write.modified, write.image);
+      continue;
     }
     // perform request
     Image img;
@@ -77,20 +129,17 @@ wxThread::ExitCode ThumbnailThreadWorker::Entry() {
       handle_error(e);
     } catch (...) {
     }
-    // store in cache
-    if (img.Ok()) {
-      String filename = image_cache_dir() + safe_filename(current->cache_name) + _(".png");
-      img.SaveFile(filename, wxBITMAP_TYPE_PNG);
-      // set modification time
-      wxFileName fn(filename);
-      fn.SetTimes(0, &current->modified, 0);
-    }
-    // store result in closed request list
+    // store result in closed request list, and queue it for writing to the cache
     {
       wxMutexLocker lock(parent->mutex);
+      if (img.Ok()) {
+        // note: the image is shared with the main thread after this, so copy it now
+        parent->cache_writes.push_back({image_cache_filename(current->cache_name), current->modified, img.Copy()});
+      }
       parent->closed_requests.push_back(make_pair(current,img));
+      img = Image();
       current = ThumbnailRequestP();
-      parent->completed.Signal();
+      parent->completed.Broadcast();
     }
   }
 }
@@ -107,17 +156,26 @@ ThumbnailThread thumbnail_thread;
 
 ThumbnailThread::ThumbnailThread()
   : completed(mutex)
-  , worker(nullptr)
+  , work(mutex)
+  , idle_workers(0)
+  , stopping(false)
 {}
 
 void ThumbnailThread::request(const ThumbnailRequestP& request) {
   assert(wxThread::IsMain());
   // Is the request in progress?
-  if (request_names.find(request) != request_names.end()) {
+  set<ThumbnailRequestP>::iterator it = request_names.find(request);
+  if (it != request_names.end()) {
+    // it might have become more urgent, and it is the newest request again
+    // (for example a list item that is scrolled back into view)
+    wxMutexLocker lock(mutex);
+    (*it)->priority = max((*it)->priority, request->priority);
+    vector<ThumbnailRequestP>::iterator pos = find(open_requests.begin(), open_requests.end(), *it);
+    if (pos != open_requests.end()) rotate(pos, pos + 1, open_requests.end());
     return;
   }
   // Is the image in the cache?
-  String filename = image_cache_dir() + safe_filename(request->cache_name) + _(".png");
+  String filename = image_cache_filename(request->cache_name);
   wxFileName fn(filename);
   if (fn.FileExists()) {
     wxDateTime modified;
@@ -131,16 +189,9 @@ void ThumbnailThread::request(const ThumbnailRequestP& request) {
   if (request->threadSafe()) {
     request_names.insert(request);
     // request generation
-    {
-      wxMutexLocker lock(mutex);
-      open_requests.push_back(request);
-    }
-    // is there a worker?
-    if (!worker) {
-      worker = new ThumbnailThreadWorker(this);
-      worker->Create();
-      worker->Run();
-    }
+    wxMutexLocker lock(mutex);
+    open_requests.push_back(request);
+    wakeWorker();
   } else {
     Image img;
     try {
@@ -149,22 +200,40 @@ void ThumbnailThread::request(const ThumbnailRequestP& request) {
       handle_error(e);
     } catch (...) {
     }
-    // store in cache
-    if (img.Ok()) {
-      String filename = image_cache_dir() + safe_filename(request->cache_name) + _(".png");
-      img.SaveFile(filename, wxBITMAP_TYPE_PNG);
-      // set modification time
-      wxFileName fn(filename);
-      fn.SetTimes(0, &request->modified, 0);
-    }
     {
       wxMutexLocker lock(mutex);
       closed_requests.push_back(make_pair(request,img));
-      completed.Signal();
+      completed.Broadcast();
+      // let a worker store it in the cache
+      if (img.Ok()) {
+        cache_writes.push_back({filename, request->modified, img.Copy()});
+        wakeWorker();
+      }
     }
   }
 }
 
+void ThumbnailThread::wakeWorker() {
+  if (stopping) return;
+  if (idle_workers > 0) {
+    work.Signal();
+  } else if ((int)workers.size() < max_thumbnail_workers()) {
+    ThumbnailThreadWorker* worker = new ThumbnailThreadWorker(this);
+    if (worker->Create() != wxTHREAD_NO_ERROR || worker->Run() != wxTHREAD_NO_ERROR) {
+      delete worker;
+      return;
+    }
+    workers.push_back(worker);
+  }
+}
+
+bool ThumbnailThread::inProgress(void* owner) const {
+  FOR_EACH_CONST(w, workers) {
+    if (w->current && (!owner || w->current->owner == owner)) return true;
+  }
+  return false;
+}
+
 bool ThumbnailThread::done(void* owner) {
   assert(wxThread::IsMain());
   // find finished requests
@@ -193,14 +262,7 @@ bool ThumbnailThread::done(void* owner) {
 
 void ThumbnailThread::abort(void* owner) {
   assert(wxThread::IsMain());
-  mutex.Lock();
-  if (worker && worker->current && worker->current->owner == owner) {
-    // a request for this owner is in progress, wait until it is done
-    worker->stop = true;
-    completed.Wait();
-    mutex.Lock();
-    worker->stop = false;
-  }
+  wxMutexLocker lock(mutex);
   // remove open requests for this owner
   for (size_t i = 0 ; i < open_requests.size() ; ) {
     if (open_requests[i]->owner == owner) {
@@ -211,6 +273,10 @@ void ThumbnailThread::abort(void* owner) {
       ++i;
     }
   }
+  // requests for this owner that are in progress use the owner, wait until they are done
+  while (inProgress(owner)) {
+    completed.Wait();
+  }
   // remove closed requests for this owner
   for (size_t i = 0 ; i < closed_requests.size() ; ) {
     if (closed_requests[i].first->owner == owner) {
@@ -221,23 +287,23 @@ void ThumbnailThread::abort(void* owner) {
       ++i;
     }
   }
-  mutex.Unlock();
 }
 
 void ThumbnailThread::abortAll() {
   assert(wxThread::IsMain());
-  mutex.Lock();
+  wxMutexLocker lock(mutex);
   open_requests.clear();
   closed_requests.clear();
   request_names.clear();
-  // end worker
-  if (worker && worker->current) {
+  cache_writes.clear();
+  // end workers
+  stopping = true;
+  work.Broadcast();
+  // wait for the requests in progress, they might use their owners
+  while (inProgress(nullptr)) {
     completed.Wait();
-  } else {
-    mutex.Unlock();
   }
-  // There may still be a worker, but if there is, it has no current object, so it is
-  // in, before or after the stop loop. It can do nothing but end.
-  // An unfortunate side effect is that we might leak some memory (of the worker object),
-  // when the thread gets Kill()ed by wx.
+  // There may still be workers, but they have no current request, so they can do nothing but end.
+  // An unfortunate side effect is that we might leak some memory (of the worker objects),
+  // when the threads get Kill()ed by wx.
 }
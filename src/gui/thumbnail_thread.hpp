@@ -18,11 +18,17 @@ class ThumbnailThreadWorker;
 
 // ----------------------------------------------------------------------------- : ThumbnailRequest
 
+/// Priorities for thumbnail requests, requests with a higher priority are generated first
+enum ThumbnailPriority
+{  THUMBNAIL_PRIORITY_NORMAL  = 0
+,  THUMBNAIL_PRIORITY_VISIBLE = 1   ///< for items that are currently shown
+};
+
 /// A request for some kind of thumbnail
 class ThumbnailRequest : public IntrusivePtrVirtualBase {
 public:
-  ThumbnailRequest(void* owner, const String& cache_name, const wxDateTime& modified)
-    : owner(owner), cache_name(cache_name), modified(modified) {}
+  ThumbnailRequest(void* owner, const String& cache_name, const wxDateTime& modified, int priority = THUMBNAIL_PRIORITY_NORMAL)
+    : owner(owner), cache_name(cache_name), modified(modified), priority(priority) {}
   
   virtual ~ThumbnailRequest() {}
   
@@ -40,40 +46,68 @@ public:
   String cache_name;
   /// Modification time for the object of which the thumnail is generated
   wxDateTime modified;
+  /// Requests with a higher priority are generated first, requests with the same priority newest first
+  /** Only changed by the ThumbnailThread, with its mutex locked */
+  int priority;
 };
 
 // ----------------------------------------------------------------------------- : ThumbnailThread
 
-/// A (generic) class that generates thumbnails in another thread
+/// A (generic) class that generates thumbnails in other threads
 /** All requests have an 'owner', the object that requested the thumbnail.
  *  This object should regularly call "done(this)".
- *  Multiple requests can be open at the same time.
- *  Thumbnails are cached, and need not be generated in a thread
+ *  Multiple requests can be open at the same time, they are handled by a pool of worker threads,
+ *  highest priority first, and newest first within the same priority.
+ *  Thumbnails are cached, and need not be generated in a thread.
+ *  Writing thumbnails to the cache is done by the workers when there are no more requests.
  */
 class ThumbnailThread {
 public:
   ThumbnailThread();
   
   /// Request a thumbnail, it may be store()d immediatly if the thumbnail is cached
+  /** If the same thumbnail was already requested, its priority is raised to that of the new request,
+   *  and it counts as the newest request.
+   *  Items in a list request their thumbnails when they are drawn, so the items that are currently shown
+   *  are generated before those that were scrolled out of view.
+   */
   void request(const ThumbnailRequestP& request);
   /// Is one or more thumbnail for the given owner finished?
   /** If so, call their store() functions */
   bool done(void* owner);
   /// Abort all thumbnail requests for the given owner
+  /** Waits for requests of the owner that are being generated, after this the owner can be destroyed */
   void abort(void* owner);
   /// Abort all computations
   /** *must* be called at application exit */
   void abortAll();
   
 private:
-  wxMutex     mutex;  ///< Mutex used by the worker when accessing the request lists or the thread pointer
+  wxMutex     mutex;     ///< Mutex used by the workers when accessing the request lists or the worker list
   wxCondition completed; ///< Event signaled when a request is completed
+  wxCondition work;      ///< Event signaled when there is new work for idle workers, or when they should stop
   
-  deque<ThumbnailRequestP>                open_requests;    ///< Requests on which work hasn't finished
+  /// A thumbnail that still has to be written to the image cache
+  struct CacheWrite {
+    String     filename;
+    wxDateTime modified;
+    Image      image;    ///< Not shared with other threads
+  };
+  
+  vector<ThumbnailRequestP>               open_requests;    ///< Requests on which work hasn't started
   vector<pair<ThumbnailRequestP,Image>>  closed_requests;  ///< Requests for which work is completed
   set<ThumbnailRequestP>                  request_names;    ///< Requests that haven't been stored yet, to prevent duplicates
+  vector<CacheWrite>                      cache_writes;     ///< Thumbnails to write to the image cache
   friend class ThumbnailThreadWorker;
-  ThumbnailThreadWorker* worker;                ///< The worker thread. invariant: no requests ==> worker==nullptr
+  vector<ThumbnailThreadWorker*> workers;       ///< The worker threads. invariant: no work ==> eventually no workers
+  int                            idle_workers;  ///< Number of workers waiting for work
+  bool                           stopping;      ///< Should all workers stop?
+  
+  /// Make sure there is a worker for new work, must be called with the mutex locked
+  void wakeWorker();
+  /// Is a request of the given owner (or of any owner if nullptr) being generated?
+  /** Must be called with the mutex locked */
+  bool inProgress(void* owner) const;
 };
 
 /// The global thumbnail generator thread
@@ -17,6 +17,8 @@
 #include <data/format/formats.hpp>
 #include <cli/cli_main.hpp>
 #include <cli/text_io_handler.hpp>
+#include <cli/server.hpp>
+#include <script/profiler.hpp>
 #include <gui/welcome_window.hpp>
 #include <gui/update_checker.hpp>
 #include <gui/packages_window.hpp>
@@ -27,6 +29,7 @@
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
 #include <wx/socket.h>
+#include <wx/stopwatch.h>
 
 ScriptValueP export_set(SetP const& set, vector<CardP> const& cards, ExportTemplateP const& exp, String const& outname);
 
@@ -76,6 +79,22 @@ void nag_about_ascii_version() {
   #endif
 }
 
+/// Handle a "--profile FILE" command line argument, it is removed from args
+/** If it is present, tracing is started, and the trace filename is returned.
+ *  Returns an empty string otherwise.
+ */
+String take_profile_argument(vector<String>& args) {
+  for (size_t i = 1 ; i + 1 < args.size() ; ++i) {
+    if (args[i] == _("--profile")) {
+      String filename = args[i + 1];
+      args.erase(args.begin() + i, args.begin() + i + 2);
+      start_tracing();
+      return filename;
+    }
+  }
+  return String();
+}
+
 // ----------------------------------------------------------------------------- : Initialization
 
 int MSE::OnRun() {
@@ -134,6 +153,9 @@ int MSE::OnRun() {
         } else if (f.GetExt() == _("mse-script")) {
           // Run a script file
           if (!run_script_file(arg)) return EXIT_FAILURE;
+          #if USE_SCRIPT_PROFILING
+            if (args.size() > 1 && args[1] == _("--profile")) show_profile_counters();
+          #endif
           if (cli.shown_errors()) return EXIT_FAILURE;
           return EXIT_SUCCESS;
         } else if (arg == _("--symbol-editor")) {
@@ -178,6 +200,9 @@ int MSE::OnRun() {
           cli << _("\n         \tIf the ") << BRIGHT << _("--local") << NORMAL << _(" flag is passed, install packages for this user only.");
           cli << _("\n\n  ") << PARAM << _("FILE") << FILE_EXT << _(".mse-script") << NORMAL;
           cli << _("\n         \tRun a script file.");
+          #if USE_SCRIPT_PROFILING
+            cli << _("\n         \tWith ") << BRIGHT << _("--profile") << NORMAL << _(", afterwards show the profiling counters.");
+          #endif
           cli << _("\n\n  ") << BRIGHT << _("--symbol-editor") << NORMAL;
           cli << _("\n         \tShow the symbol editor instead of the welcome window.");
           cli << _("\n\n  ") << BRIGHT << _("--create-installer") << NORMAL << _(" [")
@@ -185,12 +210,18 @@ int MSE::OnRun() {
                              << PARAM << _("PACKAGE") << NORMAL << _(" [") << PARAM << _("PACKAGE") << NORMAL << _(" ...]]");
           cli << _("\n         \tCreate an instaler, containing the listed packages.");
           cli << _("\n         \tIf no output filename is specified, the name of the first package is used.");
-          cli << _("\n\n  ") << BRIGHT << _("--export") << NORMAL << PARAM << _(" TEMPLATE SETFILE ") << NORMAL << _(" [") << PARAM << _("OUTFILE") << NORMAL << _("]");
+          cli << _("\n\n  ") << BRIGHT << _("--export") << NORMAL << PARAM << _(" TEMPLATE SETFILE ") << NORMAL << _(" [") << PARAM << _("OUTFILE") << NORMAL << _("]")
+                             << _(" [") << BRIGHT << _("--profile") << NORMAL << PARAM << _(" TRACEFILE") << NORMAL << _("]");
           cli << _("\n         \tExport a set using an export template.");
           cli << _("\n         \tIf no output filename is specified, the result is written to stdout.");
-          cli << _("\n\n  ") << BRIGHT << _("--export-images") << NORMAL << PARAM << _(" FILE") << NORMAL << _(" [") << PARAM << _("IMAGE") << NORMAL << _("]");
+          cli << _("\n\n  ") << BRIGHT << _("--export-images") << NORMAL << PARAM << _(" FILE") << NORMAL << _(" [") << PARAM << _("IMAGE") << NORMAL << _("]")
+                             << _(" [") << BRIGHT << _("--jobs") << NORMAL << PARAM << _(" N") << NORMAL << _("]")
+                             << _(" [") << BRIGHT << _("--profile") << NORMAL << PARAM << _(" TRACEFILE") << NORMAL << _("]");
           cli << _("\n         \tExport the cards in a set to image files,");
           cli << _("\n         \tIMAGE is the same format as for 'export all card images'.");
+          cli << _("\n         \tUse ") << BRIGHT << _("--jobs") << NORMAL << _(" to write the images with N threads.");
+          cli << _("\n         \tWith ") << BRIGHT << _("--profile") << NORMAL << _(", a trace of the export is written to TRACEFILE,");
+          cli << _("\n         \tin the Chrome trace format (for chrome://tracing or Perfetto).");
           cli << _("\n\n  ") << BRIGHT << _("--cli") << NORMAL << _(" [")
                              << PARAM << _("FILE") << NORMAL << _("] [")
                              << BRIGHT << _("--quiet") << NORMAL << _("] [")
@@ -198,6 +229,11 @@ int MSE::OnRun() {
           cli << _("\n         \tStart the command line interface for performing commands on the set file.");
           cli << _("\n         \tUse ") << BRIGHT << _("-q") << NORMAL << _(" or ") << BRIGHT << _("--quiet") << NORMAL << _(" to supress the startup banner and prompts.");
           cli << _("\n         \tUse ") << BRIGHT << _("-raw") << NORMAL << _(" for raw output mode.");
+          cli << _("\n\n  ") << BRIGHT << _("--server") << NORMAL;
+          cli << _("\n         \tStart a server for other programs, that keeps sets and packages loaded between requests.");
+          cli << _("\n         \tRequests are read from the standard input, and responses written to the standard output,");
+          cli << _("\n         \tas JSON objects on a single line.");
+          cli << _("\n         \tMethods: load_set, unload_set, eval, export_images, export, reload_packages, shutdown.");
           cli << _("\n\nRaw output mode is intended for use by other programs:");
           cli << _("\n    - The only output is only in response to commands.");
           cli << _("\n    - For each command a single 'record' is written to the standard output.");
@@ -232,28 +268,46 @@ int MSE::OnRun() {
           }
           CLISetInterface cli_interface(set,quiet);
           return EXIT_SUCCESS;
+        } else if (arg == _("--server")) {
+          // batch server, reading requests from stdin
+          CLIServer server;
+          server.run();
+          return EXIT_SUCCESS;
         } else if (arg == _("--export-images")) {
+          String trace_file = take_profile_argument(args);
           if (args.size() < 2) {
             handle_error(Error(_("No input file specified for --export")));
             return EXIT_FAILURE;
           }
           SetP set = import_set(args[1]);
-          // path
-          String out = args.size() >= 3 && !starts_with(args[2], _("--"))
-            ? args[2]
-            : settings.gameSettingsFor(*set->game).images_export_filename;
-          String path = _(".");
-          size_t pos = out.find_last_of(_("/\\"));
-          if (pos != String::npos) {
-            path = out.substr(0, pos);
-            if (!wxDirExists(path)) wxMkdir(path);
-            path += _("/x");
-            out = out.substr(pos + 1);
+          // options
+          String out;
+          long jobs = 1;
+          for (size_t i = 2; i < args.size(); ++i) {
+            if (args[i] == _("--jobs") || args[i] == _("-j")) {
+              if (i + 1 >= args.size() || !args[i+1].ToLong(&jobs) || jobs < 1) {
+                handle_error(Error(_("--jobs expects a positive number")));
+                return EXIT_FAILURE;
+              }
+              ++i;
+            } else if (out.empty() && !starts_with(args[i], _("--"))) {
+              out = args[i];
+            }
           }
           // export
-          export_images(set, set->cards, path, out, CONFLICT_NUMBER_OVERWRITE);
+          wxStopWatch timer;
+          size_t count = export_images(set, out, (int)jobs);
+          double seconds = timer.Time() / 1000.0;
+          cli << String::Format(_("Exported %d card images in %.2f seconds (%.1f cards/sec)"),
+                                (int)count, seconds, seconds > 0 ? count / seconds : 0.0) << ENDL;
+          if (!trace_file.empty()) {
+            stop_tracing();
+            write_trace(trace_file);
+          }
+          cli.flush();
           return EXIT_SUCCESS;
         } else if (args[0] == _("--export")) {
+          String trace_file = take_profile_argument(args);
           if (args.size() < 2) {
             throw Error(_("No export template specified for --export"));
           } else if (args.size() < 3) {
@@ -267,6 +321,10 @@ int MSE::OnRun() {
           if (out.empty()) {
             cli << result->toString();
           }
+          if (!trace_file.empty()) {
+            stop_tracing();
+            write_trace(trace_file);
+          }
           return EXIT_SUCCESS;
         } else {
           handle_error(_("Invalid command line argument:\n") + arg);
@@ -16,7 +16,6 @@
 #include <data/settings.hpp>
 #include <data/action/value.hpp>
 #include <data/action/set.hpp>
-#include <gui/util.hpp> // clearDC
 
 // ----------------------------------------------------------------------------- : DataViewer
 
@@ -33,11 +32,16 @@ void DataViewer::draw(DC& dc) {
                 nativeLook() ? QUALITY_LOW : (ss.card_anti_alias() ? QUALITY_AA : QUALITY_SUB_PIXEL));
   draw(rdc, stylesheet->card_background);
 }
+void DataViewer::draw(RasterCanvas& canvas) {
+  RotatedDC rdc(canvas, getRotation());
+  draw(rdc, stylesheet->card_background);
+}
 void DataViewer::draw(RotatedDC& dc, const Color& background) {
   if (!set) return; // no set specified, don't draw anything
   WITH_DYNAMIC_ARG(drawing_card, true);
   // fill with background color
-  clearDC(dc.getDC(), background);
+  dc.SetBrush(background);
+  dc.Fill();
   // update style scripts
   updateStyles(false);
   // prepare viewers
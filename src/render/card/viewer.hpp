@@ -31,6 +31,8 @@ public:
   
   /// Draw the current (card/data) to the given dc
   virtual void draw(DC& dc);
+  /// Draw the current (card/data) to the given canvas
+  void draw(RasterCanvas& canvas);
   /// Draw the current (card/data) to the given dc
   virtual void draw(RotatedDC& dc, const Color& background);
   /// Draw a single viewer
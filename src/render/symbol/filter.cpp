@@ -9,6 +9,7 @@
 #include <util/prec.hpp>
 #include <render/symbol/filter.hpp>
 #include <render/symbol/viewer.hpp>
+#include <render/symbol/rasterizer.hpp>
 #include <gfx/gfx.hpp>
 #include <util/error.hpp>
 
@@ -49,6 +50,10 @@ void filter_symbol(Image& symbol, const SymbolFilter& filter) {
 }
 
 Image render_symbol(const SymbolP& symbol, const SymbolFilter& filter, double border_radius, int width, int height, bool edit_hints, bool allow_smaller) {
+  if (!edit_hints) {
+    // editing hints can only be drawn on a DC
+    return rasterize_symbol(symbol, filter, border_radius, width, height, allow_smaller);
+  }
   Image i = render_symbol(symbol, border_radius, width, height, edit_hints, allow_smaller);
   filter_symbol(i, filter);
   return i;
@@ -62,6 +67,12 @@ IMPLEMENT_REFLECTION_NO_SCRIPT(SymbolFilter) {
     REFLECT(fill_type);
   }
 }
+void SymbolFilter::colorRow(int x0, int y, int count, int width, int height, SymbolSet point, Color* out) const {
+  for (int i = 0 ; i < count ; ++i) {
+    out[i] = color((double)(x0 + i) / width, (double)y / height, point);
+  }
+}
+
 template <> void GetMember::handle(const intrusive_ptr<SymbolFilter>& f) {
   handle(*f);
 }
@@ -93,6 +104,13 @@ Color SolidFillSymbolFilter::color(double x, double y, SymbolSet point) const {
   else                             return Color(0,0,0,0);
 }
 
+void SolidFillSymbolFilter::colorRow(int, int, int count, int, int, SymbolSet point, Color* out) const {
+  Color c = point == SYMBOL_INSIDE ? fill_color
+          : point == SYMBOL_BORDER ? border_color
+          : Color(0,0,0,0);
+  fill(out, out + count, c);
+}
+
 bool SolidFillSymbolFilter::operator == (const SymbolFilter& that) const {
   const SolidFillSymbolFilter* that2 = dynamic_cast<const SolidFillSymbolFilter*>(&that);
   return that2 && fill_color   == that2->fill_color
@@ -114,6 +132,22 @@ Color GradientSymbolFilter::color(double x, double y, SymbolSet point, const T*
   else                             return Color(0,0,0,0);
 }
 
+void GradientSymbolFilter::colorRow(const double* t, int count, SymbolSet point, Color* out) const {
+  if (point == SYMBOL_OUTSIDE) {
+    fill(out, out + count, Color(0,0,0,0));
+    return;
+  }
+  const Color& a = point == SYMBOL_INSIDE ? fill_color_1 : border_color_1;
+  const Color& b = point == SYMBOL_INSIDE ? fill_color_2 : border_color_2;
+  // same as lerp(a,b,t[i]), without the function call
+  int ar = a.Red(), ag = a.Green(), ab = a.Blue(), aa = a.Alpha();
+  int dr = b.Red() - ar, dg = b.Green() - ag, db = b.Blue() - ab, da = b.Alpha() - aa;
+  for (int i = 0 ; i < count ; ++i) {
+    out[i] = Color(static_cast<int>(ar + dr * t[i]), static_cast<int>(ag + dg * t[i]),
+                   static_cast<int>(ab + db * t[i]), static_cast<int>(aa + da * t[i]));
+  }
+}
+
 bool GradientSymbolFilter::equal(const GradientSymbolFilter& that) const {
   return fill_color_1   == that.fill_color_1
       && fill_color_2   == that.fill_color_2
@@ -160,6 +194,18 @@ double LinearGradientSymbolFilter::t(double x, double y) const {
   return min(1.,max(0.,t));
 }
 
+void LinearGradientSymbolFilter::colorRow(int x0, int y, int count, int width, int height, SymbolSet point, Color* out) const {
+  double len = sqr(end_x - center_x) + sqr(end_y - center_y);
+  if (len == 0) len = 1; // prevent div by 0
+  double dy = ((double)y / height - center_y) * (end_y - center_y);
+  double dx = end_x - center_x;
+  vector<double> t(count);
+  for (int i = 0 ; i < count ; ++i) {
+    t[i] = min(1., max(0., fabs(((double)(x0 + i) / width - center_x) * dx + dy) / len));
+  }
+  GradientSymbolFilter::colorRow(t.data(), count, point, out);
+}
+
 bool LinearGradientSymbolFilter::operator == (const SymbolFilter& that) const {
   const LinearGradientSymbolFilter* that2 = dynamic_cast<const LinearGradientSymbolFilter*>(&that);
   return that2 && equal(*that2)
@@ -185,6 +231,15 @@ double RadialGradientSymbolFilter::t(double x, double y) const {
   return sqrt( (sqr(x - 0.5) + sqr(y - 0.5)) * 2); 
 }
 
+void RadialGradientSymbolFilter::colorRow(int x0, int y, int count, int width, int height, SymbolSet point, Color* out) const {
+  double dy2 = sqr((double)y / height - 0.5);
+  vector<double> t(count);
+  for (int i = 0 ; i < count ; ++i) {
+    t[i] = sqrt((sqr((double)(x0 + i) / width - 0.5) + dy2) * 2);
+  }
+  GradientSymbolFilter::colorRow(t.data(), count, point, out);
+}
+
 bool RadialGradientSymbolFilter::operator == (const SymbolFilter& that) const {
   const RadialGradientSymbolFilter* that2 = dynamic_cast<const RadialGradientSymbolFilter*>(&that);
   return that2 && equal(*that2);
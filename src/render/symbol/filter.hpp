@@ -42,6 +42,11 @@ public:
   /// What color should the symbol have at location (x, y)?
   /** x,y are in the range [0...1) */
   virtual Color color(double x, double y, SymbolSet point) const = 0;
+  /// Colors of a row of pixels in an image of the given size
+  /** out[i] = color((x0 + i) / width, y / height, point) for i < count.
+   *  Filters should override this with something faster than calling color for each pixel.
+   */
+  virtual void colorRow(int x0, int y, int count, int width, int height, SymbolSet point, Color* out) const;
   /// Name of this fill type
   virtual String fillType() const = 0;
   /// Comparision
@@ -63,6 +68,7 @@ public:
     : fill_color(fill_color), border_color(border_color)
   {}
   Color color(double x, double y, SymbolSet point) const override;
+  void colorRow(int x0, int y, int count, int width, int height, SymbolSet point, Color* out) const override;
   String fillType() const override;
   bool operator == (const SymbolFilter& that) const override;
 private:
@@ -83,6 +89,8 @@ protected:
   Color fill_color_2, border_color_2;
   template <typename T>
   Color color(double x, double y, SymbolSet point, const T* t) const;
+  /// Colors of a row of pixels given the time on the gradient of each pixel
+  void colorRow(const double* t, int count, SymbolSet point, Color* out) const;
   bool equal(const GradientSymbolFilter& that) const;
   
   DECLARE_REFLECTION_OVERRIDE();
@@ -96,6 +104,7 @@ public:
                             ,double center_x, double center_y, double end_x, double end_y);
   
   Color color(double x, double y, SymbolSet point) const override;
+  void colorRow(int x0, int y, int count, int width, int height, SymbolSet point, Color* out) const override;
   String fillType() const override;
   bool operator == (const SymbolFilter& that) const override;
   
@@ -118,6 +127,7 @@ public:
   {}
   
   Color color(double x, double y, SymbolSet point) const override;
+  void colorRow(int x0, int y, int count, int width, int height, SymbolSet point, Color* out) const override;
   String fillType() const override;
   bool operator == (const SymbolFilter& that) const override;
   
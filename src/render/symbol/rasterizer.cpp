@@ -0,0 +1,237 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <render/symbol/rasterizer.hpp>
+#include <render/symbol/viewer.hpp>
+#include <render/symbol/filter.hpp>
+#include <gfx/bezier.hpp>
+
+// ----------------------------------------------------------------------------- : Simple rendering
+
+Image rasterize_symbol(const SymbolP& symbol, const SymbolFilter& filter, double border_radius, int width, int height, bool allow_smaller) {
+  SymbolViewer viewer(symbol, false, width, border_radius);
+  fit_symbol_viewer(viewer, width, height, allow_smaller);
+  SymbolRasterizer rasterizer(width, height, viewer.origin, viewer.multiply, viewer.rotation.trS(viewer.border_radius));
+  return rasterizer.render(*symbol, filter);
+}
+
+// ----------------------------------------------------------------------------- : Coverage arithmetic
+
+// Coverage is in the range [0..255]
+
+inline Byte cov_union(int a, int b)     { return (Byte)(a + b - a * b / 255); }
+inline Byte cov_intersect(int a, int b) { return (Byte)(a * b / 255); }
+inline Byte cov_subtract(int a, int b)  { return (Byte)(a * (255 - b) / 255); }
+inline Byte cov_xor(int a, int b)       { return (Byte)(a + b - 2 * (a * b / 255)); }
+
+// ----------------------------------------------------------------------------- : SymbolRasterizer
+
+SymbolRasterizer::SymbolRasterizer(int width, int height, const Vector2D& origin, const Matrix2D& multiply, double border_width)
+  : width(width), height(height)
+  , origin(origin), multiply(multiply)
+  , border_width(border_width)
+  , layer_filled(false)
+{}
+
+Image SymbolRasterizer::render(const Symbol& symbol, const SymbolFilter& filter) {
+  size_t size = (size_t)width * height;
+  border.assign(size, 0);
+  interior.assign(size, 0);
+  result_border.assign(size, 0);
+  result_interior.assign(size, 0);
+  layer_rect = wxRect();
+  layer_filled = false;
+  // combine all parts
+  combinePart(symbol, true);
+  if (layer_filled) finishLayer();
+  // apply the filter
+  Image img(width, height, false);
+  Byte* data  = img.GetData();
+  // HACK: see filter_symbol
+  Byte* alpha = (Byte*) malloc(size);
+  img.SetAlpha(alpha);
+  vector<Color> inside_row(width), border_row(width), outside_row(width);
+  for (int y = 0 ; y < height ; ++y) {
+    filter.colorRow(0, y, width, width, height, SYMBOL_INSIDE,  inside_row.data());
+    filter.colorRow(0, y, width, width, height, SYMBOL_BORDER,  border_row.data());
+    filter.colorRow(0, y, width, width, height, SYMBOL_OUTSIDE, outside_row.data());
+    const Byte* ci = &result_interior[(size_t)y * width];
+    const Byte* cb = &result_border  [(size_t)y * width];
+    for (int x = 0 ; x < width ; ++x) {
+      int wi = ci[x], wb = cb[x], wo = 255 - wi - wb;
+      Color c;
+      if      (wi == 255) c = inside_row[x];
+      else if (wb == 255) c = border_row[x];
+      else if (wo == 255) c = outside_row[x];
+      else {
+        // mix the colors, with premultiplied alpha
+        const Color& a = inside_row[x], & b = border_row[x], & o = outside_row[x];
+        int ai = wi * a.Alpha(), ab = wb * b.Alpha(), ao = wo * o.Alpha();
+        int total = ai + ab + ao;
+        if (total > 0) {
+          c = Color((Byte)((ai * a.Red()   + ab * b.Red()   + ao * o.Red())   / total),
+                    (Byte)((ai * a.Green() + ab * b.Green() + ao * o.Green()) / total),
+                    (Byte)((ai * a.Blue()  + ab * b.Blue()  + ao * o.Blue())  / total),
+                    (Byte)((total + 127) / 255));
+        }
+      }
+      data[0] = c.Red();
+      data[1] = c.Green();
+      data[2] = c.Blue();
+      *alpha  = c.Alpha();
+      data  += 3;
+      alpha += 1;
+    }
+  }
+  return img;
+}
+
+void SymbolRasterizer::combinePart(const SymbolPart& part, bool allow_overlap) {
+  if (const SymbolShape* s = part.isSymbolShape()) {
+    if (s->combine == SYMBOL_COMBINE_OVERLAP && layer_filled && allow_overlap) {
+      // We will be overlapping some previous parts
+      finishLayer();
+    }
+    combineShape(*s);
+    layer_filled = true;
+  } else if (const SymbolSymmetry* s = part.isSymbolSymmetry()) {
+    // Draw all parts, in reverse order (bottom to top), also draw rotated copies
+    // see SymbolViewer::combineSymbolPart for the math
+    Radians b = 2 * s->handle.angle();
+    Matrix2D old_m = multiply;
+    Vector2D old_o = origin;
+    int copies = s->kind == SYMMETRY_REFLECTION ? s->copies / 2 * 2 : s->copies;
+    FOR_EACH_CONST_REVERSE(p, s->parts) {
+      for (int i = copies - 1 ; i >= 0 ; --i) {
+        double a = i * 2 * M_PI / copies;
+        if (s->kind == SYMMETRY_ROTATION || i % 2 == 0) {
+          Matrix2D rot(cos(a),-sin(a), sin(a),cos(a));
+          multiply = rot * old_m;
+          origin = old_o + (s->center - s->center * rot) * old_m;
+        } else {
+          Matrix2D rot(cos(a+b),sin(a+b), sin(a+b),-cos(a+b));
+          multiply = rot * old_m;
+          origin = old_o + (s->center - s->center * rot) * old_m;
+        }
+        combinePart(*p, allow_overlap && i == copies - 1);
+      }
+    }
+    multiply = old_m;
+    origin   = old_o;
+  } else if (const SymbolGroup* g = part.isSymbolGroup()) {
+    // Draw all parts, in reverse order (bottom to top)
+    FOR_EACH_CONST_REVERSE(p, g->parts) {
+      combinePart(*p, allow_overlap);
+    }
+  }
+}
+
+void SymbolRasterizer::combineShape(const SymbolShape& s) {
+  // create point list
+  points.clear();
+  size_t count = s.points.size();
+  for (size_t i = 0 ; i < count ; ++i) {
+    segment_subdivide(*s.getPoint((int)i), *s.getPoint((int)i+1), origin, multiply, points);
+  }
+  // the area that the shape can cover
+  bool has_border = border_width > 0;
+  shape.clear();
+  shape.addPolygon(points);
+  int grow = has_border ? (int)ceil(border_width / 2) + 1 : 0;
+  wxRect rect = shape.getBounds().Inflate(grow).Intersect(wxRect(0, 0, width, height));
+  if (shape.empty()) rect = wxRect();
+  // coverage of the interior (fill) and of the interior with the border around it (stroke),
+  // like DrawPolygon, the interior uses the even-odd rule
+  shape.render(FILL_EVEN_ODD, rect, fill);
+  if (has_border) {
+    shape.clear();
+    shape.addStroke(points, true, border_width);
+    shape.render(FILL_NONZERO, rect, stroke);
+    for (size_t i = 0 ; i < stroke.size() ; ++i) {
+      stroke[i] = max(stroke[i], fill[i]);
+    }
+  }
+  // combine
+  SymbolShapeCombine combine = s.combine;
+  if (combine == SYMBOL_COMBINE_INTERSECTION) {
+    // everything outside the shape is removed
+    for (int y = layer_rect.y ; y < layer_rect.GetBottom() + 1 ; ++y) {
+      for (int x = layer_rect.x ; x < layer_rect.GetRight() + 1 ; ++x) {
+        if (rect.Contains(x, y)) continue;
+        size_t p = (size_t)y * width + x;
+        border[p] = interior[p] = 0;
+      }
+    }
+    layer_rect.Intersect(rect);
+  } else if (combine != SYMBOL_COMBINE_SUBTRACT && !rect.IsEmpty()) {
+    layer_rect = layer_rect.IsEmpty() ? rect : layer_rect.Union(rect);
+  }
+  for (int y = 0 ; y < rect.height ; ++y) {
+    size_t p = (size_t)(rect.y + y) * width + rect.x;
+    size_t j = (size_t)y * rect.width;
+    Byte* b = &border[p];
+    Byte* i = &interior[p];
+    const Byte* f  = &fill[j];
+    const Byte* bs = has_border ? &stroke[j] : nullptr;
+    switch (combine) {
+      case SYMBOL_COMBINE_OVERLAP:
+      case SYMBOL_COMBINE_MERGE:
+        for (int x = 0 ; x < rect.width ; ++x) {
+          if (bs) b[x] = cov_union(b[x], bs[x]);
+          i[x] = cov_union(i[x], f[x]);
+        }
+        break;
+      case SYMBOL_COMBINE_SUBTRACT:
+        for (int x = 0 ; x < rect.width ; ++x) {
+          if (bs) b[x] = cov_subtract(b[x], f[x]);
+          i[x] = cov_subtract(i[x], f[x]);
+        }
+        break;
+      case SYMBOL_COMBINE_INTERSECTION:
+        for (int x = 0 ; x < rect.width ; ++x) {
+          b[x] = bs ? cov_intersect(b[x], bs[x]) : 0;
+          i[x] = cov_intersect(i[x], f[x]);
+        }
+        break;
+      case SYMBOL_COMBINE_DIFFERENCE:
+        // the border is only drawn outside the shape
+        for (int x = 0 ; x < rect.width ; ++x) {
+          if (bs) b[x] = cov_union(cov_subtract(b[x], f[x]), cov_subtract(bs[x], f[x]));
+          i[x] = cov_xor(i[x], f[x]);
+        }
+        break;
+      case SYMBOL_COMBINE_BORDER:
+        // draw border as interior
+        for (int x = 0 ; x < rect.width ; ++x) {
+          b[x] = cov_union(b[x], f[x]);
+        }
+        break;
+    }
+  }
+}
+
+void SymbolRasterizer::finishLayer() {
+  // Pixels in the interior of this layer become inside, the rest of the border becomes border,
+  // the remainder shows the layers below.
+  for (int y = layer_rect.y ; y < layer_rect.GetBottom() + 1 ; ++y) {
+    size_t p = (size_t)y * width + layer_rect.x;
+    Byte* b  = &border[p];
+    Byte* i  = &interior[p];
+    Byte* rb = &result_border[p];
+    Byte* ri = &result_interior[p];
+    for (int x = 0 ; x < layer_rect.width ; ++x) {
+      int wi = i[x], wb = max(0, b[x] - i[x]), rest = 255 - wi - wb;
+      ri[x] = (Byte)(wi + rest * ri[x] / 255);
+      rb[x] = (Byte)(wb + rest * rb[x] / 255);
+      b[x] = i[x] = 0;
+    }
+  }
+  layer_rect = wxRect();
+  layer_filled = false;
+}
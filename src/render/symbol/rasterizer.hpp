@@ -0,0 +1,60 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <util/vector2d.hpp>
+#include <data/symbol.hpp>
+#include <gfx/raster.hpp>
+
+class SymbolFilter;
+
+// ----------------------------------------------------------------------------- : Rasterizing symbols
+
+/// Render a Symbol to an Image and filter it, with anti-aliasing and without using a DC
+/** The parameters are the same as for render_symbol, editing hints are not supported.
+ */
+Image rasterize_symbol(const SymbolP& symbol, const SymbolFilter& filter, double border_radius, int width, int height, bool allow_smaller);
+
+/// Renders symbols by computing the coverage of the border and the interior of each pixel
+/** The shapes are combined in the same way as SymbolViewer does with its DCs:
+ *  Each layer (separated by overlapping shapes) has a border and an interior buffer,
+ *  the shapes are combined into these buffers using their combine mode.
+ *  A finished layer is drawn on top of the previous layers.
+ *  Instead of bits the buffers hold coverage, combined as if the coverage of different shapes is independent.
+ */
+class SymbolRasterizer {
+public:
+  /// Render to an image of the given size, points are transformed with origin + p * multiply
+  SymbolRasterizer(int width, int height, const Vector2D& origin, const Matrix2D& multiply, double border_width);
+
+  /// Render a symbol, and color it using a filter
+  Image render(const Symbol& symbol, const SymbolFilter& filter);
+
+private:
+  int width, height;
+  Vector2D origin;        ///< Current transformation
+  Matrix2D multiply;
+  double border_width;    ///< Width of the border in pixels
+
+  vector<Byte> border, interior;               ///< Coverage of the current layer
+  vector<Byte> result_border, result_interior; ///< Coverage of the finished layers, the border excludes the interior
+  wxRect layer_rect;      ///< Part of the current layer that can be non-zero
+  bool layer_filled;      ///< Has anything been drawn in the current layer?
+
+  // buffers, kept to prevent reallocation
+  PolygonRasterizer shape;
+  vector<Vector2D>  points;
+  vector<Byte>      fill, stroke;
+
+  void combinePart(const SymbolPart& part, bool allow_overlap);
+  void combineShape(const SymbolShape& shape);
+  /// Draw the current layer on top of the finished layers, and clear it
+  void finishLayer();
+};
@@ -15,8 +15,19 @@
 
 Image render_symbol(const SymbolP& symbol, double border_radius, int width, int height, bool editing_hints, bool allow_smaller) {
   SymbolViewer viewer(symbol, editing_hints, width, border_radius);
+  fit_symbol_viewer(viewer, width, height, allow_smaller);
+  Bitmap bmp(width, height);
+  wxMemoryDC dc;
+  dc.SelectObject(bmp);
+  clearDC(dc, Color(0,128,0));
+  viewer.draw(dc);
+  dc.SelectObject(wxNullBitmap);
+  return bmp.ConvertToImage();
+}
+
+void fit_symbol_viewer(SymbolViewer& viewer, int& width, int& height, bool allow_smaller) {
   // limit width/height ratio to aspect ratio of symbol
-  double ar  = symbol->aspectRatio();
+  double ar  = viewer.getSymbol()->aspectRatio();
   double par = (double)width/height;
   if (par > ar && (ar > 1 || (allow_smaller && height < width))) {
     width  = int(height * ar);
@@ -32,13 +43,6 @@ Image render_symbol(const SymbolP& symbol, double border_radius, int width, int
     viewer.setOrigin(Vector2D(-(height-width) * 0.5,0));
     viewer.border_radius *= (double)width / height;
   }
-  Bitmap bmp(width, height);
-  wxMemoryDC dc;
-  dc.SelectObject(bmp);
-  clearDC(dc, Color(0,128,0));
-  viewer.draw(dc);
-  dc.SelectObject(wxNullBitmap);
-  return bmp.ConvertToImage();
 }
 
 // ----------------------------------------------------------------------------- : Constructor
@@ -18,6 +18,14 @@
 /// Render a Symbol to an Image
 Image render_symbol(const SymbolP& symbol, double border_radius = 0.05, int width = 100, int height = 100, bool editing_hints = false, bool allow_smaller = false);
 
+class SymbolViewer;
+
+/// Zoom and position a viewer so the symbol fills an image of the given size
+/** The width or height is made smaller to match the aspect ratio of the symbol
+ *  if the aspect ratio is larger than 1 or if allow_smaller.
+ */
+void fit_symbol_viewer(SymbolViewer& viewer, int& width, int& height, bool allow_smaller);
+
 // ----------------------------------------------------------------------------- : Symbol Viewer
 
 enum HighlightStyle
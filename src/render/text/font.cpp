@@ -9,6 +9,91 @@
 #include <util/prec.hpp>
 #include <render/text/element.hpp>
 #include <data/font.hpp>
+#include <wx/thread.h>
+
+// ----------------------------------------------------------------------------- : Measurement cache
+
+/// Cache of the sizes of the characters in a piece of text
+/** Finding the scale of a text box measures the same text at many scales,
+ *  and the same text is measured again every time a card is drawn.
+ *  The key contains the font and zoom (see RotatedDC::GetTextExtentKey) and the text.
+ */
+class CharInfoCache {
+public:
+  CharInfoCache(size_t max_size) : max_size(max_size) {}
+  
+  /// Append the cached sizes to out, if there are any
+  bool get(const String& key, vector<CharInfo>& out) {
+    wxMutexLocker lock(mutex);
+    auto it = cache.find(key);
+    if (it == cache.end()) return false;
+    out.insert(out.end(), it->second.begin(), it->second.end());
+    return true;
+  }
+  void add(const String& key, vector<CharInfo>::const_iterator begin, vector<CharInfo>::const_iterator end) {
+    wxMutexLocker lock(mutex);
+    // simply start over when the cache is full
+    if (cache.size() >= max_size) cache.clear();
+    cache.emplace(key, vector<CharInfo>(begin, end));
+  }
+  
+private:
+  const size_t max_size;
+  wxMutex mutex; // text can be measured by multiple threads
+  unordered_map<String, vector<CharInfo>> cache;
+};
+
+CharInfoCache char_info_cache(10000);
+
+// ----------------------------------------------------------------------------- : Glyph advances
+
+/// Sizes of the characters of a single font
+/** The width of a piece of text is the sum of the widths of its characters,
+ *  plus a kerning correction for each pair of adjacent characters.
+ *  Each character and each pair is only measured once.
+ */
+class GlyphAdvances {
+public:
+  /// Size of character c, when it comes after prev (or prev = 0 at the start of a line)
+  RealSize size(RotatedDC& dc, Char prev, Char c) {
+    RealSize s = glyph(dc, c);
+    if (prev) s.width += kerning(dc, prev, c);
+    return s;
+  }
+  /// Height of a line
+  double charHeight(RotatedDC& dc) {
+    if (char_height < 0) char_height = dc.GetCharHeight();
+    return char_height;
+  }
+  
+private:
+  double char_height = -1;
+  unordered_map<Char, RealSize> glyphs;
+  unordered_map<unsigned long long, double> kernings; ///< indexed by (prev << 32 | c)
+  
+  const RealSize& glyph(RotatedDC& dc, Char c) {
+    auto it = glyphs.find(c);
+    if (it != glyphs.end()) return it->second;
+    return glyphs[c] = dc.GetTextExtent(String(1, c));
+  }
+  double kerning(RotatedDC& dc, Char prev, Char c) {
+    unsigned long long pair = (unsigned long long)prev << 32 | (unsigned long long)c;
+    auto it = kernings.find(pair);
+    if (it != kernings.end()) return it->second;
+    String text(1, prev); text += c;
+    return kernings[pair] = dc.GetTextExtent(text).width - glyph(dc, prev).width - glyph(dc, c).width;
+  }
+};
+
+/// Glyph advances, indexed by RotatedDC::GetTextExtentKey
+unordered_map<String, GlyphAdvances> glyph_advances;
+wxMutex glyph_advances_mutex;
+
+GlyphAdvances& glyph_advances_for(const String& font_key) {
+  // simply start over when there are too many fonts
+  if (glyph_advances.size() >= 256 && !glyph_advances.count(font_key)) glyph_advances.clear();
+  return glyph_advances[font_key];
+}
 
 // ----------------------------------------------------------------------------- : FontTextElement
 
@@ -27,25 +112,31 @@ void FontTextElement::draw(RotatedDC& dc, double scale, const RealRect& rect, co
 void FontTextElement::getCharInfo(RotatedDC& dc, double scale, vector<CharInfo>& out) const {
   // font
   dc.SetFont(*font, scale);
+  // measured before?
+  String font_key = dc.GetTextExtentKey();
+  String key = font_key;
+  key << _('\1') << (int)break_style << (draw_as == DRAW_ACTIVE ? _('s') : _('n')) << content.substr(start - this->start, end - start);
+  if (char_info_cache.get(key, out)) return;
+  size_t first = out.size();
   // find sizes & breaks
-  double prev_width = 0;
-  size_t line_start = start; // start of the current line
+  wxMutexLocker lock(glyph_advances_mutex);
+  GlyphAdvances& glyphs = glyph_advances_for(font_key);
+  Char prev = 0; // previous character on the current line
   for (size_t i = start ; i < end ; ++i) {
     Char c = content.GetChar(i - this->start);
     if (c == _('\n')) {
-      out.push_back(CharInfo(RealSize(0, dc.GetCharHeight()), break_style, draw_as == DRAW_ACTIVE));
-      line_start = i + 1;
-      prev_width = 0;
+      out.push_back(CharInfo(RealSize(0, glyphs.charHeight(dc)), break_style, draw_as == DRAW_ACTIVE));
+      prev = 0;
     } else {
-      RealSize s = dc.GetTextExtent(content.substr(line_start - this->start, i - line_start + 1));
       out.push_back(CharInfo(
-                       RealSize(s.width - prev_width, s.height),
+                       glyphs.size(dc, prev, c),
                        c == _(' ') ? LineBreak::SPACE : LineBreak::MAYBE,
                        draw_as == DRAW_ACTIVE // from <soft> tag
                    ));
-      prev_width = s.width;
+      prev = c;
     }
   }
+  char_info_cache.add(key, out.begin() + first, out.end());
 }
 
 double FontTextElement::minScale() const {
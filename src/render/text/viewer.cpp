@@ -9,6 +9,7 @@
 #include <util/prec.hpp>
 #include <render/text/viewer.hpp>
 #include <algorithm>
+#include <wx/thread.h>
 
 // ----------------------------------------------------------------------------- : Line
 
@@ -344,6 +345,72 @@ void TextViewer::prepareElements(const String& text, const TextStyle& style, Con
 }
 
 
+// ----------------------------------------------------------------------------- : Layout cache
+
+/// Cache of the lines and scale found by prepareLinesTryScales
+/** Cards with the same text in the same style, such as reprints, are only laid out once.
+ *  Text boxes with a mask are not cached, since the mask can differ per card.
+ */
+class TextLayoutCache {
+public:
+  struct Layout {
+    vector<TextViewer::Line> lines;
+    vector<CharInfo>         chars;
+    double                   scale;
+  };
+  
+  TextLayoutCache(size_t max_size) : max_size(max_size) {}
+  
+  bool get(const String& key, Layout& out) {
+    wxMutexLocker lock(mutex);
+    auto it = cache.find(key);
+    if (it == cache.end()) return false;
+    out = it->second;
+    return true;
+  }
+  void add(const String& key, Layout&& layout) {
+    wxMutexLocker lock(mutex);
+    // simply start over when the cache is full
+    if (cache.size() >= max_size) cache.clear();
+    cache.emplace(key, std::move(layout));
+  }
+  
+private:
+  const size_t max_size;
+  wxMutex mutex;
+  unordered_map<String, Layout> cache;
+};
+
+TextLayoutCache text_layout_cache(1000);
+
+void add_font_to_key(String& key, const Font& font) {
+  key << font.name() << _('\1') << font.italic_name() << _('\1') << font.weight() << _('\1') << font.style()
+      << String::Format(_("\1%g %g %g %d %d\1"), font.size(), font.scale_down_to, font.max_stretch, (int)font.underline(), font.flags);
+}
+
+/// Key for the text_layout_cache, everything that influences the line breaking and scale
+String text_layout_key(RotatedDC& dc, const String& text, const TextStyle& style) {
+  dc.SetFont(style.font, 1.0);
+  String key = dc.GetTextExtentKey(); // includes the zoom and quality
+  key << String::Format(_("\1%g %g %g\1"), dc.getStretch(), dc.getInternalSize().width, dc.getInternalSize().height);
+  add_font_to_key(key, style.font);
+  if (style.symbol_font.valid()) {
+    key << style.symbol_font.name() << String::Format(_("\1%g %g %d\1"), style.symbol_font.size(), style.symbol_font.scale_down_to, (int)style.symbol_font.alignment());
+  }
+  key << String::Format(_("%d %d %d %d %d\1"), (int)style.always_symbol, (int)style.allow_formating, (int)style.field().multi_line, (int)style.direction, (int)style.alignment());
+  key << String::Format(_("%g %g %g %g %g %g %g %g\1"),
+    (double)style.padding_left,   (double)style.padding_left_min,
+    (double)style.padding_right,  (double)style.padding_right_min,
+    (double)style.padding_top,    (double)style.padding_top_min,
+    (double)style.padding_bottom, (double)style.padding_bottom_min);
+  key << String::Format(_("%g %g %g %g %g %g %g\1"),
+    (double)style.line_height_soft, (double)style.line_height_hard, (double)style.line_height_line,
+    (double)style.line_height_soft_max, (double)style.line_height_hard_max, (double)style.line_height_line_max,
+    (double)style.paragraph_height);
+  key << text;
+  return key;
+}
+
 // ----------------------------------------------------------------------------- : Layout
 
 
@@ -391,7 +458,21 @@ TextLayoutP TextViewer::extractLayoutInfo() const {
 
 void TextViewer::prepareLines(RotatedDC& dc, const String& text, TextStyle& style, Context& ctx) {
   vector<CharInfo> chars;
-  prepareLinesTryScales(dc, text, style, chars);
+  if (style.mask.isSet()) {
+    prepareLinesTryScales(dc, text, style, chars);
+  } else {
+    // the same text in the same style might have been laid out before
+    String key = text_layout_key(dc, text, style);
+    TextLayoutCache::Layout layout;
+    if (text_layout_cache.get(key, layout)) {
+      swap(lines, layout.lines);
+      swap(chars, layout.chars);
+      scale = layout.scale;
+    } else {
+      prepareLinesTryScales(dc, text, style, chars);
+      text_layout_cache.add(key, TextLayoutCache::Layout{lines, chars, scale});
+    }
+  }
   assert(!lines.empty());
   
   // no text, find a dummy height for the single line we have
@@ -50,17 +50,15 @@ void ColorValueViewer::draw(RotatedDC& dc) {
             style().top_width  < style().height && style().bottom_width < style().height;
       if (clip) {
         // clip away the inside of the rectangle
-        wxRegion r = dc.trRectToRegion(dc.getInternalRect());
-        r.Subtract(dc.trRectToRegion(RealRect(
+        dc.SetClippingRegion(dc.getInternalRect(), RealRect(
           style().left_width,
           style().top_width,
           style().width  - style().left_width - style().right_width,
           style().height - style().top_width  - style().bottom_width
-        )));
-        dc.getDC().SetClippingRegion(r);
+        ));
       }
       dc.DrawRoundedRectangle(dc.getInternalRect(), style().radius);
-      if (clip) dc.getDC().DestroyClippingRegion();
+      if (clip) dc.DestroyClippingRegion();
     }
     drawFieldBorder(dc);
   }
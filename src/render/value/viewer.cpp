@@ -79,11 +79,11 @@ void ValueViewer::drawFieldBorder(RotatedDC& dc) {
     const AlphaMask& alpha_mask = getMask(dc);
     if (alpha_mask.isLoaded()) {
       // from mask
-      vector<wxPoint> points;
-      alpha_mask.convexHull(points);
-      if (points.size() < 3) return;
-      FOR_EACH(p, points) p = dc.trPixelNoZoom(RealPoint(p.x,p.y));
-      dc.getDC().DrawPolygon((int)points.size(), &points[0]);
+      vector<wxPoint> hull;
+      alpha_mask.convexHull(hull);
+      vector<RealPoint> points;
+      FOR_EACH_CONST(p, hull) points.push_back(dc.trPixelNoZoom(RealPoint(p.x,p.y)));
+      dc.DrawPreRotatedPolygon(points);
     } else {
       // simple rectangle
       dc.DrawRectangle(dc.getInternalRect().grow(dc.trInvS(1)));
@@ -50,9 +50,6 @@ ScriptValueP Context::eval(const Script& script, bool useScope) {
     while (instr < end) {
       // Evaluate the current instruction
       Instruction i = *instr++;
-      // If a scope is created, destroy it at end of block.
-      unique_ptr<LocalScope> new_scope;
-
       switch (i.instr) {
         case I_NOP: break;
         // Push a constant
@@ -109,7 +106,15 @@ ScriptValueP Context::eval(const Script& script, bool useScope) {
         
         // Get an object member
         case I_MEMBER_C: {
-          stack.back() = stack.back()->getMember(script.constants[i.data]->toString());
+          stack.back() = stack.back()->getMember((MemberAtom)i.data);
+          break;
+        }
+        // Get a member of a variable
+        case I_GET_VAR_MEMBER_C: {
+          ScriptValueP value = variables[i.data].value;
+          if (!value) throw ScriptErrorNoVariable(variable_to_string((Variable)i.data));
+          stack.push_back(value->getMember((MemberAtom)instr->data));
+          instr += 1; // skip member name
           break;
         }
         // Loop over a container, push next value or jump
@@ -145,49 +150,48 @@ ScriptValueP Context::eval(const Script& script, bool useScope) {
         }
         
         // Function call
-        case I_CALL:
-          new_scope.reset(new LocalScope(*this)); //new scope
-        case I_TAILCALL: {
+        case I_CALL: {
+          LocalScope new_scope(*this);
           // prepare arguments
           for (unsigned int j = 0 ; j < i.data ; ++j) {
             setVariable((Variable)instr[i.data - j - 1].data, stack.back());
             stack.pop_back();
           }
           instr += i.data; // skip arguments
-          try {
-            #if USE_SCRIPT_PROFILING
-              Timer timer;
-              const Instruction* instr_bt = script.backtraceSkip(instr - i.data - 2, i.data);
-              Variable function = instr_bt && instr_bt->instr == I_GET_VAR
-                                ? (Variable)instr_bt->data
-                                : (Variable)-1;
-              Profiler prof(timer, function);
-            #endif
-            // get function and call.
-            // there is no need to open a new scope for this function, since we already did so for the arguments
-            stack.back() = stack.back()->eval(*this, false);
-            // finish profiling
-            #if USE_SCRIPT_PROFILING
-              //profile_add(function, timer.time());
-              //%timer.exclude_time();
-            #endif
-          } catch (const Error& e) {
-            // try to determine what named function was called
-            // the instructions for this look like:
-            //   I_GET_VAR   name of function
-            //   *code*      arguments
-            //   I_CALL      number of arguments = i.data
-            //   I_NOP * n   arg names
-            //   next        <--- instruction pointer points here
-            // skip the stack effect of the arguments themselfs
-            const Instruction* instr_bt = script.backtraceSkip(instr - i.data - 2, i.data);
-            // have we have reached the name
-            if (instr_bt) {
-              throw ScriptError(_ERROR_2_("in function", e.what(), script.instructionName(instr_bt)));
-            } else {
-              throw e; // rethrow
-            }
+          // the instructions for this look like:
+          //   I_GET_VAR   name of function
+          //   *code*      arguments
+          //   I_CALL      number of arguments = i.data
+          //   I_NOP * n   arg names
+          //   next        <--- instruction pointer points here
+          callFunction(script, instr - i.data - 2, i.data);
+          break;
+        }
+        case I_TAILCALL: {
+          // same as I_CALL, without opening a scope
+          for (unsigned int j = 0 ; j < i.data ; ++j) {
+            setVariable((Variable)instr[i.data - j - 1].data, stack.back());
+            stack.pop_back();
+          }
+          instr += i.data; // skip arguments
+          callFunction(script, instr - i.data - 2, i.data);
+          break;
+        }
+        // Function call with constant arguments
+        case I_CALL_C: {
+          LocalScope new_scope(*this);
+          // prepare arguments, in the same order as I_CALL would
+          for (unsigned int j = 0 ; j < i.data ; ++j) {
+            setVariable((Variable)instr[2 * i.data - j - 1].data, script.constants[instr[i.data - j - 1].data]);
           }
+          instr += 2 * i.data; // skip arguments
+          // the instructions for this look like:
+          //   I_GET_VAR   name of function
+          //   I_CALL_C    number of arguments = i.data
+          //   I_NOP * n   arg values
+          //   I_NOP * n   arg names
+          //   next        <--- instruction pointer points here
+          callFunction(script, instr - 2 * i.data - 2, 0);
           break;
         }
         
@@ -209,6 +213,12 @@ ScriptValueP Context::eval(const Script& script, bool useScope) {
           instrBinary(i.instr2, a, b);
           break;
         }
+        // Simple instruction: binary, with a constant as the second argument
+        case I_PUSH_CONST_BINARY: {
+          instrBinary(instr->instr2, stack.back(), script.constants[i.data]);
+          instr += 1; // skip operator
+          break;
+        }
         // Simple instruction: ternary
         case I_TERNARY: {
           ScriptValueP  c = stack.back(); stack.pop_back();
@@ -257,6 +267,38 @@ ScriptValueP Context::eval(const Script& script, bool useScope) {
   }
 }
 
+void Context::callFunction(const Script& script, const Instruction* instr_bt, unsigned int arg_count) {
+  try {
+    Variable traced_function = (Variable)-1;
+    if (trace_enabled()) {
+      const Instruction* instr_fun = script.backtraceSkip(instr_bt, arg_count);
+      if (instr_fun && instr_fun->instr == I_GET_VAR) traced_function = (Variable)instr_fun->data;
+    }
+    TraceScope trace(traced_function);
+    #if USE_SCRIPT_PROFILING
+      Timer timer;
+      const Instruction* instr_fun = script.backtraceSkip(instr_bt, arg_count);
+      Variable function = instr_fun && instr_fun->instr == I_GET_VAR
+                        ? (Variable)instr_fun->data
+                        : (Variable)-1;
+      Profiler prof(timer, function);
+    #endif
+    // get function and call.
+    // there is no need to open a new scope for this function, since we already did so for the arguments
+    stack.back() = stack.back()->eval(*this, false);
+  } catch (const Error& e) {
+    // try to determine what named function was called
+    // skip the stack effect of the arguments themselfs
+    const Instruction* instr_fun = script.backtraceSkip(instr_bt, arg_count);
+    // have we have reached the name
+    if (instr_fun) {
+      throw ScriptError(_ERROR_2_("in function", e.what(), script.instructionName(instr_fun)));
+    } else {
+      throw; // rethrow
+    }
+  }
+}
+
 void Context::setVariable(const String& name, const ScriptValueP& value) {
   setVariable(string_to_variable(name), value);
 }
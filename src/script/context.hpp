@@ -121,6 +121,11 @@ private:
   void makeObject(size_t n);
   /// Make a closure with n arguments
   void makeClosure(size_t n, const Instruction*& instr);
+  /// Call the function on top of the stack, the arguments should already be set
+  /** instr_bt and arg_count are used to find the name of the function for error messages,
+   *  instr_bt should point to the last instruction of the last argument.
+   */
+  void callFunction(const Script& script, const Instruction* instr_bt, unsigned int arg_count);
   
   /// Get a variable name givin its value, returns (Variable)-1 if not found (slow!)
   Variable lookupVariableValue(const ScriptValueP& value);
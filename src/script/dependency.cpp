@@ -224,7 +224,7 @@ ScriptValueP Context::dependencies(const Dependency& dep, const Script& script)
         
         // Get an object member (almost as normal)
         case I_MEMBER_C: {
-          String name = script.constants[i.data]->toString();
+          const String& name = member_atom_to_string((MemberAtom)i.data);
           stack.back() = stack.back()->dependencyMember(name, dep); // dependency on member
           break;
         }
@@ -279,6 +279,15 @@ ScriptValueP Context::dependencies(const Dependency& dep, const Script& script)
           stack.back() = stack.back()->dependencies(*this, dep);
           break;
         }
+        case I_CALL_C: {
+          LocalScope new_scope(*this);
+          for (unsigned int j = 0 ; j < i.data ; ++j) {
+            setVariable((Variable)instr[2 * i.data - j - 1].data, script.constants[instr[i.data - j - 1].data]);
+          }
+          instr += 2 * i.data; // skip arguments
+          stack.back() = stack.back()->dependencies(*this, dep);
+          break;
+        }
         
         // Closure object (as normal)
         case I_CLOSURE: {
@@ -287,12 +296,18 @@ ScriptValueP Context::dependencies(const Dependency& dep, const Script& script)
         }
         
         // Get a variable (almost as normal)
-        case I_GET_VAR: {
+        case I_GET_VAR: case I_GET_VAR_MEMBER_C: {
           ScriptValueP value = variables[i.data].value;
           if (!value) {
             value = make_intrusive<ScriptMissingVariable>(variable_to_string((Variable)i.data)); // no errors here
           }
           value->dependencyThis(dep);
+          if (i.instr == I_GET_VAR_MEMBER_C) {
+            // followed by I_MEMBER_C
+            const String& name = member_atom_to_string((MemberAtom)instr->data);
+            value = value->dependencyMember(name, dep); // dependency on member
+            instr += 1;
+          }
           stack.push_back(value);
           break;
         }
@@ -315,8 +330,15 @@ ScriptValueP Context::dependencies(const Dependency& dep, const Script& script)
           break;
         }
         // Simple instruction: binary
-        case I_BINARY: {
-          ScriptValueP  b = stack.back(); stack.pop_back();
+        case I_BINARY: case I_PUSH_CONST_BINARY: {
+          ScriptValueP b;
+          if (i.instr == I_PUSH_CONST_BINARY) {
+            // the operator is stored in the next instruction
+            b = script.constants[i.data];
+            i = *instr++;
+          } else {
+            b = stack.back(); stack.pop_back();
+          }
           ScriptValueP& a = stack.back();
           switch (i.instr2) {
             case I_ITERATOR_R:
@@ -21,6 +21,8 @@ enum DependencyType
 ,  DEP_EXTRA_CARD_FIELD  ///< dependency of a script in an extra stylesheet specific card field
 ,  DEP_CARD_COPY_DEP    ///< copy the dependencies from a card field
 ,  DEP_SET_COPY_DEP    ///< copy the dependencies from a set  field
+,  DEP_CARD_STATISTIC  ///< dependency of a statistics dimension script, index gives the dimension
+,  DEP_CARDS_STATISTIC ///< dependency of a statistics dimension script for all cards
 ,  DEP_DUMMY        ///< used for other purposes, index and data can be anything
               //   in particular, this is used for determining /if/ there are dependencies
 };
@@ -38,7 +40,9 @@ public:
   
   /// This dependency, but dependent on all cards instead of just one
   inline Dependency makeCardIndependend() const {
-    return Dependency(type == DEP_CARD_FIELD ? DEP_CARDS_FIELD : type, index, data);
+    return Dependency(type == DEP_CARD_FIELD     ? DEP_CARDS_FIELD
+                    : type == DEP_CARD_STATISTIC ? DEP_CARDS_STATISTIC
+                    :                              type, index, data);
   }
   
   inline bool operator == (const Dependency& d) const {
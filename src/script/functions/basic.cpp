@@ -664,13 +664,7 @@ SCRIPT_FUNCTION_WITH_DEP(expand_keywords) {
   SCRIPT_OPTIONAL_PARAM_N_(ScriptValueP, _("condition"), match_condition);
   SCRIPT_OPTIONAL_PARAM_(ScriptValueP, default_expand);
   SCRIPT_PARAM(ScriptValueP, combine);
-  KeywordDatabase& db = set->keyword_db;
-  if (db.empty()) {
-    db.prepare_parameters(set->game->keyword_parameter_types, set->keywords);
-    db.prepare_parameters(set->game->keyword_parameter_types, set->game->keywords);
-    db.add(set->keywords);
-    db.add(set->game->keywords);
-  }
+  const KeywordDatabase& db = set->keywordDatabase();
   SCRIPT_OPTIONAL_PARAM_C_(CardP, card);
   try {
     KeywordUsageStatistics* stat = card ? &card->keyword_usage : nullptr;
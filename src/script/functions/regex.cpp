@@ -11,6 +11,9 @@
 #include <script/functions/util.hpp>
 #include <util/regex.hpp>
 #include <util/error.hpp>
+#include <script/profiler.hpp>
+#include <list>
+#include <wx/thread.h>
 
 DECLARE_POINTER_TYPE(ScriptRegex);
 
@@ -53,12 +56,59 @@ public:
   using Regex::matches;
 };
 
+// ----------------------------------------------------------------------------- : Regex cache
+
+DECLARE_PROFILE_COUNTER(counter_regex_cache_hits,   _("regex cache hits"));
+DECLARE_PROFILE_COUNTER(counter_regex_cache_misses, _("regex cache misses"));
+
+/// Recently compiled regular expressions, shared by all contexts
+/** Templates usually pass regexes as strings, without a cache they would be compiled on each call.
+ *  When the cache is full, the least recently used regex is dropped.
+ */
+class RegexCache {
+public:
+  RegexCache(size_t max_size) : max_size(max_size) {}
+  
+  ScriptRegexP get(const String& code) {
+    {
+      wxMutexLocker lock(mutex);
+      auto it = lookup.find(code);
+      if (it != lookup.end()) {
+        COUNT_PROFILE(counter_regex_cache_hits);
+        entries.splice(entries.begin(), entries, it->second); // most recently used
+        return it->second->second;
+      }
+    }
+    COUNT_PROFILE(counter_regex_cache_misses);
+    // compile without holding the lock, this can throw for invalid regexes
+    ScriptRegexP regex = make_intrusive<ScriptRegex>(code);
+    wxMutexLocker lock(mutex);
+    if (lookup.find(code) == lookup.end()) {
+      entries.emplace_front(code, regex);
+      lookup.emplace(code, entries.begin());
+      if (entries.size() > max_size) {
+        lookup.erase(entries.back().first);
+        entries.pop_back();
+      }
+    }
+    return regex;
+  }
+  
+private:
+  typedef list<pair<String,ScriptRegexP>> Entries;
+  size_t                         max_size;
+  wxMutex                        mutex;
+  Entries                        entries; ///< most recently used first
+  map<String, Entries::iterator> lookup;
+};
+
+RegexCache regex_cache(256);
+
 ScriptRegexP regex_from_script(const ScriptValueP& value) {
   // is it a regex already?
   ScriptRegexP regex = dynamic_pointer_cast<ScriptRegex>(value);
   if (!regex) {
-    // TODO: introduce some kind of caching?
-    regex = make_intrusive<ScriptRegex>(value->toString());
+    regex = regex_cache.get(value->toString());
   }
   return regex;
 }
@@ -13,6 +13,7 @@
 #include <util/spell_checker.hpp>
 #include <util/tagged_string.hpp>
 #include <data/stylesheet.hpp>
+#include <wx/thread.h>
 
 // ----------------------------------------------------------------------------- : Functions
 
@@ -54,11 +55,16 @@ bool isWordChar(wxUniChar c) {
   return isAlpha(c) || c == '\'' || c == RIGHT_SINGLE_QUOTE;
 }
 
+// the spell checkers and settings are shared, but scripts can be evaluated in multiple threads
+// recursive, because the extra_match function can use check_spelling_word
+wxMutex spelling_mutex(wxMUTEX_RECURSIVE);
+
 SCRIPT_FUNCTION(check_spelling) {
   SCRIPT_PARAM_C(StyleSheetP,stylesheet);
   SCRIPT_PARAM_C(String,language);
   SCRIPT_PARAM_C(String,input);
   assert_tagged(input);
+  wxMutexLocker lock(spelling_mutex);
   if (!settings.stylesheetSettingsFor(*stylesheet).card_spellcheck_enabled)
     SCRIPT_RETURN(input);
   SCRIPT_OPTIONAL_PARAM_(String, extra_dictionary);
@@ -137,6 +143,7 @@ SCRIPT_FUNCTION(check_spelling_word) {
     // no language -> spelling checking
     SCRIPT_RETURN(true);
   } else {
+    wxMutexLocker lock(spelling_mutex);
     auto checker = SpellChecker::get(language);
     bool correct = !checker || checker->spell(input);
     SCRIPT_RETURN(correct);
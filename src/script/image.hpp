@@ -117,6 +117,9 @@ public:
     script.initDependencies(ctx, dep);
   }
   
+  /// Is there a mask?
+  inline bool isSet() const { return script.isSet(); }
+  
   /// Get the alpha mask; with the given options
   /** if img_options.width == 0 and the mask is already loaded, just returns it.
    *  Returns a reference, so calling again might change earlier results.
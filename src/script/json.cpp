@@ -0,0 +1,274 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <util/error.hpp>
+#include <script/json.hpp>
+#include <script/to_value.hpp>
+
+// ----------------------------------------------------------------------------- : Parsing
+
+/// Recursive descent parser for JSON
+class JsonParser {
+public:
+  JsonParser(const String& input) : input(input), pos(0) {}
+
+  ScriptValueP parseDocument() {
+    ScriptValueP value = parseValue();
+    skipWhitespace();
+    if (pos < input.size()) throw error(_("Unexpected characters after the value"));
+    return value;
+  }
+
+private:
+  const String& input;
+  size_t pos;
+
+  ParseError error(const String& what) const {
+    return ParseError(String::Format(_("Invalid JSON at position %d: "), (int)pos) + what);
+  }
+
+  void skipWhitespace() {
+    while (pos < input.size()) {
+      Char c = input.GetChar(pos);
+      if (c != _(' ') && c != _('\t') && c != _('\n') && c != _('\r')) break;
+      ++pos;
+    }
+  }
+  Char peek() {
+    skipWhitespace();
+    if (pos >= input.size()) throw error(_("Unexpected end of input"));
+    return input.GetChar(pos);
+  }
+  void expect(Char c) {
+    if (peek() != c) throw error(String(_("Expected '")) + c + _("'"));
+    ++pos;
+  }
+  bool literal(const Char* word) {
+    size_t len = wxStrlen(word);
+    if (input.compare(pos, len, word) != 0) return false;
+    pos += len;
+    return true;
+  }
+
+  ScriptValueP parseValue() {
+    Char c = peek();
+    if (c == _('{')) return parseObject();
+    if (c == _('[')) return parseArray();
+    if (c == _('"')) return to_script(parseString());
+    if (c == _('-') || (c >= _('0') && c <= _('9'))) return parseNumber();
+    if (literal(_("true")))  return script_true;
+    if (literal(_("false"))) return script_false;
+    if (literal(_("null")))  return script_nil;
+    throw error(_("Expected a value"));
+  }
+
+  ScriptValueP parseObject() {
+    ScriptCustomCollectionP col = make_intrusive<JsonObject>();
+    expect(_('{'));
+    if (peek() == _('}')) { ++pos; return col; }
+    while (true) {
+      if (peek() != _('"')) throw error(_("Expected a key"));
+      String key = parseString();
+      expect(_(':'));
+      col->key_value[key] = parseValue();
+      if (peek() == _('}')) { ++pos; return col; }
+      expect(_(','));
+    }
+  }
+
+  ScriptValueP parseArray() {
+    ScriptCustomCollectionP col = make_intrusive<ScriptCustomCollection>();
+    expect(_('['));
+    if (peek() == _(']')) { ++pos; return col; }
+    while (true) {
+      col->value.push_back(parseValue());
+      if (peek() == _(']')) { ++pos; return col; }
+      expect(_(','));
+    }
+  }
+
+  unsigned int parseHex4() {
+    if (pos + 4 > input.size()) throw error(_("Incomplete \\u escape"));
+    unsigned int code = 0;
+    for (int i = 0 ; i < 4 ; ++i) {
+      Char c = input.GetChar(pos++);
+      code *= 16;
+      if      (c >= _('0') && c <= _('9')) code += c - _('0');
+      else if (c >= _('a') && c <= _('f')) code += c - _('a') + 10;
+      else if (c >= _('A') && c <= _('F')) code += c - _('A') + 10;
+      else throw error(_("Invalid \\u escape"));
+    }
+    return code;
+  }
+
+  String parseString() {
+    expect(_('"'));
+    String result;
+    while (true) {
+      if (pos >= input.size()) throw error(_("Unterminated string"));
+      Char c = input.GetChar(pos++);
+      if (c == _('"')) {
+        return result;
+      } else if (c == _('\\')) {
+        if (pos >= input.size()) throw error(_("Unterminated string"));
+        Char e = input.GetChar(pos++);
+        switch (e) {
+          case _('"'): case _('\\'): case _('/'): result += e; break;
+          case _('b'): result += _('\b'); break;
+          case _('f'): result += _('\f'); break;
+          case _('n'): result += _('\n'); break;
+          case _('r'): result += _('\r'); break;
+          case _('t'): result += _('\t'); break;
+          case _('u'): {
+            unsigned int code = parseHex4();
+            if (code >= 0xD800 && code < 0xDC00) {
+              // surrogate pair
+              size_t after_high = pos;
+              unsigned int low = literal(_("\\u")) ? parseHex4() : 0;
+              if (low >= 0xDC00 && low < 0xE000) {
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+              } else {
+                // a lone high surrogate becomes a replacement character, what follows it is read on its own
+                code = 0xFFFD;
+                pos = after_high;
+              }
+            } else if (code >= 0xDC00 && code < 0xE000) {
+              code = 0xFFFD; // a lone low surrogate
+            }
+            result += wxUniChar(code);
+            break;
+          }
+          default:
+            throw error(_("Invalid escape sequence"));
+        }
+      } else if (c < 0x20) {
+        throw error(_("Control character in string"));
+      } else {
+        result += c;
+      }
+    }
+  }
+
+  ScriptValueP parseNumber() {
+    size_t start = pos;
+    bool is_int = true;
+    if (input.GetChar(pos) == _('-')) ++pos;
+    while (pos < input.size()) {
+      Char c = input.GetChar(pos);
+      if (c >= _('0') && c <= _('9')) {
+        ++pos;
+      } else if (c == _('.') || c == _('e') || c == _('E') || c == _('+') || c == _('-')) {
+        is_int = false;
+        ++pos;
+      } else {
+        break;
+      }
+    }
+    String number = input.substr(start, pos - start);
+    long l;
+    double d;
+    if (is_int && number.ToLong(&l) && l >= INT_MIN && l <= INT_MAX) {
+      return to_script((int)l);
+    } else if (number.ToCDouble(&d)) {
+      return to_script(d);
+    } else {
+      pos = start;
+      throw error(_("Invalid number"));
+    }
+  }
+};
+
+ScriptValueP parse_json(const String& json) {
+  return JsonParser(json).parseDocument();
+}
+
+// ----------------------------------------------------------------------------- : Writing
+
+void write_json_string(std::string& out, const String& str) {
+  out += '"';
+  wxScopedCharBuffer utf8 = str.utf8_str();
+  for (const char* c = utf8.data() ; *c ; ++c) {
+    switch (*c) {
+      case '"':  out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n";  break;
+      case '\r': out += "\\r";  break;
+      case '\t': out += "\\t";  break;
+      default:
+        if ((unsigned char)*c < 0x20) {
+          char buf[8];
+          snprintf(buf, sizeof(buf), "\\u%04x", *c);
+          out += buf;
+        } else {
+          out += *c;
+        }
+    }
+  }
+  out += '"';
+}
+
+void write_json_number(std::string& out, double value) {
+  if (!isfinite(value)) {
+    out += "null";
+  } else {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.17g", value);
+    out += buf;
+  }
+}
+
+void write_json(std::string& out, const ScriptValueP& value) {
+  switch (value->type()) {
+    case SCRIPT_NIL:
+      out += "null";
+      break;
+    case SCRIPT_BOOL:
+      out += value->toBool() ? "true" : "false";
+      break;
+    case SCRIPT_INT:
+      out += std::to_string(value->toInt());
+      break;
+    case SCRIPT_DOUBLE:
+      write_json_number(out, value->toDouble());
+      break;
+    case SCRIPT_STRING:
+      write_json_string(out, value->toString());
+      break;
+    case SCRIPT_COLLECTION: {
+      // collect items, it is an array if the keys are just the positions
+      vector<pair<ScriptValueP,ScriptValueP>> items;
+      bool is_array = true;
+      ScriptValueP it = value->makeIterator();
+      ScriptValueP key;
+      while (ScriptValueP item = it->next(&key)) {
+        if (!key || key->type() != SCRIPT_INT || key->toInt() != (int)items.size()) is_array = false;
+        items.push_back(make_pair(key, item));
+      }
+      if (items.empty() && dynamic_cast<const JsonObject*>(value.get())) is_array = false;
+      out += is_array ? '[' : '{';
+      for (size_t i = 0 ; i < items.size() ; ++i) {
+        if (i > 0) out += ',';
+        if (!is_array) {
+          write_json_string(out, items[i].first ? items[i].first->toString() : String::Format(_("%d"), (int)i));
+          out += ':';
+        }
+        write_json(out, items[i].second);
+      }
+      out += is_array ? ']' : '}';
+      break;
+    }
+    default:
+      try {
+        write_json_string(out, value->toCode());
+      } catch (const ScriptError&) {
+        // no string representation
+        write_json_string(out, _("<") + value->typeName() + _(">"));
+      }
+  }
+}
@@ -0,0 +1,43 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+/** @file script/json.hpp
+ *
+ *  Reading and writing JSON.
+ *  JSON values are represented as ScriptValues: objects become collections with keys (JsonObjects),
+ *  arrays become collections without keys.
+ */
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <script/value.hpp>
+#include <script/to_value.hpp>
+
+// ----------------------------------------------------------------------------- : JSON
+
+/// A collection that is written as a JSON object, also when it is empty
+/** parse_json returns these for objects, so that {} is not written back as [] */
+class JsonObject : public ScriptCustomCollection {};
+
+/// Parse a JSON value
+/** Throws a ParseError if the input is not valid JSON */
+ScriptValueP parse_json(const String& json);
+
+/// Append a value as UTF-8 encoded JSON to out
+/** Collections with only integer keys 0,1,2,.. are written as arrays, other collections as objects.
+ *  Empty collections are written as [], unless they are a JsonObject.
+ *  Values that have no JSON equivalent (colors, images, ...) are written as a string with their script code.
+ */
+void write_json(std::string& out, const ScriptValueP& value);
+
+/// Append a string as an UTF-8 encoded JSON string literal to out
+void write_json_string(std::string& out, const String& str);
+
+/// Append a number to out, numbers that are not finite are written as null
+void write_json_number(std::string& out, double value);
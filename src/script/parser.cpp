@@ -416,6 +416,7 @@ ScriptP parse(const String& s, Packaged* package, bool string_mode, vector<Scrip
   if (type == EXPR_FAILED) {
     return ScriptP();
   } else {
+    script->optimize();
     return script;
   }
 }
@@ -813,7 +814,13 @@ ExprType parseOper(TokenIterator& input, Script& script, Precedence minPrec, Ins
         //   MEMBER
         // becomes
         //   MEMBER_CONST x
-        script.getInstructions().back().instr = I_MEMBER_C;
+        // the constant itself is no longer needed
+        Instruction& instr = script.getInstructions().back();
+        vector<ScriptValueP>& constants = script.getConstants();
+        bool last_constant = instr.data + 1 == constants.size();
+        instr.instr = I_MEMBER_C;
+        instr.data  = string_to_member_atom(constants[instr.data]->toString());
+        if (last_constant) constants.pop_back();
       } else {
         script.addInstruction(I_BINARY, I_MEMBER);
       }
@@ -8,6 +8,164 @@
 
 #include <util/prec.hpp>
 #include <script/profiler.hpp>
+#include <script/json.hpp>
+#include <wx/wfstream.h>
+
+// ----------------------------------------------------------------------------- : Tracing : buffers
+
+atomic<bool> tracing_enabled(false);
+atomic<UInt> trace_generation(1); ///< Incremented when a new trace is started
+
+/// Number of events kept for each thread
+const size_t TRACE_BUFFER_SIZE = 1 << 16;
+
+struct TraceEvent {
+  int64_t       start, duration;
+  const void*   name;
+  TraceNameType name_type;
+  UInt          thread;
+};
+
+/// Ring buffer of events, used by one thread at a time
+struct TraceBuffer {
+  vector<TraceEvent>   events;
+  size_t               next = 0;          ///< Position where the next event goes
+  UInt                 thread = 0;        ///< Thread using this buffer
+  UInt                 generation = 0;    ///< Trace that the events belong to
+  set<const void*>     known_objects;     ///< Objects for which this thread has given a name
+  
+  /// Remove events and names of a previous trace
+  inline void update() {
+    if (generation != trace_generation) {
+      events.clear();
+      next = 0;
+      known_objects.clear();
+      generation = trace_generation;
+    }
+  }
+};
+
+// All buffers, and the names of objects, are protected by this mutex
+wxMutex                       trace_mutex;
+vector<unique_ptr<TraceBuffer>> trace_buffers;
+vector<TraceBuffer*>          free_trace_buffers; ///< Buffers of threads that have ended
+map<const void*, String>      trace_object_names;
+int64_t                       trace_start_time = 0;
+atomic<UInt>                  trace_thread_count(0);
+
+/// The buffer of the current thread, returned to the free list when the thread ends
+struct ThreadTraceBuffer {
+  TraceBuffer* buffer = nullptr;
+  ~ThreadTraceBuffer() {
+    if (buffer) {
+      wxMutexLocker lock(trace_mutex);
+      free_trace_buffers.push_back(buffer);
+    }
+  }
+  inline TraceBuffer& get() {
+    if (!buffer) {
+      wxMutexLocker lock(trace_mutex);
+      if (!free_trace_buffers.empty()) {
+        buffer = free_trace_buffers.back();
+        free_trace_buffers.pop_back();
+      } else {
+        trace_buffers.push_back(make_unique<TraceBuffer>());
+        buffer = trace_buffers.back().get();
+        buffer->events.reserve(TRACE_BUFFER_SIZE);
+      }
+      buffer->thread = ++trace_thread_count;
+    }
+    buffer->update();
+    return *buffer;
+  }
+};
+thread_local ThreadTraceBuffer thread_trace_buffer;
+
+void start_tracing() {
+  wxMutexLocker lock(trace_mutex);
+  // note: the buffers are cleared by their own threads, see TraceBuffer::update
+  trace_object_names.clear();
+  ++trace_generation;
+  trace_start_time = trace_clock();
+  tracing_enabled = true;
+}
+
+void stop_tracing() {
+  tracing_enabled = false;
+}
+
+bool trace_object_known(const void* object) {
+  const TraceBuffer& buffer = thread_trace_buffer.get();
+  return buffer.known_objects.find(object) != buffer.known_objects.end();
+}
+
+void trace_object_name(const void* object, const String& name) {
+  thread_trace_buffer.get().known_objects.insert(object);
+  wxMutexLocker lock(trace_mutex);
+  trace_object_names[object] = name;
+}
+
+void TraceScope::end() {
+  int64_t now = trace_clock();
+  TraceBuffer& buffer = thread_trace_buffer.get();
+  TraceEvent event = {start, now - start, name, name_type, buffer.thread};
+  if (buffer.events.size() < TRACE_BUFFER_SIZE) {
+    buffer.events.push_back(event);
+  } else {
+    // overwrite the oldest event
+    buffer.events[buffer.next] = event;
+    buffer.next = (buffer.next + 1) % TRACE_BUFFER_SIZE;
+  }
+}
+
+// ----------------------------------------------------------------------------- : Tracing : output
+
+String trace_event_name(const TraceEvent& e) {
+  switch (e.name_type) {
+    case TRACE_NAME_CONSTANT: return String((const Char*)e.name);
+    case TRACE_NAME_VARIABLE: return variable_to_string((Variable)(size_t)e.name);
+    default: {
+      auto it = trace_object_names.find(e.name);
+      return it != trace_object_names.end() ? it->second : String(_("?"));
+    }
+  }
+}
+
+size_t write_trace(const String& filename) {
+  // collect events
+  vector<TraceEvent> events;
+  std::string out;
+  {
+    wxMutexLocker lock(trace_mutex);
+    FOR_EACH_CONST(b, trace_buffers) {
+      if (b->generation != trace_generation) continue; // events of an older trace
+      events.insert(events.end(), b->events.begin(), b->events.end());
+    }
+    sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) { return a.start < b.start; });
+    // Complete events ("ph":"X") with times in microseconds
+    out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    char buf[128];
+    for (size_t i = 0 ; i < events.size() ; ++i) {
+      const TraceEvent& e = events[i];
+      out += "{\"name\":";
+      write_json_string(out, trace_event_name(e));
+      snprintf(buf, sizeof(buf), ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+               e.name_type == TRACE_NAME_VARIABLE ? "script" : "mse",
+               (e.start - trace_start_time) / 1000.0, e.duration / 1000.0, e.thread);
+      out += buf;
+      out += i + 1 < events.size() ? ",\n" : "\n";
+    }
+    out += "]}\n";
+  }
+  // write
+  wxFileOutputStream file(filename);
+  if (!file.IsOk() || !file.WriteAll(out.data(), out.size())) {
+    throw Error(_("Unable to write trace to '") + filename + _("'"));
+  }
+  return events.size();
+}
+
+// ----------------------------------------------------------------------------- : Profiling (debug builds)
 
 #if USE_SCRIPT_PROFILING
 
@@ -138,5 +296,23 @@ Profiler::~Profiler() {
   function = parent; // pop
 }
 
+// ----------------------------------------------------------------------------- : ProfileCounter
+
+vector<ProfileCounter*>& profile_counters_mutable() {
+  // function local static, because counters are registered during static initialization
+  static vector<ProfileCounter*> counters;
+  return counters;
+}
+
+const vector<ProfileCounter*>& profile_counters() {
+  return profile_counters_mutable();
+}
+
+ProfileCounter::ProfileCounter(const Char* name)
+  : name(name)
+{
+  profile_counters_mutable().push_back(this);
+}
+
 // ----------------------------------------------------------------------------- : EOF
 #endif
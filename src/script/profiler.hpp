@@ -11,11 +11,93 @@
 #include <util/prec.hpp>
 #include <script/script.hpp>
 #include <script/context.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 
 #if !defined(USE_SCRIPT_PROFILING) && defined(_DEBUG)
 #define USE_SCRIPT_PROFILING 1
 #endif
 
+// ----------------------------------------------------------------------------- : Tracing
+
+// Tracing is available in all builds, it is enabled at runtime.
+// When enabled, each thread records the scopes it executes (script functions, field updates, etc.)
+// in its own ring buffer, so only the most recent events are kept.
+// The events can be written as a Chrome trace, to be viewed in chrome://tracing or Perfetto.
+
+extern atomic<bool> tracing_enabled;
+
+/// Is tracing enabled?
+inline bool trace_enabled() {
+  return tracing_enabled.load(memory_order_relaxed);
+}
+
+/// Time in nanoseconds, from a monotonic clock
+inline int64_t trace_clock() {
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Start recording trace events, events recorded before are removed
+void start_tracing();
+/// Stop recording trace events, the events recorded so far are kept
+void stop_tracing();
+/// Write the recorded events to a file in the Chrome trace event format
+/** Should be called when no traced code is running in other threads.
+ *  Throws an Error if the file can't be written.
+ *  Returns the number of events written.
+ */
+size_t write_trace(const String& filename);
+
+/// What the name of a TraceScope refers to
+enum TraceNameType
+{  TRACE_NAME_CONSTANT  ///< a const Char*
+,  TRACE_NAME_VARIABLE  ///< a Variable, the name of a script function
+,  TRACE_NAME_OBJECT    ///< an object, with a name given by trace_object_name
+};
+
+/// Has the name of an object been given in the current trace (by this thread)?
+bool trace_object_known(const void* object);
+/// Give the name of an object, to be used in the trace
+void trace_object_name(const void* object, const String& name);
+
+/// Records the time spent in a scope, if tracing is enabled
+class TraceScope {
+public:
+  /// Trace a scope with a constant name
+  inline TraceScope(const Char* name) : start(-1) {
+    if (trace_enabled()) begin(TRACE_NAME_CONSTANT, name);
+  }
+  /// Trace a call to a script function, nothing is recorded for functions without a name (function < 0)
+  inline TraceScope(Variable function) : start(-1) {
+    if (trace_enabled() && (int)function >= 0) begin(TRACE_NAME_VARIABLE, (const void*)(size_t)function);
+  }
+  /// Trace a scope that belongs to an object
+  /** get_name() gives the name of the object, it is only called if the name is not known yet */
+  template <typename GetName>
+  inline TraceScope(const void* object, const GetName& get_name) : start(-1) {
+    if (trace_enabled()) {
+      if (!trace_object_known(object)) trace_object_name(object, get_name());
+      begin(TRACE_NAME_OBJECT, object);
+    }
+  }
+  inline ~TraceScope() {
+    if (start >= 0) end();
+  }
+  
+private:
+  int64_t       start;
+  const void*   name;
+  TraceNameType name_type;
+  
+  inline void begin(TraceNameType type, const void* name) {
+    this->name_type = type;
+    this->name      = name;
+    this->start     = trace_clock();
+  }
+  void end();
+};
+
 #if USE_SCRIPT_PROFILING
 
 DECLARE_POINTER_TYPE(FunctionProfile);
@@ -126,16 +208,54 @@ private:
 
 // Profile the current function (all following code in the current block) under the given name
 #define PROFILER(name) \
+  TraceScope trace_scope(name); \
   Timer profile_timer; \
   Profiler profiler(profile_timer, name)
 #define PROFILER2(name1,name2) \
+  TraceScope trace_scope(name1, [&]() -> String { return name2; }); \
   Timer profile_timer; \
   Profiler profiler(profile_timer, name1,name2)
 
+// ----------------------------------------------------------------------------- : Counters
+
+/// Counts how often something happens, for example cache hits
+/** Counters are global objects, they are shown together with the profiling results.
+ *  Counting is thread safe.
+ */
+class ProfileCounter {
+public:
+  /// Create and register a counter, should only be used for globals
+  ProfileCounter(const Char* name);
+  
+  const Char* const name;
+  
+  inline void add(size_t n = 1) { count.fetch_add(n, memory_order_relaxed); }
+  inline size_t get() const     { return count.load(memory_order_relaxed); }
+private:
+  atomic<size_t> count;
+};
+
+/// All counters, in order of registration
+const vector<ProfileCounter*>& profile_counters();
+
+/// Declare a global ProfileCounter
+#define DECLARE_PROFILE_COUNTER(var, name) \
+  ProfileCounter var(name)
+/// Increment a ProfileCounter
+#define COUNT_PROFILE(var) \
+  var.add()
+
 #else // USE_SCRIPT_PROFILING
 
-#define PROFILER(a)
-#define PROFILER2(a,b)
+// Without profiling the current function is only traced
+#define PROFILER(name) \
+  TraceScope trace_scope(name)
+#define PROFILER2(name1,name2) \
+  TraceScope trace_scope(name1, [&]() -> String { return name2; })
+// the static_assert uses up the semicolon after DECLARE_PROFILE_COUNTER(...) at namespace scope
+#define DECLARE_PROFILE_COUNTER(var, name) \
+  static_assert(true, "")
+#define COUNT_PROFILE(var)
 
 #endif // USE_SCRIPT_PROFILING
 
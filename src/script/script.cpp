@@ -11,38 +11,42 @@
 #include <script/context.hpp>
 #include <script/to_value.hpp>
 #include <util/error.hpp>
+#include <shared_mutex>
 
 // ----------------------------------------------------------------------------- : Variables
 
 typedef map<String, Variable> Variables;
 Variables variables;
-#ifdef _DEBUG
-  vector<String> variable_names;
-#endif
+vector<String> variable_names; // indexed by Variable
+// Scripts can be evaluated in multiple threads.
+// Script functions look up the names of their parameters on every call, while new variables are rare,
+// so lookups only take a shared lock.
+std::shared_mutex variables_mutex;
 
 /// Return a unique name for a variable to allow for faster loopups
 Variable string_to_variable(const String& s) {
-  Variables::iterator it = variables.find(s);
-  if (it == variables.end()) {
-    #ifdef _DEBUG
-      variable_names.push_back(s);
-      assert(s == canonical_name_form(s)); // only use canonical names
-    #endif
-    Variable v = (Variable)variables.size();
-    variables.insert(make_pair(s,v));
-    return v;
-  } else {
-    return it->second;
+  {
+    std::shared_lock<std::shared_mutex> lock(variables_mutex);
+    Variables::const_iterator it = variables.find(s);
+    if (it != variables.end()) return it->second;
   }
+  // a new variable
+  std::unique_lock<std::shared_mutex> lock(variables_mutex);
+  Variables::const_iterator it = variables.find(s); // another thread could have added it in the meantime
+  if (it != variables.end()) return it->second;
+  #ifdef _DEBUG
+    assert(s == canonical_name_form(s)); // only use canonical names
+  #endif
+  Variable v = (Variable)variables.size();
+  variables.insert(make_pair(s,v));
+  variable_names.push_back(s);
+  return v;
 }
 
 /// Get the name of a vaiable
-/** Warning: this function is slow, it should only be used for error messages and such.
- */
 String variable_to_string(Variable v) {
-  FOR_EACH(vi, variables) {
-    if (vi.second == v) return replace_all(vi.first, _(" "), _("_"));
-  }
+  std::shared_lock<std::shared_mutex> lock(variables_mutex);
+  if ((size_t)v < variable_names.size()) return replace_all(variable_names[v], _(" "), _("_"));
   throw InternalError(String(_("Variable not found: ")) << v);
 }
 
@@ -130,6 +134,10 @@ void Script::addInstruction(InstructionType t, const ScriptValueP& c) {
   instructions.push_back(i);
 }
 void Script::addInstruction(InstructionType t, const String& s) {
+  if (t == I_MEMBER_C) {
+    addInstruction(t, (unsigned int)string_to_member_atom(s));
+    return;
+  }
   constants.push_back(to_script(s));
   Instruction i = {t, {(unsigned int)constants.size() - 1}};
   instructions.push_back(i);
@@ -150,6 +158,65 @@ Addr Script::getLabel() const {
   return Addr{ (unsigned int)instructions.size() };
 }
 
+// ----------------------------------------------------------------------------- : Optimization
+
+void Script::optimize() {
+  // nested functions
+  FOR_EACH(c, constants) {
+    if (Script* sub = dynamic_cast<Script*>(c.get())) {
+      sub->optimize();
+    }
+  }
+  // Find jump targets, we can't combine an instruction with the one before it if it is a jump target.
+  // Jumping to the first instruction of a combined sequence is fine.
+  vector<bool> is_target(instructions.size() + 1, false);
+  FOR_EACH_CONST(i, instructions) {
+    if (i.instr == I_JUMP || i.instr == I_JUMP_IF_NOT || i.instr == I_JUMP_SC_AND || i.instr == I_JUMP_SC_OR ||
+        i.instr == I_LOOP || i.instr == I_LOOP_WITH_KEY) {
+      if (i.data < is_target.size()) is_target[i.data] = true;
+    }
+  }
+  // Replace instruction sequences
+  for (size_t pos = 0 ; pos < instructions.size() ; ++pos) {
+    Instruction& i = instructions[pos];
+    if (i.instr == I_CALL || i.instr == I_CLOSURE) {
+      // skip argument names
+      pos += i.data;
+    } else if (pos + 1 < instructions.size() && !is_target[pos + 1]) {
+      Instruction& next = instructions[pos + 1];
+      if (i.instr == I_GET_VAR && next.instr == I_MEMBER_C) {
+        // GET_VAR var; MEMBER_C name  -->  GET_VAR_MEMBER_C var; NOP name
+        i.instr    = I_GET_VAR_MEMBER_C;
+        next.instr = I_NOP;
+        ++pos;
+      } else if (i.instr == I_PUSH_CONST && next.instr == I_BINARY) {
+        // PUSH_CONST val; BINARY op  -->  PUSH_CONST_BINARY val; NOP op
+        i.instr    = I_PUSH_CONST_BINARY;
+        next.instr = I_NOP;
+        ++pos;
+      } else if (next.instr == I_CALL && next.data > 0 && next.data <= pos + 1) {
+        // PUSH_CONST a1; ...; PUSH_CONST an; CALL n; NOP v1; ...; NOP vn
+        // -->
+        // CALL_C n; NOP a1; ...; NOP an; NOP v1; ...; NOP vn
+        size_t n = next.data, first = pos + 1 - n;
+        bool all_const = true;
+        for (size_t j = first ; j <= pos ; ++j) {
+          all_const &= instructions[j].instr == I_PUSH_CONST && (j == first || !is_target[j]);
+        }
+        if (all_const) {
+          for (size_t j = pos + 1 ; j > first ; --j) {
+            instructions[j].instr = I_NOP;
+            instructions[j].data  = instructions[j - 1].data;
+          }
+          instructions[first].instr = I_CALL_C;
+          instructions[first].data  = (unsigned int)n;
+          pos += 1 + n; // skip argument names
+        }
+      }
+    }
+  }
+}
+
 #ifdef _DEBUG // debugging
 
 String Script::dumpScript() const {
@@ -221,20 +288,26 @@ String Script::dumpInstr(unsigned int pos, Instruction i) const {
     case I_DUP:      ret += _("dup");        break;
     case I_POP:      ret += _("pop");        break;
     case I_TAILCALL:  ret += _("tailcall");      break;
+    case I_GET_VAR_MEMBER_C:  ret += _("get member_c");  break;
+    case I_PUSH_CONST_BINARY: ret += _("push binary");   break;
+    case I_CALL_C:    ret += _("call_c");      break;
   }
   // arg
   switch (i.instr) {
-    case I_PUSH_CONST: case I_MEMBER_C:              // const
+    case I_PUSH_CONST: case I_PUSH_CONST_BINARY: // const
       ret += _("\t") + constants[i.data]->typeName();
       ret += _("\t") + constants[i.data]->toCode();
       break;
+    case I_MEMBER_C:                  // member
+      ret += _("\t") + member_atom_to_string((MemberAtom)i.data);
+      break;
     case I_JUMP: case I_JUMP_IF_NOT: case I_JUMP_SC_AND: case I_JUMP_SC_OR:
     case I_LOOP: case I_LOOP_WITH_KEY:
     case I_MAKE_OBJECT:
-    case I_CALL: case I_CLOSURE: case I_DUP:  // int
+    case I_CALL: case I_CLOSURE: case I_DUP: case I_CALL_C:  // int
       ret += String::Format(_("\t%d"), i.data);
       break;
-    case I_GET_VAR: case I_SET_VAR: case I_NOP:          // variable
+    case I_GET_VAR: case I_SET_VAR: case I_NOP: case I_GET_VAR_MEMBER_C:  // variable
       ret += _("\t") + variable_to_string((Variable)i.data);
       break;
   }
@@ -248,18 +321,17 @@ String Script::dumpInstr(unsigned int pos, Instruction i) const {
 
 const Instruction* Script::backtraceSkip(const Instruction* instr, int to_skip) const {
   unsigned int initial = instr - &instructions[0];
-  for (;instr >= &instructions[0] && 
-         (to_skip   || (// we have something to skip
-          instr >= &instructions[1] && (
-                (instr-1)->instr == I_JUMP // always look inside a jump
-             || (instr-1)->instr == I_NOP  // and skip nops
-             )
-           )
-         ) ; --instr) {
+  for (; instr >= &instructions[0] ; --instr) {
+    // nops hold the data of the instruction before them (argument names, operands of superinstructions),
+    // they are part of that instruction
+    while (instr > &instructions[0] && instr->instr == I_NOP) --instr;
+    if (!to_skip && !(instr > &instructions[0] && (instr-1)->instr == I_JUMP)) {
+      break; // nothing left to skip, but always look inside a jump
+    }
     // skip an instruction
     switch (instr->instr) {
       case I_PUSH_CONST:
-      case I_GET_VAR: case I_DUP:
+      case I_GET_VAR: case I_DUP: case I_GET_VAR_MEMBER_C:
         to_skip -= 1; break; // nett stack effect +1
       case I_BINARY:
         to_skip += 1; break; // nett stack effect 1-2 == -1
@@ -267,9 +339,10 @@ const Instruction* Script::backtraceSkip(const Instruction* instr, int to_skip)
         to_skip += 2; break; // nett stack effect 1-3 == -2
       case I_QUATERNARY:
         to_skip += 3; break; // nett stack effect 1-4 == -3
-      case I_CALL: case I_CLOSURE:
+      case I_CALL: case I_CLOSURE: case I_TAILCALL:
         to_skip += instr->data; // arguments of call
         break;
+      // I_PUSH_CONST_BINARY replaces the top of the stack, I_CALL_C replaces the function by its result
       case I_MAKE_OBJECT:
         to_skip += 2 * instr->data - 1;
         break;
@@ -332,12 +405,17 @@ const Instruction* Script::backtraceSkip(const Instruction* instr, int to_skip)
 
 String Script::instructionName(const Instruction* instr) const {
   if (instr < &instructions[0] || instr >= &instructions[0] + instructions.size()) return _("??\?");
-  if (instr->instr == I_GET_VAR) {
+  if (instr->instr == I_GET_VAR_MEMBER_C) {
+    // the member name is stored in the nop after the superinstruction
+    return variable_to_string((Variable)instr->data)
+         + _(".")
+         + member_atom_to_string((MemberAtom)(instr+1)->data);
+  } else if (instr->instr == I_GET_VAR) {
     return variable_to_string((Variable)instr->data);
   } else if (instr->instr == I_MEMBER_C) {
     return instructionName(backtraceSkip(instr - 1, 0))
          + _(".")
-         + constants[instr->data]->toString();
+         + member_atom_to_string((MemberAtom)instr->data);
   } else if (instr->instr == I_BINARY && instr->instr2 == I_MEMBER) {
     return _("??\?[...]");
   } else if (instr->instr == I_BINARY && instr->instr2 == I_ADD) {
@@ -346,6 +424,8 @@ String Script::instructionName(const Instruction* instr) const {
     return _("??\?(...)");
   } else if (instr->instr == I_CALL) {
     return instructionName(backtraceSkip(instr - 1, instr->data)) + _("(...)");
+  } else if (instr->instr == I_CALL_C) {
+    return instructionName(backtraceSkip(instr - 1, 0)) + _("(...)");
   } else if (instr->instr == I_CLOSURE) {
     return instructionName(backtraceSkip(instr - 1, instr->data)) + _("@(...)");
   } else {
@@ -31,7 +31,7 @@ enum InstructionType
 ,  I_GET_VAR       = 4  ///< arg = var        : find a variable, push its value onto the stack, it is an error if the variable is not found
 ,  I_SET_VAR       = 5  ///< arg = var        : assign the top value from the stack to a variable (doesn't pop)
   // Objects
-,  I_MEMBER_C      = 6  ///< arg = const name : finds a member of the top of the stack replaces the top of the stack with the member
+,  I_MEMBER_C      = 6  ///< arg = member     : finds a member of the top of the stack replaces the top of the stack with the member
 ,  I_LOOP          = 7  ///< arg = address    : loop over the elements of an iterator, which is the *second* element of the stack (this allows for combing the results of multiple iterations)
                         ///<                    at the end performs a jump and pops the iterator. note: The second element of the stack must be an iterator!
 ,  I_LOOP_WITH_KEY = 8  ///< arg = address    : loop, but also pushing the key
@@ -47,6 +47,11 @@ enum InstructionType
 ,  I_QUATERNARY    = 16 ///< arg = 4ary instr : pop 4 values, apply a function, push the result
 ,  I_DUP           = 17 ///< arg = int        : duplicate the k-from-top element of the stack
 ,  I_POP           = 18 ///< arg = *          : pop the top value off the stack.
+  // Superinstructions, introduced by Script::optimize
+  // the extra data is stored in I_NOP instructions that follow, so the size of the code doesn't change
+,  I_GET_VAR_MEMBER_C  = 21 ///< arg = var, member       : I_GET_VAR followed by I_MEMBER_C
+,  I_PUSH_CONST_BINARY = 22 ///< arg = const val, 2ary   : I_PUSH_CONST followed by I_BINARY
+,  I_CALL_C            = 23 ///< arg = int, n*const, n*var : I_CALL where all arguments are constants, they are not put on the stack
 };
 
 /// Types of unary instructions (taking one argument from the stack)
@@ -183,6 +188,7 @@ public:
   /// Add an instruction with constant data
   void addInstruction(InstructionType t, const ScriptValueP& c);
   /// Add an instruction with string data
+  /** For I_MEMBER_C the string is interned with string_to_member_atom, otherwise it becomes a constant */
   void addInstruction(InstructionType t, const String& s);
   
   /// Update an instruction to point to the current position
@@ -193,6 +199,12 @@ public:
   /// Get the current instruction position
   Addr getLabel() const;
   
+  /// Replace common sequences of instructions by superinstructions
+  /** Also optimizes nested functions. Should be called once, when the script is complete.
+   *  Jump targets are not changed.
+   */
+  void optimize();
+  
   /// Get access to the vector of instructions
   inline vector<Instruction>& getInstructions() { return instructions; }
   /// Get access to the vector of constants
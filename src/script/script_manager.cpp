@@ -16,10 +16,12 @@
 #include <data/game.hpp>
 #include <data/card.hpp>
 #include <data/field.hpp>
+#include <data/statistics.hpp>
 #include <data/action/set.hpp>
 #include <data/action/value.hpp>
 #include <data/action/keyword.hpp>
 #include <util/error.hpp>
+#include <wx/thread.h>
 
 // ----------------------------------------------------------------------------- : SetScriptContext : initialization
 
@@ -111,6 +113,10 @@ void SetScriptManager::initDependencies(Context& ctx, Game& game) {
   FOR_EACH(f, game.set_fields) {
     f->initDependencies(ctx, Dependency(DEP_SET_FIELD, f->index));
   }
+  // find dependencies of statistics, these are used by StatsValueCache
+  FOR_EACH(dim, game.statistics_dimensions) {
+    dim->script.initDependencies(ctx, Dependency(DEP_CARD_STATISTIC, dim->index));
+  }
 }
 
 
@@ -137,6 +143,117 @@ void SetScriptManager::initDependencies(Context& ctx, StyleSheet& stylesheet) {
   }
 }
 
+// ----------------------------------------------------------------------------- : SetScriptManager : parallel updating
+
+/// How many threads should be used to update all cards?
+int card_update_threads(size_t card_count) {
+  #if USE_SCRIPT_PROFILING
+    return 1; // the profiler is not thread safe
+  #else
+    // threads are not worth it for small sets
+    const size_t MIN_CARDS_PER_THREAD = 16;
+    size_t cpus = (size_t)max(1, wxThread::GetCPUCount());
+    return (int)min(cpus, card_count / MIN_CARDS_PER_THREAD);
+  #endif
+}
+
+/// Mark the card fields that are (indirectly) in a list of dependencies
+void mark_card_fields(vector<bool>& marked, const Game& game, const vector<Dependency>& deps) {
+  FOR_EACH_CONST(d, deps) {
+    if (d.type == DEP_CARD_FIELD || d.type == DEP_CARDS_FIELD) {
+      if (d.index < marked.size()) marked[d.index] = true;
+    } else if (d.type == DEP_CARD_COPY_DEP) {
+      mark_card_fields(marked, game, game.card_fields.at(d.index)->dependent_scripts);
+    } else if (d.type == DEP_SET_COPY_DEP) {
+      mark_card_fields(marked, game, game.set_fields.at(d.index)->dependent_scripts);
+    }
+  }
+}
+
+/// The work of SetScriptManager::updateAllCardsParallel, shared by all threads
+class CardUpdater {
+public:
+  struct Job {
+    CardP                    card;
+    Context*                 ctx;     ///< context for the card's stylesheet, each thread uses a copy
+    IndexMap<FieldP,ValueP>* styling; ///< styling data for the card
+  };
+  vector<Job>  jobs;
+  vector<bool> skip_fields; ///< card fields (by index) that should not be updated
+  
+  /// Do jobs until there are none left, called from each thread
+  void run();
+  
+private:
+  atomic<size_t> next_job{0};
+};
+
+void CardUpdater::run() {
+  map<const Context*, Context> contexts; // our own copies
+  while (true) {
+    size_t i = next_job.fetch_add(1);
+    if (i >= jobs.size()) break;
+    const Job& job = jobs[i];
+    auto it = contexts.find(job.ctx);
+    if (it == contexts.end()) {
+      it = contexts.emplace(job.ctx, *job.ctx).first;
+    }
+    Context& ctx = it->second;
+    ctx.setVariable(SCRIPT_VAR_card,    to_script(job.card));
+    ctx.setVariable(SCRIPT_VAR_styling, to_script(job.styling));
+    FOR_EACH(v, job.card->data) {
+      if (skip_fields[v->fieldP->index]) continue;
+      try {
+        PROFILER2(v->fieldP.get(), _("update card.") + v->fieldP->name);
+        v->update(ctx);
+      } catch (const ScriptError& e) {
+        handle_error(ScriptError(e.what() + _("\n  while updating card value '") + v->fieldP->name + _("'")));
+      } catch (const Error& e) {
+        handle_error(e); // don't let exceptions escape from a worker thread
+      }
+    }
+  }
+}
+
+class CardUpdateThread : public wxThread {
+public:
+  CardUpdateThread(CardUpdater& updater)
+    : wxThread(wxTHREAD_JOINABLE), updater(updater)
+  {}
+  ExitCode Entry() override {
+    updater.run();
+    return 0;
+  }
+private:
+  CardUpdater& updater;
+};
+
+void SetScriptManager::updateAllCardsParallel(int threads) {
+  CardUpdater updater;
+  // Fields that depend on other cards would see half updated cards.
+  // They will be updated later by updateAllDependend.
+  updater.skip_fields.resize(set.game->card_fields.size(), false);
+  mark_card_fields(updater.skip_fields, *set.game, set.game->dependent_scripts_cards);
+  // Find the contexts and styling data for all cards.
+  // This is done here, because it can initialize contexts and read delayed styling data
+  updater.jobs.reserve(set.cards.size());
+  FOR_EACH(card, set.cards) {
+    Context& ctx = getContext(set.stylesheetForP(card));
+    updater.jobs.push_back(CardUpdater::Job{card, &ctx, &set.stylingDataFor(card)});
+  }
+  // start the worker threads, this thread does its share of the work as well
+  vector<unique_ptr<CardUpdateThread>> workers;
+  for (int i = 1 ; i < threads ; ++i) {
+    auto worker = make_unique<CardUpdateThread>(updater);
+    if (worker->Create() != wxTHREAD_NO_ERROR || worker->Run() != wxTHREAD_NO_ERROR) break;
+    workers.push_back(move(worker));
+  }
+  updater.run();
+  FOR_EACH(worker, workers) {
+    worker->Wait();
+  }
+}
+
 // ----------------------------------------------------------------------------- : ScriptManager : updating
 
 void SetScriptManager::onAction(const Action& action, bool undone) {
@@ -278,17 +395,19 @@ void SetScriptManager::updateAll() {
     }
   }
   // update card data of all cards
-  FOR_EACH(card, set.cards) {
-    Context& ctx = getContext(card);
-    FOR_EACH(v, card->data) {
-      try {
-        #if USE_SCRIPT_PROFILING
-          Timer t;
-          Profiler prof(t, v->fieldP.get(), _("update card.") + v->fieldP->name);
-        #endif
-        v->update(ctx);
-      } catch (const ScriptError& e) {
-        handle_error(ScriptError(e.what() + _("\n  while updating card value '") + v->fieldP->name + _("'")));
+  int threads = card_update_threads(set.cards.size());
+  if (threads > 1) {
+    updateAllCardsParallel(threads);
+  } else {
+    FOR_EACH(card, set.cards) {
+      Context& ctx = getContext(card);
+      FOR_EACH(v, card->data) {
+        try {
+          PROFILER2(v->fieldP.get(), _("update card.") + v->fieldP->name);
+          v->update(ctx);
+        } catch (const ScriptError& e) {
+          handle_error(ScriptError(e.what() + _("\n  while updating card value '") + v->fieldP->name + _("'")));
+        }
       }
     }
   }
@@ -394,6 +513,9 @@ void SetScriptManager::alsoUpdate(deque<ToUpdate>& to_update, const vector<Depen
         FieldP f = set.game->set_fields[d.index];
         alsoUpdate(to_update, f->dependent_scripts, card);
         break;
+      } case DEP_CARD_STATISTIC: case DEP_CARDS_STATISTIC: {
+        // statistics are not kept up to date here, StatsValueCache listens for the ScriptValueEvents instead
+        break;
       } default:
         assert(false);
     }
@@ -67,6 +67,7 @@ public:
   /// Update all fields of all cards
   /** Update all set info fields
    *  Doesn't update styles
+   *  For large sets the cards are updated by multiple threads.
    */
   void updateAll();
   
@@ -78,6 +79,9 @@ private:
   
   /// Update a map of styles
   void updateStyles(Context& ctx, const IndexMap<FieldP,StyleP>& styles, bool only_content_dependent);
+  /// Update the fields of all cards that don't depend on other cards, using multiple threads
+  /** The other card fields are not updated, use updateAllDependend(dependent_scripts_cards) for them */
+  void updateAllCardsParallel(int threads);
   /// Updates scripts, starting at some value
   /** if the value changes any dependend values are updated as well */
   void updateValue(Value& value, const CardP& card);
@@ -267,23 +267,12 @@ public:
     ScriptValueP d = getDefault(); return d ? d->toImage() : ScriptValue::toImage();
   }
   ScriptValueP getMember(const String& name) const override {
-    #if USE_SCRIPT_PROFILING
-      Timer t;
-      Profiler prof(t, (void*)mangled_name(typeid(T)), _("get member of ") + type_name(*value));
-    #endif
-    // Use reflection to find the member of the object
     GetMember gm(name);
-    gm.handle(*value);
-    if (gm.result()) return gm.result();
-    else {
-      // try nameless member
-      ScriptValueP d = getDefault();
-      if (d) {
-        return d->getMember(name);
-      } else {
-        return ScriptValue::getMember(name);
-      }
-    }
+    return getMember(gm, name);
+  }
+  ScriptValueP getMember(MemberAtom name) const override {
+    GetMember gm(name);
+    return getMember(gm, name);
   }
   ScriptValueP getIndex(int index) const override {
     ScriptValueP d = getDefault(); return d ? d->getIndex(index) : ScriptValue::getIndex(index);
@@ -323,6 +312,25 @@ public:
   inline T getValue() const { return value; }
 private:
   T value; ///< The object
+  template <typename Name>
+  ScriptValueP getMember(GetMember& gm, const Name& name) const {
+    #if USE_SCRIPT_PROFILING
+      Timer t;
+      Profiler prof(t, (void*)mangled_name(typeid(T)), _("get member of ") + type_name(*value));
+    #endif
+    // Use reflection to find the member of the object
+    gm.handle(*value);
+    if (gm.result()) return gm.result();
+    else {
+      // try nameless member
+      ScriptValueP d = getDefault();
+      if (d) {
+        return d->getMember(name);
+      } else {
+        return ScriptValue::getMember(gm.targetName());
+      }
+    }
+  }
   ScriptValueP getDefault() const {
     GetDefaultMember gdm;
     gdm.handle(*value);
@@ -14,6 +14,87 @@
 #include <gfx/generated_image.hpp>
 #include <util/error.hpp>
 #include <boost/pool/singleton_pool.hpp>
+#include <atomic>
+#include <wx/thread.h>
+
+// ----------------------------------------------------------------------------- : Member names
+
+/// Number of different IndexMaps (card fields, set fields, styling, ...) an atom remembers a position for
+const size_t MEMBER_ATOM_HINTS = 4;
+
+struct MemberAtomInfo {
+  String name;
+  /// Where the name was last found, for each kind of IndexMap
+  /** The high 32 bits are a tag for the keys of the map, the low 32 bits are the index, 0 is an unused slot */
+  atomic<unsigned long long> index_hints[MEMBER_ATOM_HINTS] = {};
+};
+
+// The atoms are stored in blocks that never move, so they can be read without locking,
+// even while another thread adds new atoms (scripts can be evaluated in multiple threads).
+const size_t MEMBER_ATOM_BLOCK_SIZE = 4096;
+const size_t MEMBER_ATOM_BLOCKS     = (MEMBER_ATOM_NONE + MEMBER_ATOM_BLOCK_SIZE - 1) / MEMBER_ATOM_BLOCK_SIZE;
+atomic<MemberAtomInfo*> member_atom_blocks[MEMBER_ATOM_BLOCKS];
+
+// only used with the mutex locked
+wxMutex                              member_atom_mutex;
+vector<unique_ptr<MemberAtomInfo[]>> member_atom_storage;
+map<String, MemberAtom>              member_atom_lookup;
+
+inline MemberAtomInfo& member_atom_info(MemberAtom atom) {
+  assert(atom < MEMBER_ATOM_NONE);
+  return member_atom_blocks[atom / MEMBER_ATOM_BLOCK_SIZE].load(memory_order_acquire)[atom % MEMBER_ATOM_BLOCK_SIZE];
+}
+
+MemberAtom string_to_member_atom(const String& name) {
+  wxMutexLocker lock(member_atom_mutex);
+  auto it = member_atom_lookup.find(name);
+  if (it != member_atom_lookup.end()) {
+    return it->second;
+  }
+  MemberAtom atom = (MemberAtom)member_atom_lookup.size();
+  assert(atom < MEMBER_ATOM_NONE);
+  if (atom % MEMBER_ATOM_BLOCK_SIZE == 0) {
+    member_atom_storage.push_back(make_unique<MemberAtomInfo[]>(MEMBER_ATOM_BLOCK_SIZE));
+    member_atom_blocks[atom / MEMBER_ATOM_BLOCK_SIZE].store(member_atom_storage.back().get(), memory_order_release);
+  }
+  member_atom_info(atom).name = name;
+  member_atom_lookup.insert(make_pair(name, atom));
+  return atom;
+}
+
+const String& member_atom_to_string(MemberAtom atom) {
+  return member_atom_info(atom).name;
+}
+
+/// Tag for the keys of an IndexMap, never 0
+inline UInt member_atom_hint_tag(const void* keys) {
+  size_t k = (size_t)keys;
+  return ((UInt)(k >> 4) ^ (UInt)((unsigned long long)k >> 36)) | 1;
+}
+
+size_t member_atom_index_hint(MemberAtom atom, const void* keys) {
+  UInt tag = member_atom_hint_tag(keys);
+  FOR_EACH_CONST(h, member_atom_info(atom).index_hints) {
+    unsigned long long hint = h.load(memory_order_relaxed);
+    if ((UInt)(hint >> 32) == tag) return (UInt)hint;
+  }
+  return 0;
+}
+void set_member_atom_index_hint(MemberAtom atom, const void* keys, size_t index) {
+  UInt tag = member_atom_hint_tag(keys);
+  unsigned long long hint = ((unsigned long long)tag << 32) | (UInt)index;
+  auto& hints = member_atom_info(atom).index_hints;
+  // use the slot for the same keys, or an unused one
+  FOR_EACH(h, hints) {
+    UInt old_tag = (UInt)(h.load(memory_order_relaxed) >> 32);
+    if (old_tag == tag || old_tag == 0) {
+      h.store(hint, memory_order_relaxed);
+      return;
+    }
+  }
+  // all slots are in use by other maps, replace one
+  hints[tag % MEMBER_ATOM_HINTS].store(hint, memory_order_relaxed);
+}
 
 // ----------------------------------------------------------------------------- : ScriptValue
 // Base cases
@@ -69,6 +150,9 @@ ScriptValueP ScriptValue::getMember(const String& name) const {
     return delay_error(ScriptErrorNoMember(typeName(), name));
   }
 }
+ScriptValueP ScriptValue::getMember(MemberAtom name) const {
+  return getMember(member_atom_to_string(name));
+}
 ScriptValueP ScriptValue::getIndex(int index) const {
   return delay_error(ScriptErrorNoMember(typeName(), String()<<index));
 }
@@ -241,7 +325,39 @@ private:
   }
 #endif
 
+DECLARE_PROFILE_COUNTER(counter_ints_allocated,       _("integers allocated"));
+DECLARE_PROFILE_COUNTER(counter_ints_preallocated,    _("integers preallocated"));
+DECLARE_PROFILE_COUNTER(counter_doubles_allocated,    _("doubles allocated"));
+DECLARE_PROFILE_COUNTER(counter_doubles_preallocated, _("doubles preallocated"));
+
+#if !USE_POOL_ALLOCATOR
+  // Small integers are preallocated, most arithmetic in templates stays in this range.
+  // Not done with the pool allocator, because the pool is destroyed before the table.
+  #define SMALL_INT_MIN -128
+  #define SMALL_INT_MAX 1023
+
+  const ScriptValueP* small_ints() {
+    // function local static, because to_script can be used during static initialization
+    static const vector<ScriptValueP> table = [] {
+      vector<ScriptValueP> table;
+      table.reserve(SMALL_INT_MAX - SMALL_INT_MIN + 1);
+      for (int v = SMALL_INT_MIN ; v <= SMALL_INT_MAX ; ++v) {
+        table.push_back(make_intrusive<ScriptInt>(v));
+      }
+      return table;
+    }();
+    return table.data();
+  }
+#endif
+
 ScriptValueP to_script(int v) {
+#if !USE_POOL_ALLOCATOR
+  if (v >= SMALL_INT_MIN && v <= SMALL_INT_MAX) {
+    COUNT_PROFILE(counter_ints_preallocated);
+    return small_ints()[v - SMALL_INT_MIN];
+  }
+#endif
+  COUNT_PROFILE(counter_ints_allocated);
 #if USE_POOL_ALLOCATOR
   #if USE_INTRUSIVE_PTR
     return ScriptValueP(
@@ -294,7 +410,26 @@ private:
   double value;
 };
 
+// function local statics, like small_ints, because to_script can be used during static initialization
+const ScriptValueP& script_zero_double() {
+  static const ScriptValueP value = make_intrusive<ScriptDouble>(0.0);
+  return value;
+}
+const ScriptValueP& script_one_double() {
+  static const ScriptValueP value = make_intrusive<ScriptDouble>(1.0);
+  return value;
+}
+
 ScriptValueP to_script(double v) {
+  // note: -0.0 == 0.0, but it is shown differently
+  if (v == 0.0 && !signbit(v)) {
+    COUNT_PROFILE(counter_doubles_preallocated);
+    return script_zero_double();
+  } else if (v == 1.0) {
+    COUNT_PROFILE(counter_doubles_preallocated);
+    return script_one_double();
+  }
+  COUNT_PROFILE(counter_doubles_allocated);
   return make_intrusive<ScriptDouble>(v);
 }
 
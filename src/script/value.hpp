@@ -15,6 +15,28 @@ class Dependency;
 class ScriptClosure;
 DECLARE_POINTER_TYPE(GeneratedImage);
 
+// ----------------------------------------------------------------------------- : Member names
+
+/// A member name, interned to an integer for faster lookups
+/** Member names used in scripts (as in "card.name") are converted to atoms when the script is parsed.
+ */
+enum MemberAtom
+{  MEMBER_ATOM_NONE = 0x03FFFFFF // must fit in the data of an Instruction
+};
+
+/// Return a unique atom for a member name
+MemberAtom string_to_member_atom(const String& name);
+
+/// Get the name of a member atom
+const String& member_atom_to_string(MemberAtom atom);
+
+/// Where was a member with the given name last found in an IndexMap with the given keys?
+/** The keys are identified by the first key of the map, so card fields, set fields and styling
+ *  each get their own hint, even though the maps have the same type.
+ *  This is only a hint, it should be verified before use */
+size_t member_atom_index_hint(MemberAtom atom, const void* keys);
+void   set_member_atom_index_hint(MemberAtom atom, const void* keys, size_t index);
+
 // ----------------------------------------------------------------------------- : ScriptValue
 
 DECLARE_POINTER_TYPE(ScriptValue);
@@ -77,6 +99,9 @@ public:
 
   /// Get a member variable from this value
   virtual ScriptValueP getMember(const String& name) const;
+  /// Get a member variable from this value, given an interned name
+  /** By default this is the same as getMember(member_atom_to_string(name)) */
+  virtual ScriptValueP getMember(MemberAtom name) const;
 
   /// Signal that a script depends on this value itself
   virtual void dependencyThis(const Dependency& dep);
@@ -0,0 +1,352 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <script/value_cache.hpp>
+#include <data/set.hpp>
+#include <data/game.hpp>
+#include <data/stylesheet.hpp>
+#include <data/card.hpp>
+#include <data/keyword.hpp>
+#include <data/field.hpp>
+#include <data/field/text.hpp>
+#include <data/field/choice.hpp>
+#include <data/field/color.hpp>
+#include <data/settings.hpp>
+#include <util/io/package_manager.hpp>
+#include <util/error.hpp>
+#include <wx/wfstream.h>
+#include <wx/dir.h>
+
+String image_cache_dir();
+
+// ----------------------------------------------------------------------------- : Hashing
+
+/// 64 bit FNV-1a hash, used to detect changes to the set file
+class Hash {
+public:
+  void add(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0 ; i < size ; ++i) {
+      value = (value ^ bytes[i]) * 1099511628211ULL;
+    }
+  }
+  void add(const String& str) {
+    wxScopedCharBuffer utf8 = str.utf8_str();
+    add(utf8.data(), utf8.length() + 1); // include the 0 terminator, so "ab"+"c" != "a"+"bc"
+  }
+  /// Add the contents of a file, returns false if it can't be read
+  bool addFile(const String& filename) {
+    wxFileInputStream stream(filename);
+    if (!stream.IsOk()) return false;
+    char buffer[64 * 1024];
+    while (!stream.Eof()) {
+      stream.Read(buffer, sizeof(buffer));
+      add(buffer, stream.LastRead());
+      if (stream.LastRead() == 0) break;
+    }
+    return true;
+  }
+
+  String toString() const {
+    return String::Format(_("%08x%08x"), (unsigned int)(value >> 32), (unsigned int)(value & 0xFFFFFFFF));
+  }
+
+private:
+  unsigned long long value = 14695981039346656037ULL;
+};
+
+/// Sizes and modification times of the files that make up a set, returns false if they don't exist
+bool set_files_stamp(String& stamp, const String& filename) {
+  wxStructStat st;
+  if (wxStat(filename, &st) != 0) return false;
+  stamp << (double)st.st_size << _(" ") << (long)st.st_mtime << _("\n");
+  if (wxDirExists(filename)) {
+    // a directory, with the set file and a file per card
+    wxArrayString files;
+    wxDir::GetAllFiles(filename, &files, wxEmptyString, wxDIR_FILES);
+    files.Sort();
+    for (size_t i = 0 ; i < files.size() ; ++i) {
+      if (wxStat(files[i], &st) != 0) return false;
+      stamp << files[i] << _(" ") << (double)st.st_size << _(" ") << (long)st.st_mtime << _("\n");
+    }
+  }
+  return true;
+}
+
+/// Hash the files that make up a set, returns false if they can't be read
+bool hash_set_files(Hash& hash, const String& filename) {
+  if (wxFileExists(filename)) {
+    // a zip file
+    return hash.addFile(filename);
+  } else if (wxDirExists(filename)) {
+    // a directory, with the set file and a file per card
+    if (!hash.addFile(filename + _("/set"))) return false;
+    wxArrayString card_files;
+    wxDir::GetAllFiles(filename, &card_files, _("card *"), wxDIR_FILES);
+    card_files.Sort();
+    for (size_t i = 0 ; i < card_files.size() ; ++i) {
+      hash.add(card_files[i]);
+      if (!hash.addFile(card_files[i])) return false;
+    }
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// ----------------------------------------------------------------------------- : Cache key
+
+void add_package_to_key(String& key, const Packaged& package) {
+  key << package.relativeFilename() << _(" ") << package.version.toString()
+      << _(" ") << (long)package.lastModified().GetTicks() << _("\n");
+  // scripts can include files from dependencies
+  FOR_EACH_CONST(dep, package.dependencies) {
+    key << _("  ") << dep->package;
+    try {
+      PackagedP p = package_manager.openAny(dep->package, true);
+      key << _(" ") << p->version.toString() << _(" ") << (long)p->lastModified().GetTicks();
+    } catch (const Error&) {
+      key << _(" missing");
+    }
+    key << _("\n");
+  }
+}
+
+/// Everything that influences the result of the scripts of a set, except for the contents of the set files
+/** Returns false if the set can't be cached */
+bool value_cache_key(const Set& set, ValueCacheKey& out) {
+  if (set.absoluteFilename().empty()) return false;
+  if (!set_files_stamp(out.stamp, set.absoluteFilename())) return false;
+  String& key = out.key;
+  key << _("app ") << app_version.toString() << _("\n");
+  key << _("locale ") << settings.locale << _("\n");
+  add_package_to_key(key, *set.game);
+  // all stylesheets used by the set
+  vector<const StyleSheet*> stylesheets(1, set.stylesheet.get());
+  FOR_EACH_CONST(card, set.cards) {
+    if (card->stylesheet && find(stylesheets.begin(), stylesheets.end(), card->stylesheet.get()) == stylesheets.end()) {
+      stylesheets.push_back(card->stylesheet.get());
+    }
+  }
+  FOR_EACH(stylesheet, stylesheets) {
+    add_package_to_key(key, *stylesheet);
+    key << _("  spellcheck ") << (bool)settings.stylesheetSettingsFor(*stylesheet).card_spellcheck_enabled() << _("\n");
+  }
+  return true;
+}
+
+/// Hash the contents of the set files, if that wasn't done already
+bool value_cache_set_hash(const Set& set, ValueCacheKey& key) {
+  if (!key.set_hash.empty()) return true;
+  Hash hash;
+  if (!hash_set_files(hash, set.absoluteFilename())) return false;
+  key.set_hash = hash.toString();
+  return true;
+}
+
+/// Filename of the cache for a set, the key is part of the name, so old caches are never read
+String value_cache_prefix(const Set& set) {
+  Hash hash;
+  hash.add(set.absoluteFilename());
+  return _("values-") + hash.toString() + _("-");
+}
+String value_cache_filename(const Set& set, const String& key) {
+  Hash hash;
+  hash.add(key);
+  return image_cache_dir() + value_cache_prefix(set) + hash.toString() + _(".txt");
+}
+
+// ----------------------------------------------------------------------------- : Cache file
+
+/// Defaultable part of a value, the cache stores default values as well, so the defaultness is stored separately
+bool is_default_value(const Value& value) {
+  if (const TextValue*   v = dynamic_cast<const TextValue*>  (&value)) return v->value.isDefault();
+  if (const ChoiceValue* v = dynamic_cast<const ChoiceValue*>(&value)) return v->value.isDefault();
+  if (const ColorValue*  v = dynamic_cast<const ColorValue*> (&value)) return v->value.isDefault();
+  return false;
+}
+void make_default_value(Value& value) {
+  if      (TextValue*   v = dynamic_cast<TextValue*>  (&value)) v->value.makeDefault();
+  else if (ChoiceValue* v = dynamic_cast<ChoiceValue*>(&value)) v->value.makeDefault();
+  else if (ColorValue*  v = dynamic_cast<ColorValue*> (&value)) v->value.makeDefault();
+}
+
+/// The cached values of a set or card
+class CachedValues : public IntrusivePtrBase<CachedValues> {
+public:
+  IndexMap<FieldP,ValueP> data;
+  vector<String>          default_values; ///< Names of fields with a value in the default state
+  map<String,String>      sort_values;    ///< Value::sort_value of fields with a sort_script
+  vector<String>          keyword_usage;  ///< Card::keyword_usage, as "<field name>:<keyword index>"
+
+  void store(const Set& set, const IndexMap<FieldP,ValueP>& values, const Card* card);
+  void restore(const Set& set, IndexMap<FieldP,ValueP>& values, Card* card);
+
+  DECLARE_REFLECTION();
+};
+DECLARE_POINTER_TYPE(CachedValues);
+
+/// Keywords are referred to by index in the set keywords followed by the game keywords
+const Keyword* keyword_by_index(const Set& set, size_t i) {
+  if (i < set.keywords.size()) return set.keywords[i].get();
+  i -= set.keywords.size();
+  if (i < set.game->keywords.size()) return set.game->keywords[i].get();
+  return nullptr;
+}
+size_t keyword_index(const Set& set, const Keyword* kw) {
+  for (size_t i = 0 ; i < set.keywords.size() ; ++i) {
+    if (set.keywords[i].get() == kw) return i;
+  }
+  for (size_t i = 0 ; i < set.game->keywords.size() ; ++i) {
+    if (set.game->keywords[i].get() == kw) return set.keywords.size() + i;
+  }
+  return String::npos;
+}
+
+void CachedValues::store(const Set& set, const IndexMap<FieldP,ValueP>& values, const Card* card) {
+  data = values;
+  FOR_EACH_CONST(v, values) {
+    if (is_default_value(*v)) default_values.push_back(v->fieldP->name);
+    if (v->fieldP->sort_script) sort_values[v->fieldP->name] = v->sort_value;
+  }
+  if (card) {
+    FOR_EACH_CONST(usage, card->keyword_usage) {
+      size_t i = keyword_index(set, usage.second);
+      if (i == String::npos) continue;
+      keyword_usage.push_back(usage.first->fieldP->name + _(":") + String::Format(_("%d"), (int)i));
+    }
+  }
+}
+
+void CachedValues::restore(const Set& set, IndexMap<FieldP,ValueP>& values, Card* card) {
+  FOR_EACH(name, default_values) {
+    IndexMap<FieldP,ValueP>::const_iterator it = data.find(name);
+    if (it != data.end()) make_default_value(**it);
+  }
+  FOR_EACH(sv, sort_values) {
+    IndexMap<FieldP,ValueP>::const_iterator it = data.find(sv.first);
+    if (it != data.end()) (*it)->sort_value = sv.second;
+  }
+  values = data;
+  if (card) {
+    card->keyword_usage.clear();
+    FOR_EACH(usage, keyword_usage) {
+      size_t sep = usage.find_last_of(_(':'));
+      long i;
+      if (sep == String::npos || !usage.substr(sep + 1).ToLong(&i)) continue;
+      IndexMap<FieldP,ValueP>::const_iterator it = values.find(usage.substr(0, sep));
+      const Keyword* kw = keyword_by_index(set, (size_t)i);
+      if (it != values.end() && kw) card->keyword_usage.emplace_back(it->get(), kw);
+    }
+  }
+}
+
+IMPLEMENT_REFLECTION_NO_SCRIPT(CachedValues) {
+  REFLECT(data);
+  REFLECT(default_values);
+  REFLECT(sort_values);
+  REFLECT(keyword_usage);
+}
+
+template <>
+CachedValuesP read_new<CachedValues>(Reader&) {
+  // only called for cards, see ValueCacheFile
+  CachedValuesP values = make_intrusive<CachedValues>();
+  values->data.init(game_for_reading()->card_fields);
+  return values;
+}
+
+/// A cache file, with the key it was made for
+class ValueCacheFile {
+public:
+  String                key;
+  String                stamp;
+  String                set_hash;
+  CachedValues          set_info;
+  vector<CachedValuesP> cards;
+
+  DECLARE_REFLECTION();
+};
+
+IMPLEMENT_REFLECTION_NO_SCRIPT(ValueCacheFile) {
+  REFLECT(key);
+  REFLECT(stamp);
+  REFLECT(set_hash);
+  REFLECT(set_info);
+  REFLECT(cards);
+}
+
+// ----------------------------------------------------------------------------- : Reading/writing
+
+// Only sets for which running the scripts takes longer than this (in nanoseconds) are cached
+const int64_t VALUE_CACHE_MIN_UPDATE_TIME = 250 * 1000000LL;
+
+bool read_value_cache(Set& set, ValueCacheKey& key) {
+  if (!value_cache_key(set, key)) return false;
+  String filename = value_cache_filename(set, key.key);
+  if (!wxFileExists(filename)) return false;
+  try {
+    wxLogNull no_errors;
+    wxFileInputStream stream(filename);
+    if (!stream.IsOk()) return false;
+    ValueCacheFile file;
+    file.set_info.data.init(set.game->set_fields);
+    {
+      WITH_DYNAMIC_ARG(game_for_reading, set.game.get());
+      Reader reader(stream, nullptr, filename, true);
+      reader.handle_greedy(file);
+    }
+    if (file.key != key.key || file.cards.size() != set.cards.size()) return false;
+    if (file.stamp != key.stamp) {
+      // the files were touched or copied, but their contents could still be the same
+      if (!value_cache_set_hash(set, key) || file.set_hash != key.set_hash) return false;
+    }
+    // use the cached values
+    file.set_info.restore(set, set.data, nullptr);
+    for (size_t i = 0 ; i < set.cards.size() ; ++i) {
+      file.cards[i]->restore(set, set.cards[i]->data, set.cards[i].get());
+    }
+    return true;
+  } catch (const Error&) {
+    // a broken cache file, just run the scripts
+    return false;
+  }
+}
+
+void write_value_cache(const Set& set, ValueCacheKey& key, int64_t update_time) {
+  if (key.key.empty() || update_time < VALUE_CACHE_MIN_UPDATE_TIME) return;
+  try {
+    wxLogNull no_errors;
+    // remove caches for older versions of the set
+    wxArrayString old_files;
+    wxDir::GetAllFiles(image_cache_dir(), &old_files, value_cache_prefix(set) + _("*"), wxDIR_FILES);
+    for (size_t i = 0 ; i < old_files.size() ; ++i) {
+      wxRemoveFile(old_files[i]);
+    }
+    // write the values
+    if (!value_cache_set_hash(set, key)) return;
+    ValueCacheFile file;
+    file.key      = key.key;
+    file.stamp    = key.stamp;
+    file.set_hash = key.set_hash;
+    file.set_info.store(set, set.data, nullptr);
+    FOR_EACH_CONST(card, set.cards) {
+      CachedValuesP values = make_intrusive<CachedValues>();
+      values->store(set, card->data, card.get());
+      file.cards.push_back(values);
+    }
+    wxFileOutputStream stream(value_cache_filename(set, key.key));
+    if (!stream.IsOk()) return;
+    WITH_DYNAMIC_ARG(writing_value_cache, true);
+    Writer writer(stream, app_version);
+    writer.handle(file);
+  } catch (const Error&) {
+    // the cache is not essential
+  }
+}
@@ -0,0 +1,41 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+
+class Set;
+
+// ----------------------------------------------------------------------------- : Value cache
+
+// When a set is opened all scripts of all cards are run (SetScriptManager::updateAll).
+// For large sets that takes a while, so the results are stored in the cache directory.
+// The cache is only used when the set file, game, stylesheets and settings that
+// influence the scripts are exactly the same as when it was written.
+// The set files are compared by size and modification time, only when those have changed
+// are the contents of the files hashed.
+
+/// What is known about a set when looking for its cache, so it is only determined once
+class ValueCacheKey {
+public:
+  String key;      ///< Everything that influences the scripts except the set files, empty if the set can't be cached
+  String stamp;    ///< Sizes and modification times of the set files
+  String set_hash; ///< Hash of the contents of the set files, empty if it wasn't needed yet
+};
+
+/// Restore the values of all set and card fields from the cache
+/** Returns false if there is no up to date cache for this set, the set is not changed in that case. */
+bool read_value_cache(Set& set, ValueCacheKey& key);
+
+/// Store the values of all set and card fields in the cache
+/** Should be called after all scripts have been run, with the key from read_value_cache.
+ *  update_time is how long running the scripts took (in nanoseconds),
+ *  sets that are that quick to update are not cached.
+ *  Failure to write the cache is ignored. */
+void write_value_cache(const Set& set, ValueCacheKey& key, int64_t update_time);
@@ -76,7 +76,7 @@ void Reader::handle(Defaultable<T>& def) {
 }
 template <typename T>
 void Writer::handle(const Defaultable<T>& def) {
-  if (!def.isDefault()) {
+  if (!def.isDefault() || writing_value_cache()) {
     handle(def());
   }
 }
@@ -34,6 +34,11 @@ template <> void GetDefaultMember::handle(const wxDateTime&   v) { value = to_sc
 
 GetMember::GetMember(const String& name)
   : target_name(name)
+  , target_atom(MEMBER_ATOM_NONE)
+{}
+GetMember::GetMember(MemberAtom name)
+  : target_name(member_atom_to_string(name))
+  , target_atom(name)
 {}
 
 // caused by the pattern: if (!handler.isCompound()) { REFLECT_NAMELESS(stuff) }
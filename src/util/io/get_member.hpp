@@ -75,6 +75,8 @@ class GetMember {
 public:
   /// Construct a member getter that looks for the given name
   GetMember(const String& name);
+  /// Construct a member getter that looks for the given interned name
+  GetMember(MemberAtom name);
   
   /// Tell the reflection code we are getting a member for scripting purposes
   static constexpr bool isReading = false;
@@ -85,6 +87,8 @@ public:
 
   /// The result, or script_nil if the member was not found
   inline ScriptValueP result() { return gdm.result(); } 
+  /// The name we are looking for
+  inline const String& targetName() const { return target_name; }
   
   // --------------------------------------------------- : Handling objects
   
@@ -102,10 +106,20 @@ public:
   template <typename T> void handle(const T&);
   /// Handle an index map: invistigate keys
   template <typename K, typename V> void handle(const IndexMap<K,V>& m) {
-    if (gdm.result()) return;
-    for (typename IndexMap<K,V>::const_iterator it = m.begin() ; it != m.end() ; ++it) {
-      if (get_key_name(*it) == target_name) {
-        gdm.handle(*it);
+    if (gdm.result() || m.empty()) return;
+    const void* keys = get_key(m.at(0)).get();
+    if (target_atom != MEMBER_ATOM_NONE) {
+      // try the position where we found this name last time, in a map with the same keys
+      size_t hint = member_atom_index_hint(target_atom, keys);
+      if (hint < m.size() && get_key_name(m.at(hint)) == target_name) {
+        gdm.handle(m.at(hint));
+        return;
+      }
+    }
+    for (size_t i = 0 ; i < m.size() ; ++i) {
+      if (get_key_name(m.at(i)) == target_name) {
+        if (target_atom != MEMBER_ATOM_NONE) set_member_atom_index_hint(target_atom, keys, i);
+        gdm.handle(m.at(i));
         return;
       }
     }
@@ -115,6 +129,7 @@ public:
   
 private:
   const String& target_name;  ///< The name we are looking for
+  MemberAtom    target_atom;  ///< The interned name we are looking for, or MEMBER_ATOM_NONE
   GetDefaultMember gdm;    ///< Object to store and retrieve the value
 };
 
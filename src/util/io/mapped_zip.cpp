@@ -0,0 +1,419 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <util/io/mapped_zip.hpp>
+#include <wx/zipstrm.h>
+#include <wx/zstream.h>
+#include <wx/mstream.h>
+#include <wx/wfstream.h>
+#include <wx/filename.h>
+#include <wx/file.h>
+#if defined(__WXMSW__)
+  #include <io.h>
+#else
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+// ----------------------------------------------------------------------------- : Buffer pool
+
+/// Buffers for inflated entries
+/** Images are read one after another when a game or stylesheet is loaded,
+ *  reusing buffers saves allocating (and clearing) a large block of memory for each of them.
+ */
+class InflateBufferPool {
+public:
+  /// Get a buffer of at least the given size
+  vector<Byte> acquire(size_t size) {
+    {
+      wxMutexLocker lock(mutex);
+      // use the smallest free buffer that is large enough
+      size_t best = buffers.size();
+      for (size_t i = 0 ; i < buffers.size() ; ++i) {
+        if (buffers[i].size() >= size && (best == buffers.size() || buffers[i].size() < buffers[best].size())) {
+          best = i;
+        }
+      }
+      if (best < buffers.size()) {
+        vector<Byte> buffer = std::move(buffers[best]);
+        buffers.erase(buffers.begin() + best);
+        return buffer;
+      }
+    }
+    return vector<Byte>(size);
+  }
+  /// Return a buffer to the pool
+  void release(vector<Byte>&& buffer) {
+    if (buffer.empty() || buffer.size() > MAX_BUFFER_SIZE) return;
+    wxMutexLocker lock(mutex);
+    if (buffers.size() >= MAX_BUFFERS) {
+      // drop the smallest buffer
+      auto smallest = min_element(buffers.begin(), buffers.end(), [](const vector<Byte>& a, const vector<Byte>& b) { return a.size() < b.size(); });
+      if (smallest->size() >= buffer.size()) return;
+      buffers.erase(smallest);
+    }
+    buffers.push_back(std::move(buffer));
+  }
+private:
+  wxMutex mutex;
+  vector<vector<Byte>> buffers;
+  static const size_t MAX_BUFFERS = 8;
+  static const size_t MAX_BUFFER_SIZE = 16 * 1024 * 1024;
+};
+
+InflateBufferPool inflate_buffer_pool;
+
+// ----------------------------------------------------------------------------- : Streams
+
+/// Stream for a stored entry, directly from the mapped file
+/** Note that the reference to the file must be constructed before the stream
+ */
+class MappedZipFile_aux {
+protected:
+  MappedZipFileP file;
+  inline MappedZipFile_aux(const MappedZipFileP& file) : file(file) {}
+};
+class MappedEntryInputStream : private MappedZipFile_aux, public wxMemoryInputStream {
+public:
+  MappedEntryInputStream(const MappedZipFileP& file, const Byte* data, size_t size)
+    : MappedZipFile_aux(file)
+    , wxMemoryInputStream(data, size)
+  {}
+};
+
+/// Stream for an inflated entry, the buffer goes back to the pool afterwards
+class InflateBuffer_aux {
+protected:
+  vector<Byte> buffer;
+  inline InflateBuffer_aux(vector<Byte>&& buffer) : buffer(std::move(buffer)) {}
+  inline ~InflateBuffer_aux() { inflate_buffer_pool.release(std::move(buffer)); }
+};
+class InflatedEntryInputStream : private InflateBuffer_aux, public wxMemoryInputStream {
+public:
+  InflatedEntryInputStream(vector<Byte>&& buffer, size_t size)
+    : InflateBuffer_aux(std::move(buffer))
+    , wxMemoryInputStream(InflateBuffer_aux::buffer.data(), size)
+  {}
+};
+
+// ----------------------------------------------------------------------------- : MappedZipFile
+
+MappedZipFile::MappedZipFile(const Byte* data, size_t size)
+  : data(data), size(size)
+{}
+
+MappedZipFile::~MappedZipFile() {
+  unmap();
+}
+
+void MappedZipFile::unmap() {
+  if (!data) return;
+  #if defined(__WXMSW__)
+    UnmapViewOfFile(data);
+  #else
+    munmap(const_cast<Byte*>(data), size);
+  #endif
+  data = nullptr;
+  size = 0;
+}
+
+MappedZipFileP MappedZipFile::open(const String& filename) {
+  #if defined(__WXMSW__)
+    // allow writing, so append() can add to the end of the file while it is mapped
+    HANDLE file = CreateFileW(filename.wc_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return MappedZipFileP();
+    LARGE_INTEGER file_size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0 && (ULONGLONG)file_size.QuadPart <= (size_t)-1) {
+      mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    CloseHandle(file); // the mapping keeps the file open
+    if (!mapping) return MappedZipFileP();
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); // the view keeps the mapping alive
+    if (!data) return MappedZipFileP();
+    return MappedZipFileP(new MappedZipFile(static_cast<const Byte*>(data), (size_t)file_size.QuadPart));
+  #else
+    int fd = ::open(filename.fn_str(), O_RDONLY);
+    if (fd < 0) return MappedZipFileP();
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0 && (unsigned long long)st.st_size <= (size_t)-1) {
+      data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd); // the mapping keeps the file open
+    if (data == MAP_FAILED) return MappedZipFileP();
+    return MappedZipFileP(new MappedZipFile(static_cast<const Byte*>(data), (size_t)st.st_size));
+  #endif
+}
+
+inline unsigned int read_u16(const Byte* p) { return p[0] | (p[1] << 8); }
+inline unsigned int read_u32(const Byte* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24); }
+
+unique_ptr<wxInputStream> MappedZipFile::openIn(const wxZipEntry& entry) {
+  const size_t LOCAL_HEADER_SIZE = 30;
+  if (!data) return nullptr; // unmapped by a failed append
+  if (entry.GetFlags() & 1) return nullptr; // encrypted
+  wxFileOffset offset = entry.GetOffset(), compressed_size = entry.GetCompressedSize(), entry_size = entry.GetSize();
+  if (offset < 0 || compressed_size < 0 || entry_size < 0) return nullptr;
+  if ((unsigned long long)offset + LOCAL_HEADER_SIZE > size) return nullptr;
+  // the local header has its own name and extra field, the data comes after that
+  const Byte* header = data + offset;
+  if (read_u32(header) != 0x04034b50) return nullptr;
+  size_t data_offset = (size_t)offset + LOCAL_HEADER_SIZE + read_u16(header + 26) + read_u16(header + 28);
+  if (data_offset > size || (unsigned long long)compressed_size > size - data_offset) return nullptr;
+  const Byte* entry_data = data + data_offset;
+  
+  if (entry.GetMethod() == wxZIP_METHOD_STORE && compressed_size == entry_size) {
+    // use the mapped data directly
+    return make_unique<MappedEntryInputStream>(intrusive_from_this(), entry_data, (size_t)entry_size);
+  } else if (entry.GetMethod() == wxZIP_METHOD_DEFLATE && (unsigned long long)entry_size <= (size_t)-1) {
+    // inflate into a buffer
+    vector<Byte> buffer = inflate_buffer_pool.acquire((size_t)entry_size);
+    wxMemoryInputStream compressed(entry_data, (size_t)compressed_size);
+    wxZlibInputStream inflated(compressed, wxZLIB_NO_HEADER);
+    if (entry_size > 0) {
+      inflated.Read(buffer.data(), (size_t)entry_size);
+      if (inflated.LastRead() != (size_t)entry_size) {
+        inflate_buffer_pool.release(std::move(buffer));
+        return nullptr;
+      }
+    }
+    return make_unique<InflatedEntryInputStream>(std::move(buffer), (size_t)entry_size);
+  } else {
+    return nullptr;
+  }
+}
+
+// ----------------------------------------------------------------------------- : Appending
+
+/// Update a CRC-32 checksum, as used in zip files
+unsigned int update_crc32(unsigned int crc, const Byte* data, size_t size) {
+  static const vector<unsigned int> table = [] {
+    vector<unsigned int> table(256);
+    for (unsigned int i = 0 ; i < 256 ; ++i) {
+      unsigned int c = i;
+      for (int k = 0 ; k < 8 ; ++k) c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+      table[i] = c;
+    }
+    return table;
+  }();
+  crc = ~crc;
+  for (size_t i = 0 ; i < size ; ++i) {
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+inline void write_u16(vector<Byte>& out, unsigned int x) {
+  out.push_back((Byte)x);
+  out.push_back((Byte)(x >> 8));
+}
+inline void write_u32(vector<Byte>& out, unsigned int x) {
+  write_u16(out, x & 0xFFFF);
+  write_u16(out, x >> 16);
+}
+
+/// Cut a file back to the given size
+bool truncate_file(wxFile& file, size_t size) {
+  #if defined(__WXMSW__)
+    return _chsize_s(file.fd(), (__int64)size) == 0;
+  #else
+    return ftruncate(file.fd(), (off_t)size) == 0;
+  #endif
+}
+
+/// Does a file have the given size, and an end of central directory record at the given position?
+bool has_end_record(const String& filename, size_t size, size_t end_record) {
+  wxFile file(filename);
+  Byte signature[4];
+  return file.IsOpened() && file.Length() == (wxFileOffset)size
+      && file.Seek((wxFileOffset)end_record) == (wxFileOffset)end_record
+      && file.Read(signature, 4) == 4 && read_u32(signature) == 0x06054b50;
+}
+
+bool MappedZipFile::append(const String& filename, const vector<ZipAppendEntry>& entries, double max_waste) {
+  const size_t END_RECORD_SIZE = 22, CENTRAL_HEADER_SIZE = 46, LOCAL_HEADER_SIZE = 30;
+  if (!data) return false;
+  // find the end of central directory record, it is followed only by the archive comment
+  if (size < END_RECORD_SIZE) return false;
+  size_t end_record = size - END_RECORD_SIZE;
+  size_t search_end = size > END_RECORD_SIZE + 0xFFFF ? size - END_RECORD_SIZE - 0xFFFF : 0;
+  while (read_u32(data + end_record) != 0x06054b50 || end_record + END_RECORD_SIZE + read_u16(data + end_record + 20) != size) {
+    if (end_record == search_end) return false;
+    --end_record;
+  }
+  const Byte* end = data + end_record;
+  size_t dir_size = read_u32(end + 12), dir_offset = read_u32(end + 16), dir_count = read_u16(end + 10);
+  if (read_u16(end + 4) != 0 || read_u16(end + 6) != 0 || dir_count == 0xFFFF || dir_offset == 0xFFFFFFFF) {
+    return false; // multiple disks or zip64
+  }
+  if (dir_offset + dir_size != end_record) return false; // data before the zip, as in self extracting archives
+  if (entries.size() >= 0xFFFF) return false; // would need zip64
+  
+  // read the central directory, by offset of the local header
+  struct Record {
+    size_t begin, end; ///< position of the central directory record
+    size_t used;       ///< size of the entry in the file, local header and data
+  };
+  map<size_t,Record> records;
+  for (size_t pos = dir_offset ; pos < end_record ;) {
+    const Byte* header = data + pos;
+    if (pos + CENTRAL_HEADER_SIZE > end_record || read_u32(header) != 0x02014b50) return false;
+    Record record;
+    record.begin = pos;
+    record.end   = pos + CENTRAL_HEADER_SIZE + read_u16(header + 28) + read_u16(header + 30) + read_u16(header + 32);
+    size_t compressed_size = read_u32(header + 20), offset = read_u32(header + 42);
+    if (record.end > end_record || compressed_size == 0xFFFFFFFF || offset + LOCAL_HEADER_SIZE > dir_offset) return false;
+    const Byte* local = data + offset;
+    record.used = LOCAL_HEADER_SIZE + read_u16(local + 26) + read_u16(local + 28) + compressed_size;
+    if (read_u16(header + 8) & 8) {
+      // followed by a data descriptor, with or without signature
+      bool signature = offset + record.used + 4 <= dir_offset && read_u32(local + record.used) == 0x08074b50;
+      record.used += signature ? 16 : 12;
+    }
+    records[offset] = record;
+    pos = record.end;
+  }
+  
+  // is it worth it?
+  size_t used = 0, added = 0;
+  FOR_EACH_CONST(e, entries) {
+    if (e.old_entry) {
+      auto it = records.find((size_t)e.old_entry->GetOffset());
+      if (it == records.end()) return false;
+      used += it->second.used;
+    } else {
+      wxULongLong file_size = wxFileName::GetSize(e.temp_file);
+      if (file_size == wxInvalidSize || file_size.GetValue() > 0xFFFFFFFF) return false;
+      added += (size_t)file_size.GetValue() * 101 / 100 + 1024; // enough for headers, and when deflating makes it larger
+    }
+  }
+  if (size - used > max_waste * (size + added)) return false;
+  if ((unsigned long long)size + added + 2 * dir_size > 0xFFFFFFFF) return false; // offsets would need zip64
+  
+  // add new entries at the end of the file
+  wxFile file(filename, wxFile::write_append);
+  if (!file.IsOpened() || file.Length() != (wxFileOffset)size) return false; // changed since we mapped it
+  try {
+    // new central directory, keep the records of old entries
+    vector<Byte> dir;
+    FOR_EACH_CONST(e, entries) {
+      if (e.old_entry) {
+        const Record& record = records[(size_t)e.old_entry->GetOffset()];
+        dir.insert(dir.end(), data + record.begin, data + record.end);
+      }
+    }
+    file.SeekEnd();
+    wxFileOutputStream out(file);
+    wxDateTime now = wxDateTime::Now();
+    unsigned int dos_time = (now.GetHour() << 11) | (now.GetMinute() << 5) | (now.GetSecond() / 2);
+    unsigned int dos_date = ((now.GetYear() - 1980) << 9) | ((now.GetMonth() + 1) << 5) | now.GetDay();
+    size_t pos = size;
+    FOR_EACH_CONST(e, entries) {
+      if (e.old_entry) continue;
+      wxScopedCharBuffer name = e.name.utf8_str();
+      // local header, the sizes and checksum follow the data in a data descriptor
+      vector<Byte> header;
+      write_u32(header, 0x04034b50);
+      write_u16(header, 20);     // version needed to extract: deflate
+      write_u16(header, 0x0808); // flags: sizes in data descriptor, utf-8 name
+      write_u16(header, 8);      // deflate
+      write_u16(header, dos_time);
+      write_u16(header, dos_date);
+      write_u32(header, 0); // crc
+      write_u32(header, 0); // compressed size
+      write_u32(header, 0); // size
+      write_u16(header, (unsigned int)name.length());
+      write_u16(header, 0); // extra field
+      header.insert(header.end(), name.data(), name.data() + name.length());
+      out.Write(header.data(), header.size());
+      // data
+      wxFileInputStream in(e.temp_file);
+      if (!in.IsOk()) throw PackageError(_ERROR_("unable to store file"));
+      unsigned int crc = 0;
+      size_t file_size = 0;
+      {
+        wxZlibOutputStream deflated(out, -1, wxZLIB_NO_HEADER);
+        vector<Byte> buffer(64 * 1024);
+        while (true) {
+          in.Read(buffer.data(), buffer.size());
+          size_t n = in.LastRead();
+          if (n == 0) break;
+          crc = update_crc32(crc, buffer.data(), n);
+          file_size += n;
+          deflated.Write(buffer.data(), n);
+        }
+        deflated.Close();
+      }
+      size_t compressed_size = (size_t)file.Tell() - pos - header.size();
+      vector<Byte> descriptor;
+      write_u32(descriptor, 0x08074b50);
+      write_u32(descriptor, crc);
+      write_u32(descriptor, (unsigned int)compressed_size);
+      write_u32(descriptor, (unsigned int)file_size);
+      out.Write(descriptor.data(), descriptor.size());
+      // central directory record
+      write_u32(dir, 0x02014b50);
+      write_u16(dir, 20); // version made by
+      write_u16(dir, 20);
+      write_u16(dir, 0x0808);
+      write_u16(dir, 8);
+      write_u16(dir, dos_time);
+      write_u16(dir, dos_date);
+      write_u32(dir, crc);
+      write_u32(dir, (unsigned int)compressed_size);
+      write_u32(dir, (unsigned int)file_size);
+      write_u16(dir, (unsigned int)name.length());
+      write_u16(dir, 0); // extra field
+      write_u16(dir, 0); // comment
+      write_u16(dir, 0); // disk
+      write_u16(dir, 0); // internal attributes
+      write_u32(dir, 0); // external attributes
+      write_u32(dir, (unsigned int)pos);
+      dir.insert(dir.end(), name.data(), name.data() + name.length());
+      pos += header.size() + compressed_size + descriptor.size();
+    }
+    
+    // the entries must be on disk before the central directory that refers to them
+    out.Sync();
+    if (!out.IsOk() || !file.Flush() || (size_t)file.Tell() != pos) {
+      throw PackageError(_ERROR_("unable to store file"));
+    }
+    
+    // central directory, and end record with the old archive comment
+    size_t new_dir_size = dir.size();
+    write_u32(dir, 0x06054b50);
+    write_u16(dir, 0); // disk
+    write_u16(dir, 0); // disk with the central directory
+    write_u16(dir, (unsigned int)entries.size());
+    write_u16(dir, (unsigned int)entries.size());
+    write_u32(dir, (unsigned int)new_dir_size);
+    write_u32(dir, (unsigned int)pos);
+    dir.insert(dir.end(), end + 20, data + size); // comment length and comment
+    out.Write(dir.data(), dir.size());
+    out.Sync();
+    if (!out.IsOk() || !file.Flush() || (size_t)file.Tell() != pos + dir.size()) {
+      throw PackageError(_ERROR_("unable to store file"));
+    }
+  } catch (...) {
+    // leave the file as it was, a partially written tail would hide the old central directory.
+    // cutting it back to the old size puts the old end record at the end again.
+    // windows doesn't allow making a mapped file smaller, so release the mapping first
+    size_t old_size = size;
+    unmap();
+    if (!truncate_file(file, old_size) || !has_end_record(filename, old_size, end_record)) {
+      throw PackageError(_ERROR_1_("unable to restore file", filename));
+    }
+    throw;
+  }
+  return true;
+}
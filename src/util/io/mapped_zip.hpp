@@ -0,0 +1,69 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+
+class wxZipEntry;
+DECLARE_POINTER_TYPE(MappedZipFile);
+
+/// A file to store in a zip file with MappedZipFile::append
+struct ZipAppendEntry {
+  String            name;      ///< Name of the file in the zip file
+  const wxZipEntry* old_entry; ///< Existing entry of the zip file to keep as it is, or nullptr
+  String            temp_file; ///< File with the new contents, when there is no old_entry
+};
+
+// ----------------------------------------------------------------------------- : MappedZipFile
+
+/// A zip file that is mapped into memory
+/** The file is opened and mapped once, after that entries can be read from it without touching the file again.
+ *  Any number of entries can be open at the same time, also from different threads.
+ *
+ *  Stored entries are read directly from the mapped memory, without copying.
+ *  Deflated entries are inflated into a buffer, buffers are reused for entries that are opened later.
+ *
+ *  The central directory is not parsed here, the entries come from wxZipInputStream, which reads it when
+ *  the package is opened.
+ */
+class MappedZipFile : public IntrusivePtrBase<MappedZipFile>, public IntrusiveFromThis<MappedZipFile> {
+public:
+  /// Map a zip file into memory, returns nullptr if that is not possible
+  static MappedZipFileP open(const String& filename);
+  ~MappedZipFile();
+  
+  /// Open a stream for an entry of this zip file
+  /** Returns nullptr if the entry can't be read from memory, for example because it is encrypted,
+   *  in that case a wxZipInputStream should be used instead.
+   *  The stream keeps the file mapped for as long as it exists.
+   */
+  unique_ptr<wxInputStream> openIn(const wxZipEntry& entry);
+  
+  /// Update the zip file by adding new files to the end, followed by a new central directory
+  /** entries are all files that should be in the zip file afterwards.
+   *  Existing entries are not moved, the space used by removed and replaced entries is wasted.
+   *  The old central directory is left alone until the new one has been written,
+   *  and the new entries are flushed to disk before that.
+   *  So no backup of the file is needed, the old archive is still there up to the old end record.
+   *
+   *  Returns false, without changing the file, if this is not possible,
+   *  or if more than max_waste (a fraction of the file size) would be wasted.
+   *  The zip file should then be written as a whole instead, which compacts it.
+   *  If writing fails, the file is cut back to its old size, and an exception is thrown.
+   *  The file is unmapped first (windows can't truncate a mapped file), so openIn returns nullptr after that,
+   *  and there should be no streams from openIn still open during append.
+   */
+  bool append(const String& filename, const vector<ZipAppendEntry>& entries, double max_waste);
+  
+private:
+  MappedZipFile(const Byte* data, size_t size);
+  void unmap();
+  const Byte* data; ///< The mapped file
+  size_t      size;
+};
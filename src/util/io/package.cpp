@@ -9,6 +9,7 @@
 #include <util/prec.hpp>
 #include <util/io/package.hpp>
 #include <util/io/package_manager.hpp>
+#include <util/io/mapped_zip.hpp>
 #include <util/error.hpp>
 #include <script/to_value.hpp> // for reflection
 #include <script/profiler.hpp> // for PROFILER
@@ -85,6 +86,7 @@ void Package::reopen() {
   if (wxDirExists(filename)) {
     // make sure we have no zip open
     zipStream.reset();
+    mappedZip.reset();
   } else {
     // reopen only needed for zipfile
     openZipfile();
@@ -207,8 +209,9 @@ unique_ptr<wxInputStream> Package::openIn(const String& file) {
     // a file in directory package
     stream = make_unique<wxFileInputStream>(filename+_("/")+file);
   } else if (wxFileExists(filename) && it != files.end() && it->second.zipEntry) {
-    // a file in a zip archive
-    stream = make_unique<ZipFileInputStream>(filename, it->second.zipEntry);
+    // a file in a zip archive, read it from memory if we can
+    if (mappedZip) stream = mappedZip->openIn(*it->second.zipEntry);
+    if (!stream)   stream = make_unique<ZipFileInputStream>(filename, it->second.zipEntry);
   } else {
     // shouldn't happen, packaged changed by someone else since opening it
     throw FileNotFoundError(file, filename);
@@ -397,6 +400,7 @@ void Package::openZipfile() {
   if (!zipStream->IsOk())  throw PackageError(_ERROR_1_("package not found", filename));
   // read zip entries
   loadZipStream();
+  mappedZip = MappedZipFile::open(filename);
 }
 
 void Package::saveToDirectory(const String& saveAs, bool remove_unused, bool is_copy) {
@@ -444,6 +448,8 @@ void Package::saveToDirectory(const String& saveAs, bool remove_unused, bool is_
 }
 
 void Package::saveToZipfile(const String& saveAs, bool remove_unused, bool is_copy) {
+  // only add the changed files when saving to the same file
+  if (!is_copy && saveAs == filename && saveToZipfileIncremental(remove_unused)) return;
   // create a temporary zip file name
   String tempFile = saveAs + _(".tmp");
   remove_file(tempFile);
@@ -474,6 +480,7 @@ void Package::saveToZipfile(const String& saveAs, bool remove_unused, bool is_co
     // close the old file
     if (!is_copy) {
       zipStream.reset();
+      mappedZip.reset();
     }
   } catch (Error const& e) {
     // when things go wrong delete the temp file
@@ -493,13 +500,40 @@ void Package::saveToZipfile(const String& saveAs, bool remove_unused, bool is_co
 }
 
 
+/// Fraction of the zip file that may be taken up by old versions of files before it is written as a whole
+const double MAX_WASTED_ZIP_SPACE = 0.25;
+
+bool Package::saveToZipfileIncremental(bool remove_unused) {
+  if (!mappedZip) return false;
+  vector<ZipAppendEntry> entries;
+  FOR_EACH(f, files) {
+    if (!f.second.keep && remove_unused) {
+      // to remove a file simply don't include it
+    } else if (f.second.wasWritten()) {
+      entries.push_back(ZipAppendEntry{f.first, nullptr, f.second.tempName});
+    } else if (f.second.zipEntry) {
+      entries.push_back(ZipAppendEntry{f.first, f.second.zipEntry, String()});
+    } else {
+      return false;
+    }
+  }
+  // no .bak here, a failed append leaves the old file as it was;
+  // saveToZipfile keeps one when it compacts the file
+  if (!mappedZip->append(filename, entries, MAX_WASTED_ZIP_SPACE)) return false;
+  // re-open zip file
+  zipStream.reset();
+  mappedZip.reset();
+  openZipfile();
+  return true;
+}
+
 Package::FileInfos::iterator Package::addFile(const String& name) {
   return files.insert(make_pair(normalize_internal_filename(name), FileInfo())).first;
 }
 
 DateTime Package::modificationTime(const pair<String, FileInfo>& fi) const {
   if (fi.second.wasWritten()) {
-    return wxFileName(fi.first).GetModificationTime();
+    return wxFileName(fi.second.tempName).GetModificationTime();
   } else if (fi.second.zipEntry) {
     return fi.second.zipEntry->GetDateTime();
   } else if (wxFileExists(filename+_("/")+fi.first)) {
@@ -509,6 +543,18 @@ DateTime Package::modificationTime(const pair<String, FileInfo>& fi) const {
   }
 }
 
+DateTime Package::modificationTime(const String& file) const {
+  FileInfos::const_iterator it = files.find(normalize_internal_filename(file));
+  if (it != files.end()) {
+    return modificationTime(*it);
+  } else if (wxFileExists(filename+_("/")+file)) {
+    // directory packages opened with fast=true don't know all their files
+    return wxFileName(filename+_("/")+file).GetModificationTime();
+  } else {
+    return DateTime((wxLongLong)0ul);
+  }
+}
+
 
 // ----------------------------------------------------------------------------- : Packaged
 
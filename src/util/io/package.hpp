@@ -18,6 +18,7 @@ class Package;
 class wxFileInputStream;
 class wxZipInputStream;
 class wxZipEntry;
+DECLARE_POINTER_TYPE(MappedZipFile);
 DECLARE_POINTER_TYPE(PackageDependency);
 
 /// The package that is currently being written to
@@ -69,14 +70,19 @@ private:
  *
  *  To accomplish this modified files are first written to temporary files, when save() is called
  *  the temporary files are moved/copied.
+ *  When a zip file is saved in place, only the changed files are added to the end of it,
+ *  until too much space is taken up by old versions of files, then the whole zip file is written again.
  *
  *  Zip files are accessed using wxZip(Input|Output)Stream.
  *  The zip input stream appears to only allow one file at a time, since the stream itself maintains
  *  state about what file we are reading.
  *  There are multiple solutions:
- *    1. (currently used) Open a new ZipInputStream for each file
- *    2. (may be faster) First read the file into a memory buffer,
+ *    1. Open a new ZipInputStream for each file
+ *    2. First read the file into a memory buffer,
  *      return a stream based on that buffer (StringInputStream).
+ *    3. (currently used) Map the zip file into memory once (MappedZipFile),
+ *      return a stream based on the mapped data, or on a buffer with the inflated data.
+ *      When the file can not be mapped, 1. is used instead.
  *
  *  TODO: maybe support sub packages (a package inside another package)?
  */
@@ -214,11 +220,15 @@ public:
   inline const FileInfos& getFileInfos() const { return files; }
   /// When was a file last modified?
   DateTime modificationTime(const pair<String, FileInfo>& fi) const;
+  /// When was a file last modified? Returns time 0 if this is not known
+  DateTime modificationTime(const String& file) const;
 private:
   /// All files in the package
   FileInfos files;
   /// Filestream/zipstream for reading zip files
   unique_ptr<wxZipInputStream> zipStream;
+  /// The zip file mapped into memory, for reading files from it
+  MappedZipFileP mappedZip;
 
   void loadZipStream();
   void openDirectory(bool fast = false);
@@ -228,6 +238,7 @@ private:
   void removeTempFiles(bool remove_unused);
   void clearKeepFlag();
   void saveToZipfile(const String&,   bool remove_unused, bool is_copy);
+  bool saveToZipfileIncremental(bool remove_unused);
   void saveToDirectory(const String&, bool remove_unused, bool is_copy);
   FileInfos::iterator addFile(const String& file);
 
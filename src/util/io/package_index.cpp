@@ -0,0 +1,284 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <util/io/package_index.hpp>
+#include <util/file_utils.hpp>
+#include <data/installer.hpp>
+#include <gfx/gfx.hpp>
+#include <wx/wfstream.h>
+#include <wx/dir.h>
+#include <wx/thread.h>
+
+String image_cache_dir();
+
+template <> void Reader::handle(PackageVersion::FileInfo& f);
+template <> void Writer::handle(const PackageVersion::FileInfo& f);
+
+// ----------------------------------------------------------------------------- : Utilities
+
+/// Size and modification time of a package file or directory, using a single stat
+bool package_stamp(const String& filename, double& size, DateTime& modified) {
+  wxStructStat st;
+  if (wxStat(filename, &st) != 0) return false;
+  size     = (double)st.st_size;
+  modified = DateTime((time_t)st.st_mtime);
+  return true;
+}
+
+/// Largest size of the icons stored in the cache, the package list shows them at most this large
+const int PACKAGE_ICON_SIZE = 96;
+
+// ----------------------------------------------------------------------------- : PackageIndexEntry
+
+IMPLEMENT_REFLECTION_NO_SCRIPT(PackageIndexEntry) {
+  REFLECT_NO_SCRIPT(name);
+  REFLECT_NO_SCRIPT(size);
+  REFLECT_NO_SCRIPT(modified);
+  REFLECT_NO_SCRIPT(description);
+  REFLECT_NO_SCRIPT(has_icon);
+  REFLECT_NO_SCRIPT(files);
+}
+
+// ----------------------------------------------------------------------------- : PackageIndex::Checker
+
+/// Checks whether the files in directory packages have changed since they were indexed
+class PackageIndex::Checker : public wxThread {
+public:
+  /// Copies the file lists, the entries themselves are not touched by the thread
+  Checker(const String& directory, const vector<PackageIndexEntryP>& entries)
+    : wxThread(wxTHREAD_JOINABLE), directory(directory), stopping(false)
+  {
+    FOR_EACH_CONST(e, entries) {
+      packages.push_back(make_pair(e->name, e->files));
+    }
+  }
+  ExitCode Entry() override;
+  /// Ask the thread to stop early
+  void stop() { stopping = true; }
+
+  vector<String> changed; ///< Packages that have changed, can only be used after the thread has finished
+
+private:
+  String directory;
+  vector<pair<String,vector<PackageVersion::FileInfo>>> packages;
+  std::atomic<bool> stopping;
+
+  /// Find the files in a directory package, in the same way as Package::openSubdir
+  void findFiles(const String& package, const String& name, vector<pair<String,time_t>>& out);
+};
+
+wxThread::ExitCode PackageIndex::Checker::Entry() {
+  vector<pair<String,time_t>> files;
+  FOR_EACH_CONST(p, packages) {
+    if (stopping) break;
+    String package = directory + _("/") + p.first;
+    if (!wxDirExists(package)) continue; // the time and size of zip files already cover their contents
+    files.clear();
+    findFiles(package, String(), files);
+    sort(files.begin(), files.end());
+    // compare with the indexed files
+    bool same = files.size() == p.second.size();
+    for (size_t i = 0 ; i < files.size() && same ; ++i) {
+      same = files[i].first  == p.second[i].file
+          && files[i].second == p.second[i].time.GetTicks();
+    }
+    if (!same) changed.push_back(p.first);
+  }
+  return 0;
+}
+
+void PackageIndex::Checker::findFiles(const String& package, const String& name, vector<pair<String,time_t>>& out) {
+  wxDir d(package + _("/") + name);
+  if (!d.IsOpened()) return;
+  String f;
+  for(bool ok = d.GetFirst(&f, wxEmptyString, wxDIR_FILES | wxDIR_HIDDEN) ; ok ; ok = d.GetNext(&f)) {
+    if (ignore_file(f)) continue;
+    out.push_back(make_pair(normalize_internal_filename(name + f), file_modified_time(package + _("/") + name + f)));
+  }
+  for(bool ok = d.GetFirst(&f, wxEmptyString, wxDIR_DIRS | wxDIR_HIDDEN) ; ok ; ok = d.GetNext(&f)) {
+    if (!f.empty() && f.GetChar(0) != _('.')) {
+      findFiles(package, name + f + _("/"), out);
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------- : PackageIndex
+
+PackageIndex::PackageIndex()
+  : loaded(false), changed(false), checker(nullptr)
+{}
+
+PackageIndex::~PackageIndex() {
+  if (checker) {
+    checker->stop();
+    finishCheck();
+  }
+}
+
+IMPLEMENT_REFLECTION_NO_SCRIPT(PackageIndex) {
+  REFLECT_NO_SCRIPT(directory);
+  REFLECT_NO_SCRIPT(packages);
+}
+
+bool compare_entry_name(const PackageIndexEntryP& a, const PackageIndexEntryP& b) {
+  return a->name < b->name;
+}
+
+void PackageIndex::open(const String& directory, const String& cache_name) {
+  finishCheck();
+  if (loaded && this->directory == directory) return;
+  this->cache_name = cache_name;
+  this->directory.clear();
+  packages.clear();
+  loaded  = true;
+  changed = false;
+  String filename = indexFilename();
+  if (wxFileExists(filename)) {
+    // a missing or broken index is not an error, it is just rebuilt
+    wxFileInputStream file_stream = {filename};
+    if (file_stream.Ok()) {
+      try {
+        Reader reader(file_stream, nullptr, filename, true);
+        reader.handle_greedy(*this);
+      } catch (const Error&) {
+        packages.clear();
+      }
+    }
+  }
+  if (this->directory != directory) {
+    // the index was made for a different installation
+    this->directory = directory;
+    packages.clear();
+    changed = true;
+  }
+  sort(packages.begin(), packages.end(), compare_entry_name);
+}
+
+vector<PackageIndexEntryP>::iterator PackageIndex::position(const String& name) {
+  return lower_bound(packages.begin(), packages.end(), name, [](const PackageIndexEntryP& e, const String& n) { return e->name < n; });
+}
+
+PackageIndexEntryP PackageIndex::find(const String& name) {
+  vector<PackageIndexEntryP>::iterator it = position(name);
+  if (it == packages.end() || (*it)->name != name) return PackageIndexEntryP();
+  PackageIndexEntry& e = **it;
+  if (!e.description || !e.modified.IsValid()) return PackageIndexEntryP();
+  // is the entry up to date?
+  double size;
+  DateTime modified;
+  if (!package_stamp(directory + _("/") + name, size, modified)) return PackageIndexEntryP();
+  if (size != e.size || modified.GetTicks() != e.modified.GetTicks()) return PackageIndexEntryP();
+  used.push_back(*it);
+  return *it;
+}
+
+PackageIndexEntryP PackageIndex::add(Packaged& package, const PackageDescription& description) {
+  PackageIndexEntryP entry = make_intrusive<PackageIndexEntry>();
+  entry->name = package.relativeFilename();
+  if (!package_stamp(package.absoluteFilename(), entry->size, entry->modified)) {
+    entry->modified = DateTime((time_t)0);
+  }
+  entry->description = make_intrusive<PackageDescription>(description);
+  entry->description->icon = Image(); // stored separately
+  entry->files = PackageVersion::currentFiles(package);
+  // store a thumbnail of the icon
+  if (description.icon.Ok()) {
+    Image icon = description.icon;
+    if (icon.GetWidth() > PACKAGE_ICON_SIZE || icon.GetHeight() > PACKAGE_ICON_SIZE) {
+      icon = resample_preserve_aspect(icon, PACKAGE_ICON_SIZE, PACKAGE_ICON_SIZE);
+    }
+    String icon_dir = image_cache_dir() + _("package-icons");
+    if (!wxDirExists(icon_dir)) wxMkdir(icon_dir);
+    entry->has_icon = icon.SaveFile(iconFilename(entry->name), wxBITMAP_TYPE_PNG);
+  }
+  // add to the index
+  vector<PackageIndexEntryP>::iterator it = position(entry->name);
+  if (it != packages.end() && (*it)->name == entry->name) {
+    *it = entry;
+  } else {
+    packages.insert(it, entry);
+  }
+  changed = true;
+  return entry;
+}
+
+void PackageIndex::retain(const vector<String>& names) {
+  assert(is_sorted(names.begin(), names.end()));
+  size_t j = 0;
+  for (size_t i = 0 ; i < packages.size() ; ++i) {
+    if (binary_search(names.begin(), names.end(), packages[i]->name)) {
+      packages[j++] = packages[i];
+    } else {
+      if (packages[i]->has_icon) remove_file(iconFilename(packages[i]->name));
+      changed = true;
+    }
+  }
+  packages.resize(j);
+}
+
+Image PackageIndex::icon(const PackageIndexEntry& entry) const {
+  Image img;
+  if (entry.has_icon) {
+    String filename = iconFilename(entry.name);
+    if (wxFileExists(filename)) img.LoadFile(filename, wxBITMAP_TYPE_PNG);
+  }
+  return img;
+}
+
+void PackageIndex::save() {
+  if (!changed || directory.empty()) return;
+  wxFileOutputStream stream(indexFilename());
+  if (!stream.IsOk()) return; // not being able to write the cache is not an error
+  Writer writer(stream, app_version);
+  writer.handle(*this);
+  changed = false;
+}
+
+String PackageIndex::indexFilename() const {
+  return image_cache_dir() + _("packages-") + cache_name;
+}
+String PackageIndex::iconFilename(const String& name) const {
+  return image_cache_dir() + _("package-icons/") + cache_name + _("-") + name + _(".png");
+}
+
+// ----------------------------------------------------------------------------- : PackageIndex : background check
+
+void PackageIndex::checkInBackground() {
+  finishCheck();
+  if (used.empty()) return;
+  checker = new Checker(directory, used);
+  used.clear();
+  if (checker->Create() != wxTHREAD_NO_ERROR || checker->Run() != wxTHREAD_NO_ERROR) {
+    delete checker;
+    checker = nullptr;
+  }
+}
+
+void PackageIndex::finishCheck() {
+  if (!checker) return;
+  checker->Wait();
+  FOR_EACH_CONST(name, checker->changed) {
+    vector<PackageIndexEntryP>::iterator it = position(name);
+    if (it != packages.end() && (*it)->name == name) {
+      packages.erase(it);
+      changed = true;
+    }
+  }
+  delete checker;
+  checker = nullptr;
+}
+
+void PackageIndex::stopCheck() {
+  if (checker) {
+    checker->stop();
+    finishCheck();
+  }
+  save();
+}
+
@@ -0,0 +1,91 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <util/reflect.hpp>
+#include <util/io/package_manager.hpp>
+
+DECLARE_POINTER_TYPE(PackageIndexEntry);
+
+// ----------------------------------------------------------------------------- : PackageIndexEntry
+
+/// Information on an installed package, as stored in a PackageIndex
+class PackageIndexEntry : public IntrusivePtrBase<PackageIndexEntry> {
+public:
+  PackageIndexEntry() : size(0), has_icon(false) {}
+
+  String   name;     ///< Filename of the package, relative to the package directory
+  double   size;     ///< Size of the package file or directory, when it was indexed
+  DateTime modified; ///< Modification time of the package file or directory, when it was indexed
+  PackageDescriptionP description; ///< Description of the package, including its dependencies, but not the icon
+  bool     has_icon; ///< Is the icon of the package stored in the cache?
+  vector<PackageVersion::FileInfo> files; ///< Files in the package with their modification times, sorted by filename
+
+  DECLARE_REFLECTION();
+};
+
+// ----------------------------------------------------------------------------- : PackageIndex
+
+/// An index of the packages in a PackageDirectory, so listing them doesn't require opening every package
+/** The index is stored in the user's cache directory, together with thumbnails of the package icons.
+ *  An entry is up to date as long as the size and modification time of the package are unchanged,
+ *  so checking an entry takes a single stat.
+ *
+ *  Changing a file inside a directory package doesn't change the directory itself.
+ *  Therefore after the index is used, the files of directory packages are checked in a background thread.
+ *  Packages that turn out to be changed are dropped from the index, so they are opened again the next time.
+ */
+class PackageIndex {
+public:
+  PackageIndex();
+  ~PackageIndex();
+
+  /// Use the index for a package directory, loads the index from the cache the first time
+  /** Waits for a running background check, and applies its results. */
+  void open(const String& directory, const String& cache_name);
+
+  /// Find the up to date entry for a package, returns null if there is none
+  PackageIndexEntryP find(const String& name);
+  /// Add an entry for a package that was opened, replacing an existing one
+  PackageIndexEntryP add(Packaged& package, const PackageDescription& description);
+  /// Remove the entries of all packages not in the (sorted) list
+  void retain(const vector<String>& names);
+
+  /// Load the icon of an entry from the cache
+  Image icon(const PackageIndexEntry& entry) const;
+
+  /// Write the index to the cache, if it has changed
+  void save();
+
+  /// Start checking the files of the directory packages in the background
+  void checkInBackground();
+  /// Stop the background check, and save its results
+  void stopCheck();
+
+private:
+  class Checker;
+  String   directory;
+  String   cache_name;
+  vector<PackageIndexEntryP> packages; ///< sorted by name
+  vector<PackageIndexEntryP> used;     ///< Entries returned by find, these are checked in the background
+  bool     loaded;
+  bool     changed;
+  Checker* checker;                    ///< Running background check, if any
+
+  /// Wait for the background check to finish, and drop the packages it found to be changed
+  void finishCheck();
+  /// Position of a package in the list, or of where it should be inserted
+  vector<PackageIndexEntryP>::iterator position(const String& name);
+  String indexFilename() const;
+  String iconFilename(const String& name) const;
+
+  DECLARE_REFLECTION();
+};
+
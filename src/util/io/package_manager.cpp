@@ -8,6 +8,7 @@
 
 #include <util/prec.hpp>
 #include <util/io/package_manager.hpp>
+#include <util/io/package_index.hpp>
 #include <util/error.hpp>
 #include <util/file_utils.hpp>
 #include <data/game.hpp>
@@ -16,6 +17,8 @@
 #include <data/locale.hpp>
 #include <data/export_template.hpp>
 #include <data/installer.hpp>
+#include <gfx/generated_image.hpp>
+#include <gfx/image_pool.hpp>
 #include <wx/stdpaths.h>
 #include <wx/wfstream.h>
 
@@ -33,10 +36,17 @@ void PackageManager::init() {
                 wxStandardPaths::Get().GetUserDataDir());
 }
 void PackageManager::destroy() {
+  local.stopIndexCheck();
+  global.stopIndexCheck();
   loaded_packages.clear();
+  generated_image_cache.clear();
+  decoded_image_pool.clear();
 }
 void PackageManager::reset() {
   loaded_packages.clear();
+  // cached images refer to packages by pointer
+  generated_image_cache.clear();
+  decoded_image_pool.clear();
 }
 
 PackagedP PackageManager::openAny(const String& name_, bool just_header) {
@@ -199,6 +209,12 @@ bool PackageManager::install(const InstallablePackage& package) {
 
 // ----------------------------------------------------------------------------- : PackageDirectory
 
+PackageDirectory::PackageDirectory()
+  : is_local(false)
+  , index(make_unique<PackageIndex>())
+{}
+PackageDirectory::~PackageDirectory() {}
+
 void PackageDirectory::init(bool local) {
   is_local = local;
   if (local) {
@@ -248,6 +264,7 @@ bool compare_name(const PackageVersionP& a, const PackageVersionP& b) {
 
 void PackageDirectory::installedPackages(vector<InstallablePackageP>& packages_out) {
   loadDatabase();
+  index->open(directory, is_local ? _("local") : _("global"));
   // find all package files
   vector<String> in_dir;
   for (String s = findFirstMatching(_("*.mse-*")) ; !s.empty() ; s = wxFindNextFile()) {
@@ -265,12 +282,11 @@ void PackageDirectory::installedPackages(vector<InstallablePackageP>& packages_o
     if (it1 == packages.end() || (*it1)->name > *it2) {
       // add new package to db
       try {
-        PackagedP pack = package_manager.openAny(*it2, true);
-        db_changed = true;
         PackageVersionP ver(new PackageVersion(
           is_local ? PackageVersion::STATUS_LOCAL : PackageVersion::STATUS_GLOBAL));
-        ver->check_status(*pack);
-        packages_out.push_back(make_intrusive<InstallablePackage>(make_intrusive<PackageDescription>(*pack), ver));
+        PackageDescriptionP description = describePackage(*it2, *ver);
+        db_changed = true;
+        packages_out.push_back(make_intrusive<InstallablePackage>(description, ver));
       } catch (const Error&) {}
       ++it2;
     } else if ((*it1)->name < *it2) {
@@ -280,9 +296,8 @@ void PackageDirectory::installedPackages(vector<InstallablePackageP>& packages_o
     } else {
       // ok, a package already in the db
       try {
-        PackagedP pack = package_manager.openAny(*it2, true);
-        (*it1)->check_status(*pack);
-        packages_out.push_back(make_intrusive<InstallablePackage>(make_intrusive<PackageDescription>(*pack), *it1));
+        PackageDescriptionP description = describePackage(*it2, **it1);
+        packages_out.push_back(make_intrusive<InstallablePackage>(description, *it1));
       } catch (const Error&) { db_changed = true; }
       ++it1, ++it2;
     }
@@ -296,6 +311,31 @@ void PackageDirectory::installedPackages(vector<InstallablePackageP>& packages_o
     }
     saveDatabase();
   }
+  // update the index, and check the packages we didn't open
+  index->retain(in_dir);
+  index->save();
+  index->checkInBackground();
+}
+
+PackageDescriptionP PackageDirectory::describePackage(const String& package_name, PackageVersion& ver) {
+  PackageIndexEntryP entry = index->find(package_name);
+  if (entry) {
+    ver.check_status(entry->description->name, entry->description->version, entry->files);
+    PackageDescriptionP description = make_intrusive<PackageDescription>(*entry->description);
+    description->icon = index->icon(*entry);
+    return description;
+  } else {
+    // open the package from this directory, not one with the same name from another directory
+    PackagedP pack = package_manager.openAny(name(package_name), true);
+    PackageDescriptionP description = make_intrusive<PackageDescription>(*pack);
+    entry = index->add(*pack, *description);
+    ver.check_status(entry->description->name, entry->description->version, entry->files);
+    return description;
+  }
+}
+
+void PackageDirectory::stopIndexCheck() {
+  index->stopCheck();
 }
 
 void PackageDirectory::bless(const String& package_name) {
@@ -443,21 +483,32 @@ IMPLEMENT_REFLECTION_NO_SCRIPT(PackageVersion) {
   REFLECT_NO_SCRIPT(files);
 }
 
+vector<PackageVersion::FileInfo> PackageVersion::currentFiles(Packaged& package) {
+  vector<FileInfo> current;
+  FOR_EACH_CONST(fi, package.getFileInfos()) {
+    current.push_back(FileInfo(fi.first, package.modificationTime(fi), FILE_UNCHANGED));
+  }
+  return current;
+}
+
 void PackageVersion::check_status(Packaged& package) {
+  check_status(package.relativeFilename(), package.version, currentFiles(package));
+}
+
+void PackageVersion::check_status(const String& name, const Version& version, const vector<FileInfo>& current_files) {
   status &= ~STATUS_MODIFIED;
   if (!(status & STATUS_BLESSED)) status |= STATUS_MODIFIED;
-  name    = package.relativeFilename();
-  version = package.version;
+  this->name    = name;
+  this->version = version;
   // Merge our files list with the list from the package
   vector<FileInfo> new_files;
-  Package::FileInfos fis = package.getFileInfos();
-  Package::FileInfos::const_iterator it1 = fis.begin();
+  vector<FileInfo>::const_iterator it1 = current_files.begin();
   vector<FileInfo>::iterator it2 = files.begin();
 //%  size_t it2 = 0, size = files.size();
 //%  bool need_sort = false;
-  while(it1 != fis.end() || it2 != files.end()) {
-    if (it1 != fis.end() && it2 != files.end() && it1->first == it2->file) {
-      DateTime mtime = package.modificationTime(*it1);
+  while(it1 != current_files.end() || it2 != files.end()) {
+    if (it1 != current_files.end() && it2 != files.end() && it1->file == it2->file) {
+      DateTime mtime = it1->time;
       if (mtime != it2->time) {
         it2->time   = mtime;
         it2->status = FILE_MODIFIED;
@@ -465,10 +516,9 @@ void PackageVersion::check_status(Packaged& package) {
         status |= STATUS_MODIFIED;
       }
       ++it1; ++it2;
-    } else if (it1 != fis.end() && (it2 == files.end() || it1->first < it2->file)) {
+    } else if (it1 != current_files.end() && (it2 == files.end() || it1->file < it2->file)) {
       // this is a new file
-      DateTime mtime = package.modificationTime(*it1);
-      new_files.push_back(FileInfo(it1->first, mtime, FILE_ADDED));
+      new_files.push_back(FileInfo(it1->file, it1->time, FILE_ADDED));
       status |= STATUS_MODIFIED;
       ++it1;
     } else {
@@ -15,7 +15,9 @@
 DECLARE_POINTER_TYPE(Packaged);
 DECLARE_POINTER_TYPE(PackageVersion);
 DECLARE_POINTER_TYPE(InstallablePackage);
+DECLARE_POINTER_TYPE(PackageDescription);
 class PackageDependency;
+class PackageIndex;
 
 // ----------------------------------------------------------------------------- : PackageVersion
 
@@ -59,6 +61,9 @@ IMPLEMENT_REFLECTION_NO_SCRIPT(UpdateData) {
 /// A directory for packages
 class PackageDirectory {
 public:
+  PackageDirectory();
+  ~PackageDirectory();
+  
   void init(bool local);
   void init(const String& dir);
   
@@ -88,12 +93,19 @@ public:
   
   void loadDatabase();
   void saveDatabase();
+  
+  /// Stop checking the package index in the background
+  void stopIndexCheck();
 private:
   bool   is_local;
   String directory;
   vector<PackageVersionP> packages; // sorted by name
+  unique_ptr<PackageIndex> index;   // cached descriptions of the packages
   
   String databaseFile();
+  /// Describe an installed package, and update the status of its files in ver
+  /** Uses the package index if possible, otherwise opens the package */
+  PackageDescriptionP describePackage(const String& name, PackageVersion& ver);
   // Do the actual installation of a package
   bool actual_install(const InstallablePackage& package, const String& install_dir);
   
@@ -228,6 +240,11 @@ public:
     FileStatus status;
     inline bool operator < (const FileInfo& f) const { return file < f.file; }
   };
+  
+  /// The files that are currently in a package, with their modification times, sorted by filename
+  static vector<FileInfo> currentFiles(Packaged& package);
+  /// Check the status of the files in this package, given the files that are currently in it
+  void check_status(const String& name, const Version& version, const vector<FileInfo>& current_files);
 private:
   vector<FileInfo> files; // sorted by filename
   DECLARE_REFLECTION();
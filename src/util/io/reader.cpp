@@ -24,7 +24,6 @@ Reader::Reader(wxInputStream& input, Packaged* package, const String& filename,
   , input(input)
 {
   assert(input.IsOk());
-  eat_utf8_bom(input);
   moveNext();
   handleAppVersion();
 }
@@ -98,11 +97,11 @@ void Reader::moveNext() {
   key.clear();
   indent = -1; // if no line is read it never has the expected indentation
   // repeat until we have a good line
-  while (key.empty() && !input.Eof()) {
+  while (key.empty() && !input.eof()) {
     readLine();
   }
   // did we reach the end of the file?
-  if (key.empty() && input.Eof()) {
+  if (key.empty() && input.eof()) {
     line_number += 1;
     indent = -1;
   }
@@ -153,43 +152,170 @@ bool eat_utf8_bom(wxInputStream& input) {
   return false;
 }
 
+/// Decode UTF-8 data into a string, in a single pass
+/** As opposed to wx functions, this one actually reports errors
+ */
+void decode_utf8(const char* data, size_t size, String& out) {
+  const unsigned char* it  = reinterpret_cast<const unsigned char*>(data);
+  const unsigned char* end = it + size;
+  bool valid = true;
+  // a UTF-8 string never has fewer bytes than the UTF-16/32 string has characters
+  wxStringBufferLength buffer(out, size);
+  wxChar* begin = buffer;
+  wxChar* out_it = begin;
+  while (it != end) {
+    unsigned int c = *it++;
+    if (c < 0x80) {
+      *out_it++ = (wxChar)c;
+      continue;
+    }
+    // multi byte sequence
+    int extra;
+    unsigned int min;
+    if      ((c & 0xE0) == 0xC0) { extra = 1; c &= 0x1F; min = 0x80; }
+    else if ((c & 0xF0) == 0xE0) { extra = 2; c &= 0x0F; min = 0x800; }
+    else if ((c & 0xF8) == 0xF0) { extra = 3; c &= 0x07; min = 0x10000; }
+    else { valid = false; break; }
+    if (end - it < extra) { valid = false; break; }
+    for (int i = 0 ; i < extra ; ++i) {
+      unsigned int cc = *it++;
+      if ((cc & 0xC0) != 0x80) valid = false;
+      c = (c << 6) | (cc & 0x3F);
+    }
+    if (!valid || c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+      valid = false; // overlong encoding, surrogate or out of range
+      break;
+    }
+    if (sizeof(wxChar) == 2 && c >= 0x10000) {
+      // surrogate pair
+      c -= 0x10000;
+      *out_it++ = (wxChar)(0xD800 + (c >> 10));
+      *out_it++ = (wxChar)(0xDC00 + (c & 0x3FF));
+    } else {
+      *out_it++ = (wxChar)c;
+    }
+  }
+  buffer.SetLength(valid ? out_it - begin : 0);
+  if (!valid) {
+    throw ParseError(_("Invalid UTF-8 sequence"));
+  }
+}
+
 /// Read an UTF-8 encoded line from an input stream
 /** As opposed to wx functions, this one actually reports errors
+ *  Reads one character at a time, so the stream is left just after the line.
+ *  For reading many lines use Utf8LineReader instead.
  */
 String read_utf8_line(wxInputStream& input, bool until_eof = false);
 String read_utf8_line(wxInputStream& input, bool until_eof) {
+  if (until_eof) {
+    // read the rest of the stream in large blocks
+    vector<char> buffer;
+    const size_t BLOCK_SIZE = 64 * 1024;
+    while (true) {
+      size_t size = buffer.size();
+      buffer.resize(size + BLOCK_SIZE);
+      input.Read(buffer.data() + size, BLOCK_SIZE);
+      buffer.resize(size + input.LastRead());
+      if (input.LastRead() == 0) break;
+    }
+    String result;
+    decode_utf8(buffer.data(), buffer.size(), result);
+    return result;
+  }
   LocalVector<char> buffer;
   while (true) {
     int c = input.GetC();
     if (c == EOF) break;
-    if (!until_eof) {
-      if (c == '\n') break;
-      if (c == '\r') {
-        c = input.GetC();
-        if (c != '\n' && c != EOF) {
-          input.Ungetch(c); // \r but not \r\n
-        }
-        break; 
+    if (c == '\n') break;
+    if (c == '\r') {
+      c = input.GetC();
+      if (c != '\n' && c != EOF) {
+        input.Ungetch(c); // \r but not \r\n
       }
+      break; 
     }
     buffer.push_back((Byte)c);
   }
-  // convert to string
-  // TODO: Doing this in one step should be faster
-  size_t size = wxConvUTF8.ToWChar(nullptr, 0, buffer.get(), buffer.size());
-  if (size == size_t(-1)) {
-    throw ParseError(_("Invalid UTF-8 sequence"));
-  } else if (size == 0) {
-    return _("");
+  String result;
+  decode_utf8(buffer.get(), buffer.size(), result);
+  return result;
+}
+
+// ----------------------------------------------------------------------------- : Utf8LineReader
+
+Utf8LineReader::Utf8LineReader(wxInputStream& input)
+  : input(input), pos(0), end(0), input_done(false), at_eof(false)
+{
+  fill();
+  // skip byte order mark
+  if (end >= 3 && (Byte)buffer[0] == 0xEF && (Byte)buffer[1] == 0xBB && (Byte)buffer[2] == 0xBF) {
+    pos = 3;
+  }
+}
+
+bool Utf8LineReader::fill() {
+  if (input_done) return false;
+  const size_t BLOCK_SIZE = 64 * 1024;
+  // move unconsumed data to the front
+  if (pos > 0) {
+    memmove(buffer.data(), buffer.data() + pos, end - pos);
+    end -= pos;
+    pos = 0;
+  }
+  // make room for another block; only grows for lines longer than the buffer
+  if (buffer.size() < end + BLOCK_SIZE) {
+    buffer.resize(max(2 * buffer.size(), end + BLOCK_SIZE));
   }
-  return wxString::FromUTF8(buffer.get(), buffer.size());
+  input.Read(buffer.data() + end, buffer.size() - end);
+  size_t read = input.LastRead();
+  end += read;
+  if (read == 0) input_done = true;
+  return read > 0;
 }
 
+void Utf8LineReader::readLine(String& line) {
+  size_t scanned = 0; // bytes after pos that are known not to contain a line ending
+  while (true) {
+    // find line ending
+    const char* line_begin = buffer.data() + pos;
+    const char* line_end   = line_begin + scanned;
+    const char* data_end   = buffer.data() + end;
+    while (line_end != data_end && *line_end != '\n' && *line_end != '\r') ++line_end;
+    if (line_end == data_end) {
+      // need more data
+      scanned = line_end - line_begin;
+      if (fill()) continue;
+      // end of input, the rest is the last line
+      at_eof = true;
+      decode_utf8(buffer.data() + pos, scanned, line);
+      pos = end;
+      return;
+    }
+    size_t length = line_end - line_begin;
+    if (*line_end == '\r' && line_end + 1 == data_end) {
+      // is this \r followed by \n? that is in the next block
+      if (!fill()) at_eof = true;
+      line_begin = buffer.data() + pos;
+      line_end   = line_begin + length;
+      data_end   = buffer.data() + end;
+    }
+    decode_utf8(line_begin, length, line);
+    pos += length + 1;
+    if (*line_end == '\r' && line_end + 1 != data_end && line_end[1] == '\n') {
+      pos += 1; // \r\n
+    }
+    return;
+  }
+}
+
+// ----------------------------------------------------------------------------- : Reader : reading lines
+
 void Reader::readLine(bool in_string) {
   line_number += 1;
   // We have to do our own line reading, because wxTextInputStream is insane
   try {
-    line = read_utf8_line(input);
+    input.readLine(line);
   } catch (const ParseError& e) {
     throw ParseError(e.what() + String(_(" on line ")) << line_number);
   }
@@ -205,23 +331,29 @@ void Reader::readLine(bool in_string) {
     return;
   }
   size_t pos = line.find_first_of(_(':'), indent);
-  key = line.substr(indent, pos - indent);
-  if (!ignore_invalid && !in_string && starts_with(key, _(" "))) {
-    warning(_("key: '") + key + _("' starts with a space; only use TABs for indentation!"), 0, false);
+  size_t key_begin = indent, key_end = min(pos, line.size());
+  if (!ignore_invalid && !in_string && line.GetChar(key_begin) == _(' ')) {
+    warning(_("key: '") + line.substr(key_begin, key_end - key_begin) + _("' starts with a space; only use TABs for indentation!"), 0, false);
     // try to fix up: 8 spaces is a tab
-    while (starts_with(key, _("        "))) {
-      key = key.substr(8);
+    while (is_substr(line, key_begin, _("        "))) {
+      key_begin += 8;
       indent += 1;
     }
   }
-  key = canonical_name_form(trim(key));
+  // assign in place, to reuse the memory of key and value
+  while (key_begin < key_end && isSpace(line.GetChar(key_begin)))   ++key_begin;
+  while (key_begin < key_end && isSpace(line.GetChar(key_end - 1))) --key_end;
+  key.assign(line, key_begin, key_end - key_begin);
+  canonical_name_form_in_place(key);
   if (pos == String::npos) {
     if (!ignore_invalid && !in_string) {
       warning(_("Missing ':' "), 0, false);
     }
     value.clear();
   } else {
-    value = trim_left(substr(line, pos+1));
+    size_t value_begin = pos + 1;
+    while (value_begin < line.size() && isSpace(line.GetChar(value_begin))) ++value_begin;
+    value.assign(line, value_begin, line.size() - value_begin);
   }
   if (key.empty() && pos!=String::npos) {
     key = _(" "); // we don't want an empty key if there was a colon
@@ -264,23 +396,23 @@ const String& Reader::getValue() {
     // read all lines that are indented enough
     readLine(true);
     previous_line_number = line_number;
-    while (indent >= expected_indent && !input.Eof()) {
+    while (indent >= expected_indent && !input.eof()) {
       previous_value.resize(previous_value.size() + pending_newlines, _('\n'));
       pending_newlines = 0;
-      previous_value += line.substr(expected_indent); // strip expected indent
+      previous_value.append(line, expected_indent, String::npos); // strip expected indent
       do {
         readLine(true);
         pending_newlines++;
         // skip empty lines that are not indented enough
-      } while(trim(line).empty() && indent < expected_indent && !input.Eof());
+      } while(trim(line).empty() && indent < expected_indent && !input.eof());
     }
     // moveNext(), but without the initial readLine()
     state = HANDLED;
-    while (key.empty() && !input.Eof()) {
+    while (key.empty() && !input.eof()) {
       readLine();
     }
     // did we reach the end of the file?
-    if (key.empty() && input.Eof()) {
+    if (key.empty() && input.eof()) {
       line_number += 1;
       indent = -1;
     }
@@ -18,6 +18,35 @@ DECLARE_POINTER_TYPE(StyleSheet);
 class Packaged;
 pair<unique_ptr<wxInputStream>, Packaged*> openFileFromPackage(Packaged* package, const String& name);
 
+// ----------------------------------------------------------------------------- : Utf8LineReader
+
+/// Reads UTF-8 encoded lines from a stream
+/** The input is read in large blocks, lines are found and decoded in a single pass over each block.
+ *  A UTF-8 byte order mark at the start of the stream is skipped.
+ */
+class Utf8LineReader {
+public:
+  Utf8LineReader(wxInputStream& input);
+  
+  /// Read the next line into line, without the line ending
+  /** Throws a ParseError if the line is not valid UTF-8 */
+  void readLine(String& line);
+  /// Has the end of the input been reached?
+  /** Like wxInputStream::Eof this only becomes true after trying to read past the end */
+  inline bool eof() const { return at_eof; }
+  
+private:
+  wxInputStream& input;
+  vector<char> buffer; ///< Data read from the input, buffer[pos..end) is not consumed yet
+  size_t pos, end;
+  bool input_done;     ///< Has all data been read from the input?
+  bool at_eof;
+  
+  /// Read more data from the input, returns false if there is none
+  /** May move the unconsumed data to the start of the buffer */
+  bool fill();
+};
+
 // ----------------------------------------------------------------------------- : Reader
 
 /// The Reader can be used for reading (deserializing) objects
@@ -147,7 +176,7 @@ private:
   /// Line number of the previous_line
   int previous_line_number;
   /// Input stream we are reading from
-  wxBufferedInputStream input;
+  Utf8LineReader input;
   /// Accumulated warning messages
   String warnings;
   
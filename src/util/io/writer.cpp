@@ -17,6 +17,8 @@ using boost::tribool;
 
 // ----------------------------------------------------------------------------- : Writer
 
+IMPLEMENT_DYNAMIC_ARG(bool, writing_value_cache, false);
+
 Writer::Writer(OutputStream& output, Version file_app_version)
   : indentation(0)
   , output(output)
@@ -10,12 +10,17 @@
 
 #include <util/prec.hpp>
 #include <wx/txtstrm.h>
+#include <util/dynamic_arg.hpp>
 
 template <typename T> class Defaultable;
 template <typename T> class Scriptable;
 DECLARE_POINTER_TYPE(Game);
 DECLARE_POINTER_TYPE(StyleSheet);
 
+/// Write all values, also default values and values of fields that are not normally saved
+/** Used when writing the value cache, see script/value_cache.hpp */
+DECLARE_DYNAMIC_ARG(bool, writing_value_cache);
+
 // ----------------------------------------------------------------------------- : Writer
 
 /// The Writer can be used for writing (serializing) objects
@@ -9,7 +9,9 @@
 #include <util/prec.hpp>
 #include <util/rotation.hpp>
 #include <gfx/gfx.hpp>
+#include <gfx/raster.hpp>
 #include <data/font.hpp>
+#include <gui/util.hpp> // clearDC
 
 // ----------------------------------------------------------------------------- : Rotation
 
@@ -172,14 +174,51 @@ Rotater::~Rotater() {
 
 RotatedDC::RotatedDC(DC& dc, Radians angle, const RealRect& rect, double zoom, RenderQuality quality, RotationFlags flags)
   : Rotation(angle, rect, zoom, 1.0, flags)
-  , dc(dc), quality(quality)
+  , dc(dc), canvas(nullptr), quality(quality)
 {}
 
 RotatedDC::RotatedDC(DC& dc, const Rotation& rotation, RenderQuality quality)
   : Rotation(rotation)
-  , dc(dc), quality(quality)
+  , dc(dc), canvas(nullptr), quality(quality)
 {}
 
+RotatedDC::RotatedDC(RasterCanvas& canvas, const Rotation& rotation)
+  : Rotation(rotation)
+  , dc(canvas.getTextDC()), canvas(&canvas), quality(QUALITY_AA)
+{}
+
+// ----------------------------------------------------------------------------- : RotatedDC : Canvas shapes
+
+// When drawing on a canvas, shapes are converted to polygons in internal coordinates,
+// and then translated, so they can be rotated freely.
+
+/// Add the corners of a rectangle, in external coordinates
+void add_rect_points(const Rotation& rot, const RealRect& r, vector<RealPoint>& out) {
+  out.push_back(rot.tr(RealPoint(r.left(),  r.top()   )));
+  out.push_back(rot.tr(RealPoint(r.left(),  r.bottom())));
+  out.push_back(rot.tr(RealPoint(r.right(), r.bottom())));
+  out.push_back(rot.tr(RealPoint(r.right(), r.top()   )));
+}
+
+/// Add the points of an elliptic arc, in external coordinates
+void add_arc_points(const Rotation& rot, const RealPoint& center, const RealSize& radius, Radians start, Radians end, vector<RealPoint>& out) {
+  size_t first = out.size();
+  add_arc_points(out, center, radius, start, end, rot.trInvS(0.1));
+  for (size_t i = first ; i < out.size() ; ++i) {
+    out[i] = rot.tr(out[i]);
+  }
+}
+
+/// Add the outline of a rounded rectangle, in external coordinates
+void add_rounded_rect_points(const Rotation& rot, const RealRect& r, double radius, vector<RealPoint>& out) {
+  radius = max(0., min(radius, min(r.width, r.height) / 2));
+  RealSize rad(radius, radius);
+  add_arc_points(rot, RealPoint(r.right() - radius, r.top()    + radius), rad, 0,          M_PI / 2,   out);
+  add_arc_points(rot, RealPoint(r.left()  + radius, r.top()    + radius), rad, M_PI / 2,   M_PI,       out);
+  add_arc_points(rot, RealPoint(r.left()  + radius, r.bottom() - radius), rad, M_PI,       3*M_PI / 2, out);
+  add_arc_points(rot, RealPoint(r.right() - radius, r.bottom() - radius), rad, 3*M_PI / 2, 2*M_PI,     out);
+}
+
 // ----------------------------------------------------------------------------- : RotatedDC : Drawing
 
 void RotatedDC::DrawText(const String& text, const RealPoint& pos, int blur_radius, int boldness, double stretch_) {
@@ -202,7 +241,15 @@ void RotatedDC::DrawText(const String& text, const RealPoint& pos, Color color,
       r_ext.x = r_ext2.x;
       r_ext.y = r_ext2.y;
     }
-    draw_resampled_text(dc, pos2, r_ext, stretch_, angle, color, text, blur_radius, boldness);
+    if (canvas) {
+      wxPoint img_pos;
+      Image img = render_resampled_text(dc.GetFont(), pos2, r_ext, stretch_, angle, color, text, blur_radius, img_pos);
+      for (int i = 0 ; i < boldness ; ++i) {
+        canvas->drawImage(img, img_pos.x, img_pos.y);
+      }
+    } else {
+      draw_resampled_text(dc, pos2, r_ext, stretch_, angle, color, text, blur_radius, boldness);
+    }
   } else if (quality >= QUALITY_SUB_PIXEL) {
     RealPoint p_ext = tr(pos)*text_scaling;
     double usx,usy;
@@ -224,7 +271,7 @@ void RotatedDC::DrawTextWithShadow(const String& text, const Font& font, const R
 }
 
 void RotatedDC::DrawBitmap(const Bitmap& bitmap, const RealPoint& pos) {
-  if (is_rad0(angle)) {
+  if (is_rad0(angle) && !canvas) {
     RealPoint p_ext = tr(pos);
     dc.DrawBitmap(bitmap, to_int(p_ext.x), to_int(p_ext.y), true);
   } else {
@@ -237,20 +284,44 @@ void RotatedDC::DrawImage(const Image& image, const RealPoint& pos, ImageCombine
 }
 void RotatedDC::DrawPreRotatedBitmap(const Bitmap& bitmap, const RealRect& rect) {
   RealPoint p_ext = tr(rect.position()) + boundingBoxCorner(rect.size());
-  dc.DrawBitmap(bitmap, to_int(p_ext.x), to_int(p_ext.y), true);
+  if (canvas) {
+    canvas->drawImage(bitmap.ConvertToImage(), to_int(p_ext.x), to_int(p_ext.y));
+  } else {
+    dc.DrawBitmap(bitmap, to_int(p_ext.x), to_int(p_ext.y), true);
+  }
 }
 void RotatedDC::DrawPreRotatedImage (const Image& image, const RealRect& rect, ImageCombine combine) {
   RealPoint p_ext = tr(rect.position()) + boundingBoxCorner(rect.size());
-  draw_combine_image(dc, to_int(p_ext.x), to_int(p_ext.y), image, combine);
+  if (canvas) {
+    canvas->drawImage(image, to_int(p_ext.x), to_int(p_ext.y), combine);
+  } else {
+    draw_combine_image(dc, to_int(p_ext.x), to_int(p_ext.y), image, combine);
+  }
 }
 
 void RotatedDC::DrawLine  (const RealPoint& p1,  const RealPoint& p2) {
+  if (canvas) {
+    // like on a DC, the line goes through the center of pixels
+    vector<RealPoint> points;
+    points.push_back(tr(p1) + RealPoint(0.5, 0.5));
+    points.push_back(tr(p2) + RealPoint(0.5, 0.5));
+    canvas->strokePolyline(points, false);
+    return;
+  }
   wxPoint p1_ext = tr(p1), p2_ext = tr(p2);
   dc.DrawLine(p1_ext.x, p1_ext.y, p2_ext.x, p2_ext.y);
 }
 
 void RotatedDC::DrawRectangle(const RealRect& r) {
-  if (is_straight(angle)) {
+  if (canvas) {
+    // like on a DC, the outline is drawn inside the rectangle
+    vector<RealPoint> points;
+    add_rect_points(*this, r, points);
+    canvas->fillPolygon(points);
+    points.clear();
+    add_rect_points(*this, r.grow(-trInvS(canvas->getPenWidth() / 2)), points);
+    canvas->strokePolyline(points, true);
+  } else if (is_straight(angle)) {
     wxRect r_ext = trRectToBB(r);
     dc.DrawRectangle(r_ext.x, r_ext.y, r_ext.width, r_ext.height);
   } else {
@@ -263,7 +334,15 @@ void RotatedDC::DrawRectangle(const RealRect& r) {
 }
 
 void RotatedDC::DrawRoundedRectangle(const RealRect& r, double radius) {
-  if (is_straight(angle)) {
+  if (canvas) {
+    vector<RealPoint> points;
+    add_rounded_rect_points(*this, r, radius, points);
+    canvas->fillPolygon(points);
+    points.clear();
+    double inset = trInvS(canvas->getPenWidth() / 2);
+    add_rounded_rect_points(*this, r.grow(-inset), radius - inset, points);
+    canvas->strokePolyline(points, true);
+  } else if (is_straight(angle)) {
     wxRect r_ext = trRectToBB(r);
     dc.DrawRoundedRectangle(r_ext.x, r_ext.y, r_ext.width, r_ext.height, trS(radius));
   } else {
@@ -273,21 +352,54 @@ void RotatedDC::DrawRoundedRectangle(const RealRect& r, double radius) {
 }
 
 void RotatedDC::DrawCircle(const RealPoint& center, double radius) {
+  if (canvas) {
+    DrawEllipse(center, RealSize(2 * radius, 2 * radius));
+    return;
+  }
   wxPoint p = tr(center);
   dc.DrawCircle(p.x + 1, p.y + 1, int(trS(radius)));
 }
 
 void RotatedDC::DrawEllipse(const RealPoint& center, const RealSize& size) {
+  if (canvas) {
+    vector<RealPoint> points;
+    add_arc_points(*this, center, size / 2, 0, 2 * M_PI, points);
+    canvas->fillPolygon(points);
+    points.clear();
+    double inset = trInvS(canvas->getPenWidth() / 2);
+    add_arc_points(*this, center, RealSize(size.width / 2 - inset, size.height / 2 - inset), 0, 2 * M_PI, points);
+    canvas->strokePolyline(points, true);
+    return;
+  }
   wxPoint c_ext = tr(center - size/2);
   wxSize  s_ext = trSizeToBB(size);
   dc.DrawEllipse(c_ext.x, c_ext.y, s_ext.x, s_ext.y);
 }
 void RotatedDC::DrawEllipticArc(const RealPoint& center, const RealSize& size, Radians start, Radians end) {
+  if (canvas) {
+    // a pie shape, only the arc gets an outline
+    if (end < start) end += 2 * M_PI;
+    vector<RealPoint> points;
+    add_arc_points(*this, center, size / 2, start, end, points);
+    // fill first, like the dc, so the outline is drawn on top of the fill
+    vector<RealPoint> pie = points;
+    pie.push_back(tr(center));
+    canvas->fillPolygon(pie);
+    canvas->strokePolyline(points, false);
+    return;
+  }
   wxPoint c_ext = tr(center - size/2);
   wxSize  s_ext = trSizeToBB(size);
   dc.DrawEllipticArc(c_ext.x, c_ext.y, s_ext.x, s_ext.y, rad_to_deg(start + angle), rad_to_deg(end + angle));
 }
 void RotatedDC::DrawEllipticSpoke(const RealPoint& center, const RealSize& size, Radians angle) {
+  if (canvas) {
+    vector<RealPoint> points;
+    points.push_back(tr(center));
+    points.push_back(tr(center + RealPoint(0.5 * size.width * cos(angle), -0.5 * size.height * sin(angle))));
+    canvas->strokePolyline(points, false);
+    return;
+  }
   wxPoint c_ext = tr(center - size/2);
   wxSize  s_ext = trSizeToBB(size);
   Radians rot_angle = angle + this->angle;
@@ -302,12 +414,63 @@ void RotatedDC::DrawEllipticSpoke(const RealPoint& center, const RealSize& size,
   );
 }
 
+void RotatedDC::DrawPreRotatedPolygon(const vector<RealPoint>& points) {
+  if (points.size() < 3) return;
+  if (canvas) {
+    canvas->fillPolygon(points);
+    canvas->strokePolyline(points, true);
+    return;
+  }
+  vector<wxPoint> points_ext;
+  FOR_EACH_CONST(p, points) points_ext.push_back(wxPoint(p));
+  dc.DrawPolygon((int)points_ext.size(), &points_ext[0]);
+}
+
+void RotatedDC::DrawCheckBox(const RealRect& r, bool checked) {
+  if (!canvas) {
+    draw_checkbox(nullptr, dc, trRectToBB(r), checked);
+    return;
+  }
+  // the same as the portable version of draw_checkbox: an outline, and a check mark made of two lines
+  Color color = wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOWTEXT);
+  canvas->setBrush(*wxTRANSPARENT_BRUSH);
+  canvas->setPen(wxPen(color, 1));
+  vector<RealPoint> points;
+  add_rect_points(*this, r.grow(-trInvS(0.5)), points);
+  canvas->strokePolyline(points, true);
+  if (checked) {
+    RealRect m = r.grow(-min(r.width, r.height) / 5);
+    points.clear();
+    points.push_back(tr(RealPoint(m.left(),                 m.top() + 0.55 * m.height)));
+    points.push_back(tr(RealPoint(m.left() + 0.35 * m.width, m.bottom())));
+    points.push_back(tr(RealPoint(m.right(),                m.top())));
+    canvas->setPen(wxPen(color, max(1, to_int(trS(min(r.width, r.height)) / 8))));
+    canvas->strokePolyline(points, false);
+  }
+}
+
+void RotatedDC::Fill() {
+  if (canvas) {
+    canvas->clear();
+  } else {
+    clearDC(dc, dc.GetBrush());
+  }
+}
+
 // ----------------------------------------------------------------------------- : Forwarded properties
 
-void RotatedDC::SetPen(const wxPen& pen)              { dc.SetPen(pen); }
-void RotatedDC::SetBrush(const wxBrush& brush)        { dc.SetBrush(brush); }
+void RotatedDC::SetPen(const wxPen& pen) {
+  if (canvas) canvas->setPen(pen);
+  else        dc.SetPen(pen);
+}
+void RotatedDC::SetBrush(const wxBrush& brush) {
+  if (canvas) canvas->setBrush(brush);
+  else        dc.SetBrush(brush);
+}
 void RotatedDC::SetTextForeground(const Color& color) { dc.SetTextForeground(color); }
-void RotatedDC::SetLogicalFunction(wxRasterOperationMode function)      { dc.SetLogicalFunction(function); }
+void RotatedDC::SetLogicalFunction(wxRasterOperationMode function) {
+  if (!canvas) dc.SetLogicalFunction(function); // not supported on a canvas, only used for editing
+}
 
 void RotatedDC::SetFont(const wxFont& font) {
   if (quality == QUALITY_LOW && zoomX == 1 && zoomY == 1) {
@@ -365,17 +528,49 @@ double RotatedDC::GetCharHeight() const {
   }
 }
 
+String RotatedDC::GetTextExtentKey() const {
+  wxSize ppi = dc.GetPPI();
+  return String::Format(_("%g %g %d %d %d "), zoomX, zoomY, (int)quality, ppi.x, ppi.y)
+       + dc.GetFont().GetNativeFontInfoDesc();
+}
+
 void RotatedDC::SetClippingRegion(const RealRect& rect) {
-  dc.SetDeviceClippingRegion(trRectToRegion(rect));
+  if (canvas) {
+    vector<RealPoint> points;
+    add_rect_points(*this, rect, points);
+    PolygonRasterizer shape;
+    shape.addPolygon(points);
+    canvas->setClip(shape);
+  } else {
+    dc.SetDeviceClippingRegion(trRectToRegion(rect));
+  }
+}
+void RotatedDC::SetClippingRegion(const RealRect& rect, const RealRect& except) {
+  if (canvas) {
+    vector<RealPoint> points;
+    PolygonRasterizer shape;
+    add_rect_points(*this, rect, points);
+    shape.addPolygon(points);
+    points.clear();
+    add_rect_points(*this, except, points);
+    shape.addPolygon(points);
+    canvas->setClip(shape, FILL_EVEN_ODD);
+  } else {
+    wxRegion r = trRectToRegion(rect);
+    r.Subtract(trRectToRegion(except));
+    dc.SetDeviceClippingRegion(r);
+  }
 }
 void RotatedDC::DestroyClippingRegion() {
-  dc.DestroyClippingRegion();
+  if (canvas) canvas->resetClip();
+  else        dc.DestroyClippingRegion();
 }
 
 // ----------------------------------------------------------------------------- : Other
 
 Bitmap RotatedDC::GetBackground(const RealRect& r) {
   wxRect wr = trRectToBB(r);
+  if (canvas) return Bitmap(canvas->getSubImage(wr));
   Bitmap background(wr.width, wr.height);
   wxMemoryDC mdc;
   mdc.SelectObject(background);
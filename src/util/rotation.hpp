@@ -13,6 +13,7 @@
 #include <gfx/gfx.hpp>
 
 class Font;
+class RasterCanvas;
 
 // ----------------------------------------------------------------------------- : Rotation
 
@@ -148,11 +149,15 @@ enum RenderQuality {
 
 /// A DC with rotation applied
 /** All draw** functions take internal coordinates.
+ *
+ *  Instead of a DC a RasterCanvas can be used, then all shapes and images are drawn by our own rasterizer.
+ *  Text is always drawn with QUALITY_AA in that case.
  */
 class RotatedDC : public Rotation {
 public:
   RotatedDC(DC& dc, Radians angle, const RealRect& rect, double zoom, RenderQuality quality, RotationFlags flags = ROTATION_NORMAL);
   RotatedDC(DC& dc, const Rotation& rotation, RenderQuality quality);
+  RotatedDC(RasterCanvas& canvas, const Rotation& rotation);
   
   // --------------------------------------------------- : Drawing
   
@@ -179,8 +184,13 @@ public:
   void DrawEllipticArc(const RealPoint& center, const RealSize& size, Radians start, Radians end);
   /// Draw spokes of an ellipse
   void DrawEllipticSpoke(const RealPoint& center, const RealSize& size, Radians start);
+  /// Draw a polygon with points that are already rotated and zoomed
+  void DrawPreRotatedPolygon(const vector<RealPoint>& points);
+  /// Draw a check box, like draw_checkbox does on a DC
+  /** Changes the pen and brush */
+  void DrawCheckBox(const RealRect& r, bool checked);
   
-  // Fill the dc with the color of the current brush
+  /// Fill the entire dc with the color of the current brush
   void Fill();
   
   // --------------------------------------------------- : Properties
@@ -200,8 +210,13 @@ public:
   
   RealSize GetTextExtent(const String& text) const;
   double GetCharHeight() const;
+  /// A key for caching text measurements, GetTextExtent gives the same results as long as the key is the same
+  /** Depends on the current font, the zoom and the quality */
+  String GetTextExtentKey() const;
   
   void SetClippingRegion(const RealRect& rect);
+  /// Clip to a rectangle, but exclude the inside of another one
+  void SetClippingRegion(const RealRect& rect, const RealRect& except);
   void DestroyClippingRegion();
   
   // --------------------------------------------------- : Other
@@ -209,10 +224,14 @@ public:
   /// Get the current contents of the given ractangle, for later restoring
   Bitmap GetBackground(const RealRect& r);
   
+  /// The actual dc, when drawing on a canvas this is only useful for measuring text
   inline wxDC& getDC() { return dc; }
+  /// The canvas we are drawing on, if any
+  inline RasterCanvas* getCanvas() { return canvas; }
   
 private:
   wxDC& dc;        ///< The actual dc
+  RasterCanvas* canvas;  ///< Canvas to draw on instead of the dc
   RenderQuality quality;  ///< Quality of the text
 };
 
@@ -266,6 +266,10 @@ int smart_compare(const String&, const String&);
 bool smart_less(const String&, const String&);
 /// Compare two strings for equality
 bool smart_equal(const String&, const String&);
+/// Comparison using smart_less, for sorted containers
+struct SmartLess {
+  inline bool operator () (const String& a, const String& b) const { return smart_less(a,b); }
+};
 
 /// Return whether str starts with start
 /** starts_with(a,b) == is_substr(a,0,b) */
@@ -0,0 +1,34 @@
+# Test the CLI server: run magicseteditor --server on a file of requests,
+# and compare the responses with the expected ones, one per line.
+# Only the id and the result or error are compared, not the messages and timing.
+#
+# Usage: cmake -DMSE=magicseteditor -DREQUESTS=file -DRESPONSES=file -P server.cmake
+#
+# With -DBLESS=ON the responses file is overwritten with the actual responses instead.
+# Do this after adding requests or changing the server, and review the differences before committing them.
+
+execute_process(
+  COMMAND "${MSE}" --server
+  INPUT_FILE "${REQUESTS}"
+  OUTPUT_VARIABLE output
+  RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "magicseteditor --server failed: ${result}")
+endif()
+
+string(REPLACE "\r" "" output "${output}")
+string(REGEX REPLACE ",\"messages\":[^\n]*" "}" output "${output}")
+
+if(BLESS)
+  file(WRITE "${RESPONSES}" "${output}")
+  message(STATUS "Wrote the responses to ${RESPONSES}")
+  return()
+endif()
+
+file(READ "${RESPONSES}" expected)
+string(REPLACE "\r" "" expected "${expected}")
+
+if(NOT output STREQUAL expected)
+  message(FATAL_ERROR "Unexpected responses\nExpected:\n${expected}\nActual:\n${output}")
+endif()
@@ -0,0 +1,175 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// Test the image kernels: the SSE2 code must give exactly the same results as the scalar code.
+// With --benchmark, afterwards show how long the kernels take with and without SSE2.
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <gfx/image_kernels.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+
+// ----------------------------------------------------------------------------- : Test data
+
+std::mt19937 random_engine(12345);
+int failures = 0;
+
+vector<Byte> random_bytes(size_t n) {
+  vector<Byte> out(n);
+  std::uniform_int_distribution<int> dist(0, 255);
+  for (size_t i = 0 ; i < n ; ++i) out[i] = (Byte)dist(random_engine);
+  return out;
+}
+
+/// All pairs of bytes, a[i] = i / 256, b[i] = i % 256
+void all_pairs(vector<Byte>& a, vector<Byte>& b) {
+  a.resize(256 * 256);
+  b.resize(256 * 256);
+  for (size_t i = 0 ; i < 256 * 256 ; ++i) {
+    a[i] = (Byte)(i / 256);
+    b[i] = (Byte)(i % 256);
+  }
+}
+
+/// Lengths to test, including the remainders after blocks of 16 bytes
+const size_t lengths[] = {0, 1, 3, 15, 16, 17, 31, 32, 33, 47, 100, 3 * 333, 4099};
+
+// ----------------------------------------------------------------------------- : Comparing
+
+/// Run a kernel on a copy of the data, with or without SSE2
+template <typename T>
+vector<T> run(const vector<T>& data, bool simd, const std::function<void(T*)>& kernel) {
+  vector<T> out = data;
+  simd_enabled = simd;
+  kernel(out.data());
+  simd_enabled = USE_SSE2;
+  return out;
+}
+
+/// Check that a kernel gives the same result with and without SSE2
+template <typename T>
+void check(const char* name, size_t n, const vector<T>& data, const std::function<void(T*)>& kernel) {
+  vector<T> simd   = run(data, true,  kernel);
+  vector<T> scalar = run(data, false, kernel);
+  for (size_t i = 0 ; i < simd.size() ; ++i) {
+    if (simd[i] != scalar[i]) {
+      printf("FAIL: %s, length %d, at %d: %u != %u\n", name, (int)n, (int)i, (UInt)simd[i], (UInt)scalar[i]);
+      ++failures;
+      return;
+    }
+  }
+}
+
+template <ImageCombine combine>
+void check_combine(const char* name) {
+  vector<Byte> a, b;
+  all_pairs(a, b);
+  check<Byte>(name, a.size(), a, [&](Byte* x) { combine_bytes<combine>(x, b.data(), a.size()); });
+  FOR_EACH_CONST(n, lengths) {
+    a = random_bytes(n);
+    b = random_bytes(n);
+    check<Byte>(name, n, a, [&](Byte* x) { combine_bytes<combine>(x, b.data(), n); });
+  }
+}
+
+void check_kernels() {
+  check_combine<COMBINE_ADD>("combine add");
+  check_combine<COMBINE_SUBTRACT>("combine subtract");
+  check_combine<COMBINE_DIFFERENCE>("combine difference");
+  check_combine<COMBINE_MULTIPLY>("combine multiply");
+  check_combine<COMBINE_DARKEN>("combine darken");
+  check_combine<COMBINE_LIGHTEN>("combine lighten");
+  check_combine<COMBINE_SCREEN>("combine screen");
+  check_combine<COMBINE_AND>("combine and");
+  check_combine<COMBINE_OR>("combine or");
+  check_combine<COMBINE_XOR>("combine xor");
+  // blending and multiplying, for all pairs and all masks
+  vector<Byte> a, b, m(256 * 256);
+  all_pairs(a, b);
+  check<Byte>("multiply_bytes", a.size(), a, [&](Byte* x) { multiply_bytes(x, b.data(), a.size()); });
+  for (int c = 0 ; c < 256 ; ++c) {
+    fill(m.begin(), m.end(), (Byte)c);
+    check<Byte>("mask_blend_bytes", a.size(), a, [&](Byte* x) { mask_blend_bytes(x, b.data(), m.data(), a.size()); });
+    check<Byte>("multiply_bytes (constant)", a.size(), a, [&](Byte* x) { multiply_bytes(x, (Byte)c, a.size()); });
+  }
+  FOR_EACH_CONST(n, lengths) {
+    a = random_bytes(n);
+    b = random_bytes(n);
+    m = random_bytes(n);
+    check<Byte>("mask_blend_bytes", n, a, [&](Byte* x) { mask_blend_bytes(x, b.data(), m.data(), n); });
+    check<Byte>("multiply_bytes", n, a, [&](Byte* x) { multiply_bytes(x, b.data(), n); });
+  }
+  // resampling, with the largest amounts and totals used by resample_pass
+  const int shift = 14;
+  FOR_EACH_CONST(n, lengths) {
+    vector<Byte> in = random_bytes(n);
+    vector<UInt> tot(n);
+    UInt amounts[] = {0, 1, 255, 256, 1000, (1 << shift) - 1, 1 << shift, 0xFFFF};
+    FOR_EACH_CONST(amt, amounts) {
+      check<UInt>("accumulate_bytes", n, tot, [&](UInt* t) { accumulate_bytes(t, in.data(), amt, n); });
+    }
+    // totals with a sum of amounts of at most 1<<shift
+    std::uniform_int_distribution<UInt> dist(0, (255 << shift) + (1 << shift) - 1);
+    FOR_EACH(t, tot) t = dist(random_engine);
+    vector<Byte> out(n);
+    check<Byte>("shift_bytes", n, out, [&](Byte* o) { shift_bytes(o, tot.data(), shift, n); });
+  }
+}
+
+// ----------------------------------------------------------------------------- : Benchmark
+
+/// Time a kernel on 4MB of data, with or without SSE2
+double time_kernel(bool simd, const std::function<void()>& kernel) {
+  simd_enabled = simd;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0 ; i < 100 ; ++i) kernel();
+  auto end = std::chrono::steady_clock::now();
+  simd_enabled = USE_SSE2;
+  return std::chrono::duration<double, std::milli>(end - start).count() / 100;
+}
+
+void benchmark(const char* name, const std::function<void()>& kernel) {
+  double scalar = time_kernel(false, kernel);
+  double simd   = time_kernel(true,  kernel);
+  printf("%-20s scalar %8.3f ms   sse2 %8.3f ms   speedup %5.2fx\n", name, scalar, simd, scalar / simd);
+}
+
+void benchmark_kernels() {
+  const size_t n = 4 << 20;
+  vector<Byte> a = random_bytes(n), b = random_bytes(n), m = random_bytes(n);
+  vector<UInt> tot(n);
+  benchmark("combine add",      [&] { combine_bytes<COMBINE_ADD>(a.data(), b.data(), n); });
+  benchmark("combine multiply", [&] { combine_bytes<COMBINE_MULTIPLY>(a.data(), b.data(), n); });
+  benchmark("combine screen",   [&] { combine_bytes<COMBINE_SCREEN>(a.data(), b.data(), n); });
+  benchmark("mask_blend_bytes", [&] { mask_blend_bytes(a.data(), b.data(), m.data(), n); });
+  benchmark("multiply_bytes",   [&] { multiply_bytes(a.data(), b.data(), n); });
+  benchmark("accumulate_bytes", [&] { accumulate_bytes(tot.data(), a.data(), 1000, n); });
+  benchmark("shift_bytes",      [&] { shift_bytes(a.data(), tot.data(), 14, n); });
+}
+
+// ----------------------------------------------------------------------------- : Main
+
+int main(int argc, char** argv) {
+  if (!USE_SSE2) {
+    printf("No SSE2 on this platform, only the scalar code is used\n");
+    return 0;
+  }
+  check_kernels();
+  if (failures) {
+    printf("%d kernels give different results with SSE2\n", failures);
+    return 1;
+  }
+  printf("All kernels give the same results with SSE2\n");
+  if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+    benchmark_kernels();
+  }
+  return 0;
+}
@@ -0,0 +1,302 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// Test the coverage computed by PolygonRasterizer: at the edges of shapes, with both fill rules,
+// for degenerate and clipped polygons, and the total anti-aliased coverage compared to the area.
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <gfx/raster.hpp>
+#include <cstdio>
+#include <limits>
+
+// ----------------------------------------------------------------------------- : Test data
+
+int failures = 0;
+
+/// Coverage of a rectangle of pixels
+vector<Byte> render(PolygonRasterizer& shape, FillRule rule, const wxRect& rect) {
+  vector<Byte> coverage;
+  shape.render(rule, rect, coverage);
+  return coverage;
+}
+
+vector<Byte> render(const vector<RealPoint>& points, FillRule rule, const wxRect& rect) {
+  PolygonRasterizer shape;
+  shape.addPolygon(points);
+  return render(shape, rule, rect);
+}
+
+/// Total coverage, in pixels
+double coverage_sum(const vector<Byte>& coverage) {
+  double sum = 0;
+  FOR_EACH_CONST(c, coverage) sum += c;
+  return sum / 255;
+}
+
+/// Area of a simple polygon
+double shoelace_area(const vector<RealPoint>& points) {
+  double area = 0;
+  for (size_t i = 0 ; i < points.size() ; ++i) {
+    area += cross(points[i], points[(i + 1) % points.size()]);
+  }
+  return fabs(area) / 2;
+}
+
+vector<RealPoint> rectangle(double x0, double y0, double x1, double y1) {
+  vector<RealPoint> points;
+  points.push_back(RealPoint(x0, y0));
+  points.push_back(RealPoint(x1, y0));
+  points.push_back(RealPoint(x1, y1));
+  points.push_back(RealPoint(x0, y1));
+  return points;
+}
+
+vector<RealPoint> circle(const RealPoint& center, double radius) {
+  vector<RealPoint> points;
+  add_arc_points(points, center, RealSize(radius, radius), 0, 2 * M_PI);
+  points.pop_back(); // same as the first point
+  return points;
+}
+
+/// A five pointed star, drawn as a single self intersecting polygon
+vector<RealPoint> pentagram(const RealPoint& center, double radius) {
+  vector<RealPoint> points;
+  for (int i = 0 ; i < 5 ; ++i) {
+    double angle = M_PI / 2 + i * 4 * M_PI / 5;
+    points.push_back(RealPoint(center.x + radius * cos(angle), center.y - radius * sin(angle)));
+  }
+  return points;
+}
+
+// ----------------------------------------------------------------------------- : Checking
+
+void check(bool ok, const char* name) {
+  if (!ok) {
+    printf("FAIL: %s\n", name);
+    ++failures;
+  }
+}
+
+void check_coverage(const char* name, const vector<Byte>& actual, const vector<Byte>& expected) {
+  if (actual.size() != expected.size()) {
+    printf("FAIL: %s, %d pixels instead of %d\n", name, (int)actual.size(), (int)expected.size());
+    ++failures;
+    return;
+  }
+  for (size_t i = 0 ; i < actual.size() ; ++i) {
+    if (actual[i] != expected[i]) {
+      printf("FAIL: %s, pixel %d: %d != %d\n", name, (int)i, actual[i], expected[i]);
+      ++failures;
+      return;
+    }
+  }
+}
+
+void check_area(const char* name, double actual, double expected, double tolerance) {
+  if (fabs(actual - expected) > tolerance) {
+    printf("FAIL: %s, coverage %f, area %f\n", name, actual, expected);
+    ++failures;
+  }
+}
+
+// ----------------------------------------------------------------------------- : Edges
+
+void check_edges() {
+  // edges on pixel boundaries
+  check_coverage("pixel aligned square", render(rectangle(1, 1, 3, 3), FILL_NONZERO, wxRect(0, 0, 4, 4)), {
+    0,   0,   0, 0,
+    0, 255, 255, 0,
+    0, 255, 255, 0,
+    0,   0,   0, 0});
+  // vertical edges: the horizontal coverage is exact
+  check_coverage("vertical edges", render(rectangle(0.25, 0, 2.75, 1), FILL_NONZERO, wxRect(0, 0, 3, 1)), {191, 255, 191});
+  // horizontal edges: coverage is a multiple of 1/SUBSAMPLES
+  check_coverage("horizontal edges", render(rectangle(0, 0.25, 1, 1.75), FILL_NONZERO, wxRect(0, 0, 1, 2)), {191, 191});
+  check_coverage("half pixel", render(rectangle(0, 0.5, 1, 1), FILL_NONZERO, wxRect(0, 0, 1, 1)), {128});
+  // a diagonal edge cuts the pixels on it in half
+  vector<RealPoint> triangle;
+  triangle.push_back(RealPoint(0, 0));
+  triangle.push_back(RealPoint(4, 0));
+  triangle.push_back(RealPoint(0, 4));
+  check_coverage("diagonal edge", render(triangle, FILL_NONZERO, wxRect(0, 0, 4, 4)), {
+    255, 255, 255, 128,
+    255, 255, 128,   0,
+    255, 128,   0,   0,
+    128,   0,   0,   0});
+  // the orientation of the polygon doesn't matter
+  reverse(triangle.begin(), triangle.end());
+  check_coverage("diagonal edge, reversed", render(triangle, FILL_NONZERO, wxRect(0, 0, 4, 4)), {
+    255, 255, 255, 128,
+    255, 255, 128,   0,
+    255, 128,   0,   0,
+    128,   0,   0,   0});
+}
+
+// ----------------------------------------------------------------------------- : Fill rules
+
+void check_fill_rules() {
+  // a square inside a square with the same orientation: only nonzero fills the inner one
+  PolygonRasterizer nested;
+  nested.addPolygon(rectangle(0, 0, 8, 8));
+  nested.addPolygon(rectangle(2, 2, 6, 6));
+  vector<Byte> nonzero  = render(nested, FILL_NONZERO,  wxRect(0, 0, 8, 8));
+  vector<Byte> even_odd = render(nested, FILL_EVEN_ODD, wxRect(0, 0, 8, 8));
+  check(nonzero [4 * 8 + 4] == 255, "nested squares, nonzero fills the inside");
+  check(even_odd[4 * 8 + 4] == 0,   "nested squares, even-odd leaves a hole");
+  check(nonzero [1 * 8 + 1] == 255 && even_odd[1 * 8 + 1] == 255, "nested squares, both fill the ring");
+  check_area("nested squares, nonzero",  coverage_sum(nonzero),  64, 1e-9);
+  check_area("nested squares, even-odd", coverage_sum(even_odd), 48, 1e-9);
+  // with opposite orientation both rules leave a hole
+  vector<RealPoint> inner = rectangle(2, 2, 6, 6);
+  reverse(inner.begin(), inner.end());
+  PolygonRasterizer hole;
+  hole.addPolygon(rectangle(0, 0, 8, 8));
+  hole.addPolygon(inner);
+  check_coverage("square with a hole", render(hole, FILL_NONZERO, wxRect(0, 0, 8, 8)), render(hole, FILL_EVEN_ODD, wxRect(0, 0, 8, 8)));
+  check_area("square with a hole", coverage_sum(render(hole, FILL_NONZERO, wxRect(0, 0, 8, 8))), 48, 1e-9);
+  // a pentagram: the pentagon in the middle has winding number 2
+  vector<RealPoint> star = pentagram(RealPoint(12, 12), 10);
+  nonzero  = render(star, FILL_NONZERO,  wxRect(0, 0, 24, 24));
+  even_odd = render(star, FILL_EVEN_ODD, wxRect(0, 0, 24, 24));
+  check(nonzero [12 * 24 + 11] == 255, "pentagram, nonzero fills the middle");
+  check(even_odd[12 * 24 + 11] == 0,   "pentagram, even-odd leaves the middle empty");
+  check(nonzero [5 * 24 + 11] == 255 && even_odd[5 * 24 + 11] == 255, "pentagram, both fill the points");
+  // the difference is the inner pentagon, its corners are where the star crosses itself.
+  // the edge pixels are rounded in both renders, so allow 1% of the perimeter (about 0.22 pixels)
+  double inner_radius = 10 * cos(2 * M_PI / 5) / cos(M_PI / 5);
+  double pentagon_area = 2.5 * inner_radius * inner_radius * sin(2 * M_PI / 5);
+  double pentagon_perimeter = 10 * inner_radius * sin(M_PI / 5);
+  check_area("pentagram, middle", coverage_sum(nonzero) - coverage_sum(even_odd), pentagon_area, 0.01 * pentagon_perimeter);
+}
+
+// ----------------------------------------------------------------------------- : Degenerate polygons
+
+void check_degenerate() {
+  PolygonRasterizer shape;
+  check(shape.empty() && shape.getBounds().IsEmpty(), "empty rasterizer has no bounds");
+  check_coverage("empty rasterizer", render(shape, FILL_NONZERO, wxRect(0, 0, 3, 2)), vector<Byte>(6, 0));
+  // only horizontal edges
+  vector<RealPoint> line;
+  line.push_back(RealPoint(0, 1));
+  line.push_back(RealPoint(5, 1));
+  shape.addPolygon(line);
+  check(shape.empty(), "horizontal line has no edges");
+  // a single point
+  shape.addPolygon(vector<RealPoint>(1, RealPoint(2, 2)));
+  check(shape.empty(), "single point has no edges");
+  // points on a line: no area
+  vector<RealPoint> collinear;
+  collinear.push_back(RealPoint(0, 0));
+  collinear.push_back(RealPoint(2, 2));
+  collinear.push_back(RealPoint(4, 4));
+  check_coverage("collinear points", render(collinear, FILL_NONZERO, wxRect(0, 0, 4, 4)), vector<Byte>(16, 0));
+  // points that are not numbers are ignored
+  double nan = numeric_limits<double>::quiet_NaN();
+  vector<RealPoint> not_numbers(3, RealPoint(nan, nan));
+  shape.clear();
+  shape.addPolygon(not_numbers);
+  check(shape.empty() && shape.getBounds().IsEmpty(), "polygon of NaNs has no edges");
+  // nothing to render into
+  check(render(rectangle(0, 0, 4, 4), FILL_NONZERO, wxRect(0, 0, 0, 4)).empty(), "empty rectangle");
+  check(render(rectangle(0, 0, 4, 4), FILL_NONZERO, wxRect(0, 0, -2, 4)).empty(), "negative rectangle");
+  // zero width stroke
+  shape.clear();
+  shape.addStroke(vector<RealPoint>(2, RealPoint(3, 3)), false, 0);
+  check(coverage_sum(render(shape, FILL_NONZERO, wxRect(0, 0, 6, 6))) == 0, "zero width stroke");
+}
+
+// ----------------------------------------------------------------------------- : Clipping
+
+void check_clipping() {
+  // rendering part of a shape gives the same pixels as rendering all of it
+  PolygonRasterizer shape;
+  shape.addPolygon(circle(RealPoint(5.3, 4.6), 7.2));
+  wxRect bounds = shape.getBounds();
+  check(bounds.x == -2 && bounds.y == -3 && bounds.width == 15 && bounds.height == 15, "bounds of a circle");
+  vector<Byte> all = render(shape, FILL_NONZERO, bounds);
+  const wxRect parts[] = {wxRect(2, 1, 5, 4), wxRect(-2, -3, 3, 2), wxRect(10, 8, 3, 4), wxRect(8, -3, 5, 15)};
+  FOR_EACH_CONST(part, parts) {
+    vector<Byte> expected;
+    for (int y = part.y ; y < part.y + part.height ; ++y) {
+      for (int x = part.x ; x < part.x + part.width ; ++x) {
+        expected.push_back(all[(y - bounds.y) * bounds.width + (x - bounds.x)]);
+      }
+    }
+    check_coverage("part of a circle", render(shape, FILL_NONZERO, part), expected);
+  }
+  // outside the shape
+  check_coverage("outside the shape", render(shape, FILL_NONZERO, wxRect(100, 100, 3, 3)), vector<Byte>(9, 0));
+  check_coverage("above the shape",   render(shape, FILL_NONZERO, wxRect(0, -20, 3, 3)),   vector<Byte>(9, 0));
+  // far away points don't overflow
+  check_coverage("huge square", render(rectangle(-1e8, -1e8, 1e8, 1e8), FILL_NONZERO, wxRect(0, 0, 2, 2)), vector<Byte>(4, 255));
+  shape.clear();
+  shape.addPolygon(rectangle(-1e30, 0, 1e30, 1));
+  bounds = shape.getBounds();
+  check(bounds.width > 0 && bounds.height == 1, "bounds of a very wide rectangle");
+  check_coverage("very wide rectangle", render(shape, FILL_NONZERO, wxRect(-5, 0, 3, 2)), {255, 255, 255, 0, 0, 0});
+}
+
+// ----------------------------------------------------------------------------- : Coverage sums
+
+void check_sums() {
+  // the anti-aliased coverage adds up to the area of the polygon
+  // the error comes from rounding each pixel and from sampling a limited number of scanlines
+  vector<vector<RealPoint>> shapes;
+  shapes.push_back(circle(RealPoint(15.4, 14.7), 10.3));
+  shapes.push_back(circle(RealPoint(3.5, 3.5), 0.8));
+  shapes.push_back(rectangle(1.3, 2.7, 20.1, 9.4));
+  vector<RealPoint> rotated_square;
+  for (int i = 0 ; i < 4 ; ++i) {
+    double angle = 0.3 + i * M_PI / 2;
+    rotated_square.push_back(RealPoint(12 + 9 * cos(angle), 12 + 9 * sin(angle)));
+  }
+  shapes.push_back(rotated_square);
+  FOR_EACH_CONST(points, shapes) {
+    PolygonRasterizer shape;
+    shape.addPolygon(points);
+    vector<Byte> coverage = render(shape, FILL_NONZERO, shape.getBounds());
+    double perimeter = 0;
+    for (size_t i = 0 ; i < points.size() ; ++i) {
+      perimeter += (points[(i + 1) % points.size()] - points[i]).length();
+    }
+    check_area("coverage sum", coverage_sum(coverage), shoelace_area(points), 0.01 * perimeter + 0.01);
+  }
+  // a stroke is the union of the line and round caps, the overlapping parts are counted once
+  PolygonRasterizer stroke;
+  vector<RealPoint> line;
+  line.push_back(RealPoint(2, 5));
+  line.push_back(RealPoint(10, 5));
+  stroke.addStroke(line, false, 2);
+  vector<Byte> coverage = render(stroke, FILL_NONZERO, wxRect(0, 0, 12, 10));
+  check(coverage[4 * 12 + 6] == 255 && coverage[5 * 12 + 6] == 255, "stroke covers the line");
+  check(coverage[3 * 12 + 6] == 0   && coverage[6 * 12 + 6] == 0,   "stroke has the right width");
+  check_area("stroke", coverage_sum(coverage), 8 * 2 + shoelace_area(circle(RealPoint(0, 0), 1)), 0.05);
+  // a closed stroke around a square, with the corners rounded off
+  stroke.clear();
+  vector<RealPoint> square = rectangle(3, 3, 9, 9);
+  stroke.addStroke(square, true, 2);
+  coverage = render(stroke, FILL_NONZERO, wxRect(0, 0, 12, 12));
+  check(coverage[6 * 12 + 6] == 0, "closed stroke leaves the inside empty");
+  check_area("closed stroke", coverage_sum(coverage), 8 * 8 - 4 * 4 - 4 + shoelace_area(circle(RealPoint(0, 0), 1)), 0.05);
+}
+
+// ----------------------------------------------------------------------------- : Main
+
+int main() {
+  check_edges();
+  check_fill_rules();
+  check_degenerate();
+  check_clipping();
+  check_sums();
+  if (failures) {
+    printf("%d polygon rasterizer checks failed\n", failures);
+    return 1;
+  }
+  printf("All polygon rasterizer checks passed\n");
+  return 0;
+}
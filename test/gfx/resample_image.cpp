@@ -0,0 +1,151 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// Test resampling on fixed images, with and without SSE2.
+// The expected results were made by the resample_pass from before it was restructured
+// to share the amounts between lines and to use the image kernels, so both must give exactly the same pixels.
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <gfx/gfx.hpp>
+#include <gfx/simd.hpp>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------- : Test data
+
+/// An image with pseudo random pixels, the same on all platforms
+Image test_image(int width, int height, bool alpha, UInt seed) {
+  Image img(width, height, false);
+  Byte* data = img.GetData();
+  for (int i = 0 ; i < 3 * width * height ; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    data[i] = (Byte)(seed >> 16);
+  }
+  if (alpha) {
+    img.InitAlpha();
+    Byte* a = img.GetAlpha();
+    for (int i = 0 ; i < width * height ; ++i) {
+      seed = seed * 1103515245u + 12345u;
+      a[i] = (Byte)(seed >> 16);
+    }
+  }
+  return img;
+}
+
+/// 64 bit FNV-1a hash of the pixels and alpha of an image
+unsigned long long hash_image(const Image& img) {
+  unsigned long long hash = 14695981039346656037ULL;
+  const Byte* data = img.GetData();
+  for (int i = 0 ; i < 3 * img.GetWidth() * img.GetHeight() ; ++i) {
+    hash = (hash ^ data[i]) * 1099511628211ULL;
+  }
+  if (img.HasAlpha()) {
+    const Byte* a = img.GetAlpha();
+    for (int i = 0 ; i < img.GetWidth() * img.GetHeight() ; ++i) {
+      hash = (hash ^ a[i]) * 1099511628211ULL;
+    }
+  }
+  return hash;
+}
+
+enum ResampleKind { RESAMPLE, RESAMPLE_AND_CLIP, PRESERVE_ASPECT, SHARP };
+
+struct ResampleCase {
+  const char*  name;
+  ResampleKind kind;
+  int  width_in, height_in;
+  bool alpha;
+  UInt seed;
+  int  width_out, height_out;
+  wxRect clip; ///< for RESAMPLE_AND_CLIP
+  unsigned long long expected_hash;
+};
+
+const ResampleCase cases[] = {
+  {"resample 7x5 to 3x4",                     RESAMPLE,          7,  5,  false, 1,  3,  4,  wxRect(), 0x3fce55ec07221517ULL},
+  {"resample 7x5 with alpha to 4x3",          RESAMPLE,          7,  5,  true,  2,  4,  3,  wxRect(), 0x9a646fabb7d2d24eULL},
+  {"resample 3x2 to 8x5",                     RESAMPLE,          3,  2,  false, 3,  8,  5,  wxRect(), 0xb4081bdefa55d19cULL},
+  {"resample 40x30 to 17x11",                 RESAMPLE,          40, 30, false, 4,  17, 11, wxRect(), 0x71698dc41236aca3ULL},
+  {"resample 40x30 with alpha to 23x13",      RESAMPLE,          40, 30, true,  5,  23, 13, wxRect(), 0xe412810d6822241fULL},
+  {"resample 5x20 to 1x7",                    RESAMPLE,          5,  20, false, 6,  1,  7,  wxRect(), 0x5fbbf1c90b865522ULL},
+  {"resample_and_clip 30x20 to 10x8",         RESAMPLE_AND_CLIP, 30, 20, false, 7,  10, 8,  wxRect(3,2,20,15), 0xe77e39f0eafcc307ULL},
+  {"resample_preserve_aspect 9x4 to 6x6",     PRESERVE_ASPECT,   9,  4,  true,  8,  6,  6,  wxRect(), 0x9560fc3c6eee1474ULL},
+  {"resample_preserve_aspect 12x30 to 10x10", PRESERVE_ASPECT,   12, 30, false, 9,  10, 10, wxRect(), 0xf8c522344751125bULL},
+  {"sharp_resample 32x24 to 8x6",             SHARP,             32, 24, false, 10, 8,  6,  wxRect(), 0x411d407e33adb916ULL},
+};
+
+// The pixels of the first two cases, so a failure shows what changed
+const Byte expected_7x5_to_3x4[] = {
+  150,111,160,179,146,181,115,96,144,119,69,95,98,103,173,158,100,118,
+  122,122,65,176,176,138,103,145,142,110,170,62,187,129,111,120,120,115
+};
+const Byte expected_7x5_alpha_to_4x3[] = {
+  150,109,211,46,196,109,108,141,123,156,153,98,83,141,167,89,96,142,
+  70,144,112,99,57,128,116,148,91,165,153,87,167,141,116,163,114,111
+};
+const Byte expected_7x5_alpha_to_4x3_alpha[] = {
+  171,142,117,111,191,113,148,149,37,78,106,118
+};
+
+// ----------------------------------------------------------------------------- : Checking
+
+int failures = 0;
+
+Image run(const ResampleCase& c) {
+  Image in = test_image(c.width_in, c.height_in, c.alpha, c.seed);
+  Image out(c.width_out, c.height_out); // cleared, resample_preserve_aspect doesn't write the border
+  switch (c.kind) {
+    case RESAMPLE:          resample(in, out); break;
+    case RESAMPLE_AND_CLIP: resample_and_clip(in, out, c.clip); break;
+    case PRESERVE_ASPECT:   resample_preserve_aspect(in, out); break;
+    case SHARP:             sharp_resample(in, out, 10); break;
+  }
+  return out;
+}
+
+void check_pixels(const char* name, const char* what, const Byte* actual, const Byte* expected, size_t n) {
+  for (size_t i = 0 ; i < n ; ++i) {
+    if (actual[i] != expected[i]) {
+      printf("FAIL: %s (%s), %s byte %d: %d != %d\n", name, simd_enabled ? "sse2" : "scalar", what, (int)i, actual[i], expected[i]);
+      ++failures;
+      return;
+    }
+  }
+}
+
+void check_cases() {
+  FOR_EACH_CONST(c, cases) {
+    Image out = run(c);
+    unsigned long long hash = hash_image(out);
+    if (hash != c.expected_hash) {
+      printf("FAIL: %s (%s), hash %016llx != %016llx\n", c.name, simd_enabled ? "sse2" : "scalar", hash, c.expected_hash);
+      ++failures;
+    }
+  }
+  Image out = run(cases[0]);
+  check_pixels(cases[0].name, "data", out.GetData(), expected_7x5_to_3x4, sizeof(expected_7x5_to_3x4));
+  out = run(cases[1]);
+  check_pixels(cases[1].name, "data",  out.GetData(),  expected_7x5_alpha_to_4x3,       sizeof(expected_7x5_alpha_to_4x3));
+  check_pixels(cases[1].name, "alpha", out.GetAlpha(), expected_7x5_alpha_to_4x3_alpha, sizeof(expected_7x5_alpha_to_4x3_alpha));
+}
+
+// ----------------------------------------------------------------------------- : Main
+
+int main() {
+  simd_enabled = false;
+  check_cases();
+  if (USE_SSE2) {
+    simd_enabled = true;
+    check_cases();
+  }
+  if (failures) {
+    printf("%d resample results differ from the expected ones\n", failures);
+    return 1;
+  }
+  printf("All resample results are as expected\n");
+  return 0;
+}
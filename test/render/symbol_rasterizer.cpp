@@ -0,0 +1,231 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// Test the symbol rasterizer against rendering on a DC and filtering the result, as render_symbol did before.
+// The DC is not anti-aliased, so the images differ at the edges of shapes;
+// they should agree everywhere else, for all combine modes and with symmetries.
+// Also check that the colorRow of the symbol filters gives the same colors as color.
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <data/symbol.hpp>
+#include <render/symbol/viewer.hpp>
+#include <render/symbol/filter.hpp>
+#include <render/symbol/rasterizer.hpp>
+#include <cstdio>
+
+DECLARE_POINTER_TYPE(SymbolFilter);
+
+// ----------------------------------------------------------------------------- : Application
+
+/// Drawing on a DC needs an application object
+class SymbolTestApp : public wxApp {
+public:
+  bool OnInit() override { return true; }
+};
+wxIMPLEMENT_APP_NO_MAIN(SymbolTestApp);
+
+// ----------------------------------------------------------------------------- : Test symbols
+
+SymbolShapeP polygon(const vector<Vector2D>& points, SymbolShapeCombine combine) {
+  SymbolShapeP shape = make_intrusive<SymbolShape>();
+  FOR_EACH_CONST(p, points) {
+    shape->points.push_back(make_intrusive<ControlPoint>(p.x, p.y));
+  }
+  shape->combine = combine;
+  return shape;
+}
+
+SymbolShapeP square(double x0, double y0, double x1, double y1, SymbolShapeCombine combine) {
+  return polygon({Vector2D(x0, y0), Vector2D(x0, y1), Vector2D(x1, y1), Vector2D(x1, y0)}, combine);
+}
+
+/// An ellipse made of four bezier curves
+SymbolShapeP ellipse(double cx, double cy, double rx, double ry, SymbolShapeCombine combine) {
+  const double k = 0.5523; // handle length for a quarter circle
+  SymbolShapeP shape = make_intrusive<SymbolShape>();
+  shape->points.push_back(make_intrusive<ControlPoint>(cx + rx, cy, 0, -k * ry, 0,  k * ry, LOCK_SIZE));
+  shape->points.push_back(make_intrusive<ControlPoint>(cx, cy + ry,  k * rx, 0, -k * rx, 0, LOCK_SIZE));
+  shape->points.push_back(make_intrusive<ControlPoint>(cx - rx, cy, 0,  k * ry, 0, -k * ry, LOCK_SIZE));
+  shape->points.push_back(make_intrusive<ControlPoint>(cx, cy - ry, -k * rx, 0,  k * rx, 0, LOCK_SIZE));
+  shape->combine = combine;
+  return shape;
+}
+
+SymbolP make_symbol(const vector<SymbolPartP>& parts) {
+  SymbolP symbol = make_intrusive<Symbol>();
+  symbol->parts = parts;
+  symbol->updateBounds();
+  return symbol;
+}
+
+SymbolP make_symmetry(SymbolSymmetryType kind, int copies, const vector<SymbolPartP>& parts) {
+  SymbolSymmetryP symmetry = make_intrusive<SymbolSymmetry>();
+  symmetry->kind   = kind;
+  symmetry->copies = copies;
+  symmetry->clip   = false;
+  symmetry->center = Vector2D(0.5, 0.5);
+  symmetry->handle = Vector2D(0.2, -0.3);
+  symmetry->parts  = parts;
+  return make_symbol({symmetry});
+}
+
+/// Symbols using all combine modes; the first item of a symbol is on top
+vector<pair<const char*,SymbolP>> test_symbols() {
+  vector<pair<const char*,SymbolP>> symbols;
+  symbols.emplace_back("default symbol", default_symbol());
+  symbols.emplace_back("merge", make_symbol({
+    square(0.35, 0.35, 0.9, 0.9, SYMBOL_COMBINE_MERGE),
+    square(0.1, 0.1, 0.65, 0.65, SYMBOL_COMBINE_OVERLAP)}));
+  symbols.emplace_back("subtract", make_symbol({
+    ellipse(0.5, 0.5, 0.22, 0.22, SYMBOL_COMBINE_SUBTRACT),
+    square(0.1, 0.1, 0.9, 0.9, SYMBOL_COMBINE_OVERLAP)}));
+  symbols.emplace_back("intersection", make_symbol({
+    polygon({Vector2D(0.5, 0.02), Vector2D(0.02, 0.5), Vector2D(0.5, 0.98), Vector2D(0.98, 0.5)}, SYMBOL_COMBINE_INTERSECTION),
+    square(0.12, 0.12, 0.88, 0.88, SYMBOL_COMBINE_OVERLAP)}));
+  symbols.emplace_back("difference", make_symbol({
+    ellipse(0.62, 0.62, 0.3, 0.25, SYMBOL_COMBINE_DIFFERENCE),
+    square(0.1, 0.1, 0.7, 0.7, SYMBOL_COMBINE_OVERLAP)}));
+  symbols.emplace_back("border", make_symbol({
+    square(0.3, 0.3, 0.7, 0.7, SYMBOL_COMBINE_BORDER),
+    square(0.1, 0.1, 0.9, 0.9, SYMBOL_COMBINE_OVERLAP)}));
+  symbols.emplace_back("overlap", make_symbol({
+    ellipse(0.6, 0.6, 0.3, 0.3, SYMBOL_COMBINE_OVERLAP),
+    square(0.1, 0.1, 0.6, 0.6, SYMBOL_COMBINE_MERGE)}));
+  symbols.emplace_back("rotation symmetry", make_symmetry(SYMMETRY_ROTATION, 4, {
+    polygon({Vector2D(0.5, 0.45), Vector2D(0.4, 0.1), Vector2D(0.62, 0.15)}, SYMBOL_COMBINE_MERGE)}));
+  symbols.emplace_back("reflection symmetry", make_symmetry(SYMMETRY_REFLECTION, 2, {
+    ellipse(0.35, 0.4, 0.2, 0.3, SYMBOL_COMBINE_OVERLAP)}));
+  return symbols;
+}
+
+vector<pair<const char*,SymbolFilterP>> test_filters() {
+  vector<pair<const char*,SymbolFilterP>> filters;
+  filters.emplace_back("solid", make_intrusive<SolidFillSymbolFilter>(Color(230,180,30), Color(0,0,0)));
+  filters.emplace_back("linear gradient", make_intrusive<LinearGradientSymbolFilter>(
+    Color(255,255,255), Color(0,0,0), Color(40,90,200,128), Color(120,0,0), 0.5, 0.5, 1, 1));
+  filters.emplace_back("radial gradient", make_intrusive<RadialGradientSymbolFilter>(
+    Color(255,220,0), Color(20,20,20), Color(200,60,0), Color(90,90,90,200)));
+  return filters;
+}
+
+// ----------------------------------------------------------------------------- : Comparing
+
+int failures = 0;
+
+/// How the two images differ
+struct Difference {
+  double mean;  ///< average largest difference of a premultiplied channel, per pixel
+  double large; ///< fraction of pixels that differ by more than half
+};
+
+Difference compare(const Image& a, const Image& b) {
+  Difference diff = {0, 0};
+  int count = a.GetWidth() * a.GetHeight();
+  const Byte* da = a.GetData(), * aa = a.GetAlpha();
+  const Byte* db = b.GetData(), * ab = b.GetAlpha();
+  for (int i = 0 ; i < count ; ++i) {
+    // compare premultiplied, the color of transparent pixels doesn't matter
+    int d = abs(aa[i] - ab[i]);
+    for (int c = 0 ; c < 3 ; ++c) {
+      d = max(d, abs(da[3 * i + c] * aa[i] / 255 - db[3 * i + c] * ab[i] / 255));
+    }
+    diff.mean  += d;
+    diff.large += d > 128;
+  }
+  diff.mean  /= count;
+  diff.large /= count;
+  return diff;
+}
+
+/// Render on a DC and filter, the way render_symbol did it before the rasterizer
+Image render_with_dc(const SymbolP& symbol, const SymbolFilter& filter, double border_radius, int size) {
+  Image img = render_symbol(symbol, border_radius, size, size, false, false);
+  filter_symbol(img, filter);
+  return img;
+}
+
+// Only the edges of shapes should differ: a non anti-aliased edge pixel is off by 64 on average,
+// and edges cover a few percent of the pixels.
+const double MAX_MEAN_DIFFERENCE  = 6;
+const double MAX_LARGE_DIFFERENCE = 0.03;
+
+bool within_tolerance(const Difference& diff) {
+  return diff.mean <= MAX_MEAN_DIFFERENCE && diff.large <= MAX_LARGE_DIFFERENCE;
+}
+
+void check_symbols() {
+  const int size = 120;
+  const double border_radius = 0.05;
+  auto symbols = test_symbols();
+  auto filters = test_filters();
+  FOR_EACH(s, symbols) {
+    FOR_EACH(f, filters) {
+      Image dc   = render_with_dc(s.second, *f.second, border_radius, size);
+      Image rast = rasterize_symbol(s.second, *f.second, border_radius, size, size, false);
+      if (dc.GetWidth() != rast.GetWidth() || dc.GetHeight() != rast.GetHeight()) {
+        printf("FAIL: %s, %s: size %dx%d != %dx%d\n", s.first, f.first, rast.GetWidth(), rast.GetHeight(), dc.GetWidth(), dc.GetHeight());
+        ++failures;
+        continue;
+      }
+      Difference diff = compare(dc, rast);
+      if (!within_tolerance(diff)) {
+        printf("FAIL: %s, %s: mean difference %.2f, %.1f%% of pixels differ by more than half\n", s.first, f.first, diff.mean, 100 * diff.large);
+        ++failures;
+      }
+    }
+  }
+  // the tolerance must be tight enough to notice a wrong combine mode
+  SolidFillSymbolFilter filter(Color(230,180,30), Color(0,0,0));
+  SymbolP merged     = make_symbol({ellipse(0.5, 0.5, 0.22, 0.22, SYMBOL_COMBINE_MERGE),    square(0.1, 0.1, 0.9, 0.9, SYMBOL_COMBINE_OVERLAP)});
+  SymbolP subtracted = make_symbol({ellipse(0.5, 0.5, 0.22, 0.22, SYMBOL_COMBINE_SUBTRACT), square(0.1, 0.1, 0.9, 0.9, SYMBOL_COMBINE_OVERLAP)});
+  Difference diff = compare(render_with_dc(merged, filter, border_radius, size), rasterize_symbol(subtracted, filter, border_radius, size, size, false));
+  if (within_tolerance(diff)) {
+    printf("FAIL: merge and subtract are within the tolerance (mean difference %.2f)\n", diff.mean);
+    ++failures;
+  }
+}
+
+// ----------------------------------------------------------------------------- : Filter rows
+
+void check_filter_rows() {
+  const int width = 37, height = 23;
+  vector<Color> row(width);
+  FOR_EACH(f, test_filters()) {
+    for (int point = SYMBOL_INSIDE ; point <= SYMBOL_OUTSIDE ; ++point) {
+      for (int y = 0 ; y < height ; ++y) {
+        f.second->colorRow(0, y, width, width, height, (SymbolSet)point, row.data());
+        for (int x = 0 ; x < width ; ++x) {
+          if (row[x] != f.second->color((double)x / width, (double)y / height, (SymbolSet)point)) {
+            printf("FAIL: %s, colorRow differs from color at (%d,%d)\n", f.first, x, y);
+            ++failures;
+            y = height;
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------- : Main
+
+int main(int argc, char** argv) {
+  if (!wxEntryStart(argc, argv)) {
+    printf("Unable to initialize wxWidgets\n");
+    return 1;
+  }
+  check_filter_rows();
+  check_symbols();
+  wxEntryCleanup();
+  if (failures) {
+    printf("%d symbol rendering checks failed\n", failures);
+    return 1;
+  }
+  printf("The symbol rasterizer agrees with rendering on a DC\n");
+  return 0;
+}
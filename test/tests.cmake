@@ -16,5 +16,61 @@ add_test(
   COMMAND magicseteditor ${test_dir}/script/script-functions.mse-script
 )
 
+# CLI server: parsing and writing JSON, and the responses to malformed requests
+# To update the expected responses run the same command with -DBLESS=ON
+add_test(
+  NAME cli-server
+  COMMAND ${CMAKE_COMMAND}
+    -DMSE=$<TARGET_FILE:magicseteditor>
+    -DREQUESTS=${test_dir}/cli/server-requests.jsonl
+    -DRESPONSES=${test_dir}/cli/server-responses.jsonl
+    -P ${test_dir}/cli/server.cmake
+)
+
+# Image kernels: the SSE2 code must give the same results as the scalar code
+# Run test-image-kernels --benchmark to compare their speed
+add_executable(test-image-kernels ${test_dir}/gfx/image_kernels.cpp)
+target_link_libraries(test-image-kernels ${wxWidgets_LIBRARIES})
+add_test(
+  NAME image-kernels
+  COMMAND test-image-kernels
+)
+
+# Resampling: fixed images must give the same pixels as the resampler before it used the kernels
+add_executable(test-resample-image ${test_dir}/gfx/resample_image.cpp ${PROJECT_SOURCE_DIR}/src/gfx/resample_image.cpp)
+target_link_libraries(test-resample-image ${wxWidgets_LIBRARIES})
+add_test(
+  NAME resample-image
+  COMMAND test-resample-image
+)
+
+# Polygon rasterizer: coverage at edges, fill rules, degenerate and clipped polygons, and total coverage
+add_executable(test-polygon-rasterizer ${test_dir}/gfx/polygon_rasterizer.cpp ${PROJECT_SOURCE_DIR}/src/gfx/polygon_rasterizer.cpp)
+target_link_libraries(test-polygon-rasterizer ${wxWidgets_LIBRARIES})
+add_test(
+  NAME polygon-rasterizer
+  COMMAND test-polygon-rasterizer
+)
+
+# Symbols: the rasterizer must agree with drawing on a DC, apart from anti-aliasing
+# this needs most of the program, everything except the application itself
+set(test_sources ${sources})
+list(FILTER test_sources EXCLUDE REGEX "src/main\\.cpp$")
+add_executable(test-symbol-rasterizer ${test_dir}/render/symbol_rasterizer.cpp ${test_sources})
+target_link_libraries(test-symbol-rasterizer ${wxWidgets_LIBRARIES} ${Boost_LIBRARIES} ${HUNSPELL_LIBRARIES})
+target_precompile_headers(test-symbol-rasterizer REUSE_FROM magicseteditor)
+add_test(
+  NAME symbol-rasterizer
+  COMMAND test-symbol-rasterizer
+)
+
+# Zip files: adding to a zip file several times, and reading it back with wxZipInputStream
+add_executable(test-mapped-zip ${test_dir}/util/mapped_zip.cpp ${PROJECT_SOURCE_DIR}/src/util/io/mapped_zip.cpp)
+target_link_libraries(test-mapped-zip ${wxWidgets_LIBRARIES})
+add_test(
+  NAME mapped-zip
+  COMMAND test-mapped-zip
+)
+
 # Rendering tests
 # TODO
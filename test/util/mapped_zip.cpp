@@ -0,0 +1,263 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// Test adding to zip files with MappedZipFile::append.
+// After each append the file is opened again, and read with wxZipInputStream, the reader used for packages.
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <util/io/mapped_zip.hpp>
+#include <wx/init.h>
+#include <wx/zipstrm.h>
+#include <wx/wfstream.h>
+#include <wx/filename.h>
+#include <wx/file.h>
+#include <cstdio>
+#include <string>
+
+// ----------------------------------------------------------------------------- : Linking
+
+// mapped_zip.cpp needs these from the rest of the program only for its error messages
+String warn_and_identity(const String& key) { return key; }
+String tr(LocaleCategory, const String& key, DefaultLocaleFun) { return key; }
+Error::Error(const String& message) : message(message) {}
+Error::~Error() {}
+String Error::what() const { return message; }
+
+// ----------------------------------------------------------------------------- : Files
+
+typedef map<String,std::string> ZipContents;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    ++failures;
+  }
+}
+
+std::string read_file(const String& filename) {
+  wxFile file(filename);
+  std::string data((size_t)max((wxFileOffset)0, file.Length()), '\0');
+  if (!data.empty() && file.Read(&data[0], data.size()) != (ssize_t)data.size()) data.clear();
+  return data;
+}
+
+void write_file(const String& filename, const std::string& data) {
+  wxFile file(filename, wxFile::write);
+  file.Write(data.data(), data.size());
+}
+
+std::string read_stream(wxInputStream& in) {
+  std::string data;
+  char buffer[4096];
+  do {
+    in.Read(buffer, sizeof(buffer));
+    data.append(buffer, in.LastRead());
+  } while (in.LastRead() > 0);
+  return data;
+}
+
+/// Contents of a file in the zip file, different for each version
+std::string contents(const char* name, int version, int lines) {
+  std::string data;
+  for (int i = 0 ; i < lines ; ++i) {
+    data += name;
+    data += " version " + std::to_string(version) + " line " + std::to_string(i * i % 997) + "\n";
+  }
+  return data;
+}
+
+inline unsigned int u16_at(const std::string& data, size_t pos) {
+  return (Byte)data[pos] | ((Byte)data[pos + 1] << 8);
+}
+inline unsigned int u32_at(const std::string& data, size_t pos) {
+  return u16_at(data, pos) | (u16_at(data, pos + 2) << 16);
+}
+
+// ----------------------------------------------------------------------------- : Zip files
+
+/// The entries of a zip file, as a package reads them when it is opened
+vector<unique_ptr<wxZipEntry>> read_entries(const String& filename) {
+  vector<unique_ptr<wxZipEntry>> entries;
+  wxFileInputStream file(filename);
+  wxZipInputStream zip(file);
+  while (wxZipEntry* entry = zip.GetNextEntry()) {
+    entries.emplace_back(entry);
+  }
+  return entries;
+}
+
+void write_zip(const String& filename, const ZipContents& files, bool store_first) {
+  wxFileOutputStream file(filename);
+  wxZipOutputStream zip(file);
+  zip.SetComment(_("archive comment"));
+  FOR_EACH_CONST(f, files) {
+    wxZipEntry* entry = new wxZipEntry(f.first);
+    if (store_first) entry->SetMethod(wxZIP_METHOD_STORE);
+    store_first = false;
+    zip.PutNextEntry(entry);
+    zip.Write(f.second.data(), f.second.size());
+  }
+  zip.Close();
+}
+
+/// Check that a zip file has the expected files, read with wxZipInputStream and from the mapped file
+void check_zip(const String& filename, const ZipContents& expected) {
+  ZipContents actual;
+  {
+    wxFileInputStream file(filename);
+    wxZipInputStream zip(file);
+    while (unique_ptr<wxZipEntry> entry{zip.GetNextEntry()}) {
+      actual[entry->GetName(wxPATH_UNIX)] = read_stream(zip);
+      check(zip.GetLastError() != wxSTREAM_READ_ERROR, "entry can be read (crc and sizes match)");
+    }
+    check(zip.GetComment() == _("archive comment"), "archive comment is kept");
+  }
+  check(actual == expected, "zip file contains the expected files");
+  // the same, through the mapped file
+  MappedZipFileP mapped = MappedZipFile::open(filename);
+  check(!!mapped, "zip file can be mapped");
+  if (!mapped) return;
+  FOR_EACH(entry, read_entries(filename)) {
+    unique_ptr<wxInputStream> in = mapped->openIn(*entry);
+    check(!!in, "entry can be read from the mapped file");
+    if (in) {
+      auto it = expected.find(entry->GetName(wxPATH_UNIX));
+      check(it != expected.end() && read_stream(*in) == it->second, "mapped entry has the expected contents");
+    }
+  }
+}
+
+/// Size of an entry in the file: local header, data, and data descriptor
+size_t entry_size(const std::string& data, const wxZipEntry& entry, bool check_descriptor) {
+  size_t pos = (size_t)entry.GetOffset();
+  size_t size = 30 + u16_at(data, pos + 26) + u16_at(data, pos + 28) + (size_t)entry.GetCompressedSize();
+  if (entry.GetFlags() & 8) {
+    if (check_descriptor) {
+      check(u32_at(data, pos + size)      == 0x08074b50, "data descriptor signature");
+      check(u32_at(data, pos + size + 4)  == entry.GetCrc(), "data descriptor crc");
+      check(u32_at(data, pos + size + 8)  == entry.GetCompressedSize(), "data descriptor compressed size");
+      check(u32_at(data, pos + size + 12) == entry.GetSize(), "data descriptor size");
+    }
+    size += 16;
+  }
+  return size;
+}
+
+/// Check the data descriptors of the entries that have one (those written by append)
+void check_data_descriptors(const String& filename, int expected_count) {
+  std::string data = read_file(filename);
+  int count = 0;
+  FOR_EACH(entry, read_entries(filename)) {
+    if (entry->GetFlags() & 8) {
+      entry_size(data, *entry, true);
+      ++count;
+    }
+  }
+  check(count == expected_count, "number of entries with a data descriptor");
+}
+
+/// Number of bytes in the file that are not used by the current entries
+size_t wasted_size(const String& filename) {
+  std::string data = read_file(filename);
+  size_t used = 0;
+  FOR_EACH(entry, read_entries(filename)) {
+    used += entry_size(data, *entry, false);
+  }
+  return data.size() - used;
+}
+
+/// Append to a zip file, replacing or adding the changed files and leaving out the removed ones
+/** Returns the result of append, if it is true the expected contents are updated.
+ */
+bool append(const String& filename, ZipContents& expected, const ZipContents& changed, const vector<String>& removed, double max_waste) {
+  vector<unique_ptr<wxZipEntry>> old_entries = read_entries(filename);
+  vector<ZipAppendEntry> entries;
+  vector<String> temp_files;
+  FOR_EACH(entry, old_entries) {
+    String name = entry->GetName(wxPATH_UNIX);
+    if (!changed.count(name) && find(removed.begin(), removed.end(), name) == removed.end()) {
+      entries.push_back(ZipAppendEntry{name, entry.get(), String()});
+    }
+  }
+  FOR_EACH_CONST(f, changed) {
+    String temp_file = wxFileName::CreateTempFileName(wxFileName::GetTempDir() + _("/mse-test-zip-entry"));
+    write_file(temp_file, f.second);
+    temp_files.push_back(temp_file);
+    entries.push_back(ZipAppendEntry{f.first, nullptr, temp_file});
+  }
+  bool ok = false;
+  {
+    MappedZipFileP mapped = MappedZipFile::open(filename);
+    check(!!mapped, "zip file can be mapped");
+    if (mapped) ok = mapped->append(filename, entries, max_waste);
+  }
+  FOR_EACH(f, temp_files) wxRemoveFile(f);
+  if (ok) {
+    FOR_EACH(name, removed) expected.erase(name);
+    FOR_EACH_CONST(f, changed) expected[f.first] = f.second;
+  }
+  return ok;
+}
+
+// ----------------------------------------------------------------------------- : Tests
+
+void check_append(const String& filename) {
+  // a zip file as written by wxZipOutputStream, the first entry is stored, the rest deflated
+  ZipContents expected;
+  expected[_("a.txt")]     = contents("a", 0, 3);
+  expected[_("b.txt")]     = contents("b", 0, 5000);
+  expected[_("dir/c.txt")] = contents("c", 0, 20);
+  expected[_("d.txt")]     = contents("d", 0, 100);
+  write_zip(filename, expected, true);
+  check_zip(filename, expected);
+  check_data_descriptors(filename, 0);
+
+  // replace, add and remove entries
+  check(append(filename, expected, {{_("b.txt"), contents("b", 1, 6000)}, {_("e.txt"), contents("e", 1, 50)}}, {_("d.txt")}, 1.0), "first append");
+  check_zip(filename, expected);
+  check_data_descriptors(filename, 2);
+
+  // replace the stored entry and one that was appended before, add one with a non-ascii name
+  check(append(filename, expected, {{_("a.txt"), contents("a", 2, 4)}, {_("e.txt"), contents("e", 2, 60)}, {wxString::FromUTF8("dir/\xC3\xBC.txt"), contents("u", 2, 7)}}, {}, 1.0), "second append");
+  check_zip(filename, expected);
+  check_data_descriptors(filename, 4);
+
+  // remove the largest entry, add an empty one
+  check(append(filename, expected, {{_("empty.txt"), std::string()}}, {_("b.txt")}, 1.0), "third append");
+  check_zip(filename, expected);
+  check_data_descriptors(filename, 4);
+
+  // compaction threshold: with nothing added, append refuses when more than max_waste of the file would be wasted.
+  // entries with a data descriptor must count it as used, otherwise the waste is overestimated by 16 bytes per entry
+  std::string before = read_file(filename);
+  double size = (double)before.size(), waste = (double)wasted_size(filename);
+  check(!append(filename, expected, {}, {}, (waste - 0.25) / size), "append with more waste than allowed");
+  check(read_file(filename) == before, "refused append doesn't change the file");
+  check(!append(filename, expected, {{_("a.txt"), contents("a", 3, 4)}}, {}, 0.0), "append with waste when none is allowed");
+  check(read_file(filename) == before, "refused append doesn't change the file");
+  check(append(filename, expected, {}, {}, (waste + 0.25) / size), "append with just less waste than allowed");
+  check_zip(filename, expected);
+  check_data_descriptors(filename, 4);
+}
+
+// ----------------------------------------------------------------------------- : Main
+
+int main() {
+  wxInitializer initializer;
+  String filename = wxFileName::CreateTempFileName(wxFileName::GetTempDir() + _("/mse-test-zip"));
+  check_append(filename);
+  wxRemoveFile(filename);
+  if (failures) {
+    printf("%d zip file checks failed\n", failures);
+    return 1;
+  }
+  printf("All zip file checks passed\n");
+  return 0;
+}